@@ -450,41 +450,60 @@ namespace std
     };
 
     /*!
-        Overloading the << operator 
+        Overloading the << operator, a failed stream (e.g. a filtered out log
+        message) skips the hex conversion
     */
     inline ostream &operator<<(ostream &os, const Crypto::Hash &hash)
     {
-        os << Common::podToHex(hash);
+        if (os) {
+            os << Common::podToHex(hash);
+        }
+
         return os;
     }
 
     inline ostream &operator<<(ostream &os, const Crypto::PublicKey &publicKey)
     {
-        os << Common::podToHex(publicKey);
+        if (os) {
+            os << Common::podToHex(publicKey);
+        }
+
         return os;
     }
 
     inline ostream &operator<<(ostream &os, const Crypto::SecretKey &secretKey)
     {
-        os << Common::podToHex(secretKey);
+        if (os) {
+            os << Common::podToHex(secretKey);
+        }
+
         return os;
     }
 
     inline ostream &operator<<(ostream &os, const Crypto::KeyDerivation &keyDerivation)
     {
-        os << Common::podToHex(keyDerivation);
+        if (os) {
+            os << Common::podToHex(keyDerivation);
+        }
+
         return os;
     }
 
     inline ostream &operator<<(ostream &os, const Crypto::KeyImage &keyImage)
     {
-        os << Common::podToHex(keyImage);
+        if (os) {
+            os << Common::podToHex(keyImage);
+        }
+
         return os;
     }
 
     inline ostream &operator<<(ostream &os, const Crypto::Signature &signature)
     {
-        os << Common::podToHex(signature);
+        if (os) {
+            os << Common::podToHex(signature);
+        }
+
         return os;
     }
 } // namespace std
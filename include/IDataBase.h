@@ -32,5 +32,21 @@ namespace CryptoNote {
 
         virtual std::error_code read(IReadBatch& batch) = 0;
         virtual std::error_code write(IWriteBatch& batch) = 0;
+
+        /*!
+            Bulk write mode for initial sync: while it is active, writes are appended
+            to one long running transaction which only becomes durable on
+            commitBulkWrite () or endBulkWrite (). Reads issued by the writing thread
+            see the pending data. Backends without support keep committing every write.
+        */
+        virtual void beginBulkWrite() {}
+        virtual void commitBulkWrite() {}
+        virtual void endBulkWrite() {}
+
+        /*!
+            Estimated room taken in the database by the writes since the last bulk
+            commit, 0 outside of bulk mode
+        */
+        virtual size_t getBulkWriteSize() const { return 0; }
     };
 } // namespace CryptoNote
@@ -346,6 +346,16 @@ namespace Common {
 
         void flush();
 
+        /*!
+            opens a group of updates, element and size writes inside it are
+            synced once by the matching commitGroup() instead of one msync
+            each. the commit also syncs the prefix, so prefix changes made in
+            the group land with it. groups nest, only the outermost commit syncs
+        */
+        void beginGroup();
+        void commitGroup();
+        bool inGroup() const;
+
         const uint8_t *prefix() const;
         uint8_t *prefix();
         uint64_t prefixSize() const;
@@ -370,6 +380,8 @@ namespace Common {
         uint64_t m_prefixSize;
         uint64_t m_suffixSize;
         bool m_autoFlush;
+        uint64_t m_groupDepth;
+        uint64_t m_dirtyEnd;
 
     private:
         template<class F>
@@ -409,6 +421,9 @@ namespace Common {
 
         uint64_t nextCapacity();
 
+        bool growInPlace(uint64_t newCapacity);
+
+        void flushRange(const void *data, uint64_t size);
         void flushElement(uint64_t index);
         void flushSize();
     };
@@ -416,7 +431,9 @@ namespace Common {
     template<class T>
     FileMappedVector<T>::FileMappedVector()
         :
-        m_autoFlush (true)
+        m_autoFlush (true),
+        m_groupDepth (0),
+        m_dirtyEnd (0)
     {
     }
 
@@ -425,7 +442,9 @@ namespace Common {
         const std::string &path,
         FileMappedVectorOpenMode mode,
         uint64_t prefixSize)
-        : m_autoFlush (true)
+        : m_autoFlush (true),
+          m_groupDepth (0),
+          m_dirtyEnd (0)
     {
         open (path, mode, prefixSize);
     }
@@ -528,7 +547,7 @@ namespace Common {
     {
         assert(isOpened ());
 
-        if (n > capacity ()) {
+        if (n > capacity () && !growInPlace (n)) {
             atomicUpdate (size (), n, prefixSize (), suffixSize (), [this](value_type *target)
             {
                 std::copy (cbegin (), cend (), target);
@@ -710,6 +729,16 @@ namespace Common {
 
         uint64_t newSize = size () - std::distance (first, last);
 
+        /*!
+            dropping the tail only needs the size written
+        */
+        if (last == cend ()) {
+            *sizePtr () = newSize;
+            flushSize ();
+
+            return iterator (this, first.index ());
+        }
+
         atomicUpdate (newSize,
                       capacity (),
                       prefixSize (),
@@ -741,6 +770,25 @@ namespace Common {
         assert(isOpened ());
 
         uint64_t newSize = size () + static_cast<uint64_t>(std::distance (first, last));
+
+        /*!
+            appending writes the new elements past the end and then the size,
+            growing the file in place when it can
+        */
+        if (position == cend ()) {
+            const uint64_t index = position.index ();
+            if (newSize > capacity ()) {
+                reserve (std::max (newSize, nextCapacity ()));
+            }
+
+            std::copy (first, last, vectorDataPtr () + index);
+            flushRange (vectorDataPtr () + index, (newSize - index) * valueSize);
+            *sizePtr () = newSize;
+            flushSize ();
+
+            return iterator (this, index);
+        }
+
         uint64_t newCapacity;
         if (newSize > capacity ()) {
             newCapacity = nextCapacity ();
@@ -817,6 +865,39 @@ namespace Common {
         assert(isOpened ());
 
         m_file.flush (m_file.data (), m_file.size ());
+        m_dirtyEnd = 0;
+    }
+
+    template<class T>
+    void FileMappedVector<T>::beginGroup()
+    {
+        assert(isOpened ());
+
+        ++m_groupDepth;
+    }
+
+    template<class T>
+    void FileMappedVector<T>::commitGroup()
+    {
+        assert(isOpened ());
+        assert(m_groupDepth > 0);
+
+        if (--m_groupDepth != 0) {
+            return;
+        }
+
+        /*!
+            everything written in the group lies between the start of the
+            file and m_dirtyEnd
+        */
+        m_file.flush (m_file.data (), std::max (m_dirtyEnd, prefixSize () + metadataSize));
+        m_dirtyEnd = 0;
+    }
+
+    template<class T>
+    bool FileMappedVector<T>::inGroup() const
+    {
+        return m_groupDepth > 0;
     }
 
     template<class T>
@@ -1007,6 +1088,11 @@ namespace Common {
 
         m_path = bakPath.string ();
         swap (tmpVector);
+
+        /*!
+            the new file was synced as a whole
+        */
+        m_dirtyEnd = 0;
         tmpFileDeleter.cancel ();
 
         // Remove .bak file and ignore errors
@@ -1126,18 +1212,58 @@ namespace Common {
     }
 
     template<class T>
-    void FileMappedVector<T>::flushElement(uint64_t index)
+    bool FileMappedVector<T>::growInPlace(uint64_t newCapacity)
     {
-        if (m_autoFlush) {
-            m_file.flush (reinterpret_cast<uint8_t *>(vectorDataPtr () + index), valueSize);
+        /*!
+            with a suffix behind the elements it would have to be moved after
+            the resize, so that case keeps the copy and rename. without one
+            the only window is between the resize and the capacity write, a
+            crash there leaves the added zeroed space read back as a suffix
+        */
+        if (suffixSize () != 0 || m_file.path () != m_path) {
+            return false;
         }
+
+        std::error_code ec;
+        m_file.resize (prefixSize () + metadataSize + newCapacity * valueSize, ec);
+        if (ec) {
+            /*!
+                a failed resize keeps the old mapping, unless even that could not
+                be restored. the copy fallback needs it, so give up then
+            */
+            if (!m_file.isOpened ()) {
+                throw std::system_error (ec, "FileMappedVector::growInPlace");
+            }
+
+            return false;
+        }
+
+        *capacityPtr () = newCapacity;
+        flushRange (capacityPtr (), sizeof (uint64_t));
+
+        return true;
     }
 
     template<class T>
-    void FileMappedVector<T>::flushSize()
+    void FileMappedVector<T>::flushRange(const void *data, uint64_t size)
     {
-        if (m_autoFlush) {
-            m_file.flush (reinterpret_cast<uint8_t *>(sizePtr ()), sizeof (uint64_t));
+        if (inGroup ()) {
+            const uint64_t offset = static_cast<uint64_t>(reinterpret_cast<const uint8_t *>(data) - m_file.data ());
+            m_dirtyEnd = std::max (m_dirtyEnd, offset + size);
+        } else if (m_autoFlush) {
+            m_file.flush (reinterpret_cast<uint8_t *>(const_cast<void *>(data)), size);
         }
     }
+
+    template<class T>
+    void FileMappedVector<T>::flushElement(uint64_t index)
+    {
+        flushRange (vectorDataPtr () + index, valueSize);
+    }
+
+    template<class T>
+    void FileMappedVector<T>::flushSize()
+    {
+        flushRange (sizePtr (), sizeof (uint64_t));
+    }
 } // namespace Common
@@ -0,0 +1,319 @@
+// Copyright (c) 2018-2020, The Qwertycoin Project
+//
+// This file is part of Qwertycoin.
+//
+// Qwertycoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Qwertycoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Qwertycoin.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+#include <Common/Metrics.h>
+
+namespace Metrics {
+
+    namespace {
+
+        std::string escapeLabelValue(const std::string &value)
+        {
+            std::string result;
+            result.reserve (value.size ());
+
+            for (const char c : value) {
+                if (c == '\\' || c == '"') {
+                    result += '\\';
+                    result += c;
+                } else if (c == '\n') {
+                    result += "\\n";
+                } else {
+                    result += c;
+                }
+            }
+
+            return result;
+        }
+
+        /*!
+            label set of a sample, extra is an already formatted label like le="1"
+        */
+        std::string formatLabels(const std::string &label,
+                                 const std::string &labelValue,
+                                 const std::string &extra = "")
+        {
+            std::string labels;
+
+            if (!label.empty ()) {
+                labels += label + "=\"" + escapeLabelValue (labelValue) + "\"";
+            }
+
+            if (!extra.empty ()) {
+                labels += (labels.empty () ? "" : ",") + extra;
+            }
+
+            return labels.empty () ? "" : "{" + labels + "}";
+        }
+
+    } // namespace
+
+    void Counter::inc(uint64_t value)
+    {
+        m_value.fetch_add (value, std::memory_order_relaxed);
+    }
+
+    uint64_t Counter::value() const
+    {
+        return m_value.load (std::memory_order_relaxed);
+    }
+
+    void Gauge::set(int64_t value)
+    {
+        m_value.store (value, std::memory_order_relaxed);
+    }
+
+    void Gauge::add(int64_t value)
+    {
+        m_value.fetch_add (value, std::memory_order_relaxed);
+    }
+
+    int64_t Gauge::value() const
+    {
+        return m_value.load (std::memory_order_relaxed);
+    }
+
+    Histogram::Histogram()
+        : m_count (0),
+          m_sumMicroseconds (0)
+    {
+        for (auto &bucket : m_buckets) {
+            bucket.store (0, std::memory_order_relaxed);
+        }
+    }
+
+    uint64_t Histogram::bucketUpperBound(size_t index)
+    {
+        if (index < SUB_BUCKET_COUNT) {
+            return index + 1;
+        }
+
+        const size_t exponent = SUB_BUCKET_BITS + (index - SUB_BUCKET_COUNT) / SUB_BUCKET_COUNT;
+        const uint64_t subBucket = (index - SUB_BUCKET_COUNT) % SUB_BUCKET_COUNT;
+
+        return (uint64_t (1) << exponent) + ((subBucket + 1) << (exponent - SUB_BUCKET_BITS));
+    }
+
+    size_t Histogram::bucketIndex(uint64_t microseconds)
+    {
+        if (microseconds <= SUB_BUCKET_COUNT) {
+            return microseconds == 0 ? 0 : static_cast<size_t>(microseconds - 1);
+        }
+
+        /*!
+            buckets are inclusive at the top, so (2^e, 2^(e+1)] is split by the bits
+            of value - 1 below its highest one
+        */
+        const uint64_t value = microseconds - 1;
+        size_t exponent = SUB_BUCKET_BITS;
+        while (exponent < MAX_EXPONENT && (value >> (exponent + 1)) != 0) {
+            ++exponent;
+        }
+
+        if ((value >> (exponent + 1)) != 0) {
+            return BUCKET_COUNT - 1;
+        }
+
+        const size_t subBucket = static_cast<size_t>(value >> (exponent - SUB_BUCKET_BITS)) & (SUB_BUCKET_COUNT - 1);
+
+        return SUB_BUCKET_COUNT + (exponent - SUB_BUCKET_BITS) * SUB_BUCKET_COUNT + subBucket;
+    }
+
+    void Histogram::observe(std::chrono::microseconds duration)
+    {
+        const uint64_t value = duration.count () > 0 ? static_cast<uint64_t>(duration.count ()) : 0;
+
+        m_buckets[bucketIndex (value)].fetch_add (1, std::memory_order_relaxed);
+        m_sumMicroseconds.fetch_add (value, std::memory_order_relaxed);
+        m_count.fetch_add (1, std::memory_order_relaxed);
+    }
+
+    void Histogram::snapshot(std::array<uint64_t, BUCKET_COUNT> &buckets,
+                             uint64_t &count,
+                             uint64_t &sumMicroseconds) const
+    {
+        count = m_count.load (std::memory_order_relaxed);
+        sumMicroseconds = m_sumMicroseconds.load (std::memory_order_relaxed);
+
+        for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+            buckets[i] = m_buckets[i].load (std::memory_order_relaxed);
+        }
+    }
+
+    ScopedTimer::ScopedTimer(Histogram &histogram)
+        : m_histogram (histogram),
+          m_start (std::chrono::steady_clock::now ())
+    {
+    }
+
+    ScopedTimer::~ScopedTimer()
+    {
+        m_histogram.observe (std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now () - m_start));
+    }
+
+    Registry &Registry::instance()
+    {
+        static Registry registry;
+        return registry;
+    }
+
+    Registry::Family &Registry::getFamily(const std::string &name,
+                                          const std::string &help,
+                                          Type type,
+                                          const std::string &label)
+    {
+        auto it = m_families.find (name);
+        if (it == m_families.end ()) {
+            auto &family = m_families[name];
+            family.type = type;
+            family.help = help;
+            family.label = label;
+            return family;
+        }
+
+        if (it->second.type != type || it->second.label != label) {
+            throw std::invalid_argument ("Metric " + name + " is already registered with another type or label");
+        }
+
+        return it->second;
+    }
+
+    Counter &Registry::counter(const std::string &name,
+                               const std::string &help,
+                               const std::string &label,
+                               const std::string &labelValue)
+    {
+        std::lock_guard<std::mutex> lock (m_mutex);
+        return getFamily (name, help, Type::Counter, label).counters[labelValue];
+    }
+
+    Gauge &Registry::gauge(const std::string &name,
+                           const std::string &help,
+                           const std::string &label,
+                           const std::string &labelValue)
+    {
+        std::lock_guard<std::mutex> lock (m_mutex);
+        return getFamily (name, help, Type::Gauge, label).gauges[labelValue];
+    }
+
+    Histogram &Registry::histogram(const std::string &name,
+                                   const std::string &help,
+                                   const std::string &label,
+                                   const std::string &labelValue)
+    {
+        std::lock_guard<std::mutex> lock (m_mutex);
+        return getFamily (name, help, Type::Histogram, label).histograms[labelValue];
+    }
+
+    std::string Registry::toPrometheus() const
+    {
+        std::lock_guard<std::mutex> lock (m_mutex);
+
+        std::ostringstream stream;
+        stream << std::setprecision (10);
+
+        for (const auto &entry : m_families) {
+            const std::string &name = entry.first;
+            const Family &family = entry.second;
+
+            stream << "# HELP " << name << " " << family.help << "\n";
+
+            switch (family.type) {
+                case Type::Counter: {
+                    stream << "# TYPE " << name << " counter\n";
+                    for (const auto &counter : family.counters) {
+                        stream << name
+                               << formatLabels (family.label, counter.first)
+                               << " "
+                               << counter.second.value ()
+                               << "\n";
+                    }
+                    break;
+                }
+                case Type::Gauge: {
+                    stream << "# TYPE " << name << " gauge\n";
+                    for (const auto &gauge : family.gauges) {
+                        stream << name
+                               << formatLabels (family.label, gauge.first)
+                               << " "
+                               << gauge.second.value ()
+                               << "\n";
+                    }
+                    break;
+                }
+                case Type::Histogram: {
+                    stream << "# TYPE " << name << " histogram\n";
+                    for (const auto &histogram : family.histograms) {
+                        std::array<uint64_t, Histogram::BUCKET_COUNT> buckets;
+                        uint64_t count;
+                        uint64_t sumMicroseconds;
+                        histogram.second.snapshot (buckets, count, sumMicroseconds);
+
+                        /*!
+                            prometheus buckets are cumulative and in seconds, the last
+                            bucket is reported as +Inf together with the total count
+                        */
+                        uint64_t cumulative = 0;
+                        for (size_t i = 0; i < Histogram::BUCKET_COUNT - 1; ++i) {
+                            cumulative += buckets[i];
+
+                            std::ostringstream le;
+                            le << std::setprecision (10);
+                            le << "le=\"" << static_cast<double>(Histogram::bucketUpperBound (i)) / 1000000 << "\"";
+
+                            stream << name
+                                   << "_bucket"
+                                   << formatLabels (family.label, histogram.first, le.str ())
+                                   << " "
+                                   << cumulative
+                                   << "\n";
+                        }
+
+                        stream << name
+                               << "_bucket"
+                               << formatLabels (family.label, histogram.first, "le=\"+Inf\"")
+                               << " "
+                               << std::max (count, cumulative + buckets[Histogram::BUCKET_COUNT - 1])
+                               << "\n";
+                        stream << name
+                               << "_sum"
+                               << formatLabels (family.label, histogram.first)
+                               << " "
+                               << static_cast<double>(sumMicroseconds) / 1000000
+                               << "\n";
+                        stream << name
+                               << "_count"
+                               << formatLabels (family.label, histogram.first)
+                               << " "
+                               << std::max (count, cumulative + buckets[Histogram::BUCKET_COUNT - 1])
+                               << "\n";
+                    }
+                    break;
+                }
+            }
+        }
+
+        return stream.str ();
+    }
+} // namespace Metrics
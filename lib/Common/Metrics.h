@@ -0,0 +1,184 @@
+// Copyright (c) 2018-2020, The Qwertycoin Project
+//
+// This file is part of Qwertycoin.
+//
+// Qwertycoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Qwertycoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Qwertycoin.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+
+/*!
+    Process wide counters, gauges and latency histograms for the hot paths,
+    exported in the Prometheus text format. Updating a metric is a couple of
+    relaxed atomic operations and never takes a lock, only looking a metric up
+    in the registry does. Metrics with a fixed label should therefore keep the
+    returned reference, e.g. in a function local static.
+*/
+namespace Metrics {
+
+    class Counter
+    {
+    public:
+        Counter() = default;
+
+        Counter(const Counter &) = delete;
+        Counter &operator=(const Counter &) = delete;
+
+        void inc(uint64_t value = 1);
+        uint64_t value() const;
+
+    private:
+        std::atomic<uint64_t> m_value {0};
+    };
+
+    class Gauge
+    {
+    public:
+        Gauge() = default;
+
+        Gauge(const Gauge &) = delete;
+        Gauge &operator=(const Gauge &) = delete;
+
+        void set(int64_t value);
+        void add(int64_t value);
+        int64_t value() const;
+
+    private:
+        std::atomic<int64_t> m_value {0};
+    };
+
+    /*!
+        Latency histogram laid out like an HDR histogram with two significant bits:
+        1 to 4us get a bucket each, every further power of two is split in four
+        linear sub buckets, so a bucket is at most 25% wider than the values in it.
+        The buckets go up to 2^25us, about 33s, the last one takes everything slower.
+    */
+    class Histogram
+    {
+    public:
+        static constexpr size_t SUB_BUCKET_BITS = 2;
+        static constexpr size_t SUB_BUCKET_COUNT = size_t (1) << SUB_BUCKET_BITS;
+        static constexpr size_t MAX_EXPONENT = 25;
+        static constexpr size_t BUCKET_COUNT = SUB_BUCKET_COUNT * (MAX_EXPONENT - SUB_BUCKET_BITS + 1) + 1;
+
+        Histogram();
+
+        /*!
+            inclusive upper bound in microseconds of a bucket but the last one
+        */
+        static uint64_t bucketUpperBound(size_t index);
+
+        static size_t bucketIndex(uint64_t microseconds);
+
+        Histogram(const Histogram &) = delete;
+        Histogram &operator=(const Histogram &) = delete;
+
+        void observe(std::chrono::microseconds duration);
+
+        /*!
+            buckets are not cumulative and may be a few observations ahead of
+            count and sum when read while other threads observe
+        */
+        void snapshot(std::array<uint64_t, BUCKET_COUNT> &buckets,
+                      uint64_t &count,
+                      uint64_t &sumMicroseconds) const;
+
+    private:
+        std::array<std::atomic<uint64_t>, BUCKET_COUNT> m_buckets;
+        std::atomic<uint64_t> m_count;
+        std::atomic<uint64_t> m_sumMicroseconds;
+    };
+
+    /*!
+        observes the lifetime of the timer into a histogram
+    */
+    class ScopedTimer
+    {
+    public:
+        explicit ScopedTimer(Histogram &histogram);
+        ~ScopedTimer();
+
+        ScopedTimer(const ScopedTimer &) = delete;
+        ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+    private:
+        Histogram &m_histogram;
+        std::chrono::steady_clock::time_point m_start;
+    };
+
+    /*!
+        A metric family is a name with its help text, type and at most one label.
+        Asking for an existing name with another type or label throws
+        std::invalid_argument. Metrics are never removed, so label values must
+        come from a bounded set.
+    */
+    class Registry
+    {
+    public:
+        static Registry &instance();
+
+        Counter &counter(const std::string &name,
+                         const std::string &help,
+                         const std::string &label = "",
+                         const std::string &labelValue = "");
+
+        Gauge &gauge(const std::string &name,
+                     const std::string &help,
+                     const std::string &label = "",
+                     const std::string &labelValue = "");
+
+        Histogram &histogram(const std::string &name,
+                             const std::string &help,
+                             const std::string &label = "",
+                             const std::string &labelValue = "");
+
+        std::string toPrometheus() const;
+
+    private:
+        enum class Type
+        {
+            Counter,
+            Gauge,
+            Histogram
+        };
+
+        struct Family
+        {
+            Type type;
+            std::string help;
+            std::string label;
+            std::map<std::string, Counter> counters;
+            std::map<std::string, Gauge> gauges;
+            std::map<std::string, Histogram> histograms;
+        };
+
+        Registry() = default;
+
+        Family &getFamily(const std::string &name,
+                          const std::string &help,
+                          Type type,
+                          const std::string &label);
+
+        mutable std::mutex m_mutex;
+        std::map<std::string, Family> m_families;
+    };
+} // namespace Metrics
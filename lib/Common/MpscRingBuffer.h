@@ -0,0 +1,141 @@
+// Copyright (c) 2018-2020, The Qwertycoin Project
+//
+// This file is part of Qwertycoin.
+//
+// Qwertycoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Qwertycoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Qwertycoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+/*!
+    Bounded lock-free queue for many producers and a single consumer. Every
+    cell carries a sequence number telling whether it is free for the push
+    at that position or holds the value for the pop at that position, so
+    producers only contend on the enqueue counter and never block. A push
+    into a full buffer fails instead of waiting.
+*/
+template<typename T>
+class MpscRingBuffer
+{
+public:
+    /*!
+        capacity is rounded up to a power of two
+    */
+    explicit MpscRingBuffer(size_t capacity)
+        : m_mask (roundUpToPowerOfTwo (capacity) - 1),
+          m_cells (new Cell[m_mask + 1]),
+          m_enqueuePos (0),
+          m_dequeuePos (0)
+    {
+        for (size_t i = 0; i <= m_mask; ++i) {
+            m_cells[i].sequence.store (i, std::memory_order_relaxed);
+        }
+    }
+
+    MpscRingBuffer(const MpscRingBuffer &) = delete;
+    MpscRingBuffer &operator=(const MpscRingBuffer &) = delete;
+
+    /*!
+        any thread, value is only moved from when the push succeeds
+    */
+    bool tryPush(T &&value)
+    {
+        Cell *cell;
+        size_t pos = m_enqueuePos.load (std::memory_order_relaxed);
+
+        for (;;) {
+            cell = &m_cells[pos & m_mask];
+            const size_t sequence = cell->sequence.load (std::memory_order_acquire);
+            const intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+
+            if (diff == 0) {
+                if (m_enqueuePos.compare_exchange_weak (pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = m_enqueuePos.load (std::memory_order_relaxed);
+            }
+        }
+
+        cell->value = std::move (value);
+        cell->sequence.store (pos + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    /*!
+        consumer thread only
+    */
+    bool tryPop(T &value)
+    {
+        const size_t pos = m_dequeuePos.load (std::memory_order_relaxed);
+        Cell &cell = m_cells[pos & m_mask];
+        const size_t sequence = cell.sequence.load (std::memory_order_acquire);
+
+        if (static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1) < 0) {
+            return false;
+        }
+
+        value = std::move (cell.value);
+        cell.sequence.store (pos + m_mask + 1, std::memory_order_release);
+        m_dequeuePos.store (pos + 1, std::memory_order_relaxed);
+
+        return true;
+    }
+
+    /*!
+        approximate while pushes and pops are in flight
+    */
+    size_t size() const
+    {
+        const size_t enqueuePos = m_enqueuePos.load (std::memory_order_relaxed);
+        const size_t dequeuePos = m_dequeuePos.load (std::memory_order_relaxed);
+
+        return enqueuePos > dequeuePos ? enqueuePos - dequeuePos : 0;
+    }
+
+    size_t capacity() const
+    {
+        return m_mask + 1;
+    }
+
+private:
+    struct Cell
+    {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    static size_t roundUpToPowerOfTwo(size_t value)
+    {
+        size_t result = 2;
+        while (result < value) {
+            result <<= 1;
+        }
+
+        return result;
+    }
+
+    const size_t m_mask;
+    std::unique_ptr<Cell[]> m_cells;
+
+    alignas(64) std::atomic<size_t> m_enqueuePos;
+    alignas(64) std::atomic<size_t> m_dequeuePos;
+};
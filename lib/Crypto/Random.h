@@ -19,8 +19,16 @@
 
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <functional>
 #include <limits>
 #include <random>
+#include <vector>
+
+extern "C" void keccakf(uint64_t st[25], int norounds);
 
 namespace Random {
     /*!
@@ -29,9 +37,61 @@ namespace Random {
     static thread_local std::random_device device;
 
     /*!
-        Generator, seeded with the random device 
+        Seeds every word of the generator state from the random device, a single
+        32 bit seed would leave only 2^32 possible output streams per thread
+    */
+    inline std::mt19937 seededGenerator()
+    {
+        std::array<uint32_t, std::mt19937::state_size> seed;
+        std::generate (seed.begin (), seed.end (), std::ref (device));
+        std::seed_seq sequence (seed.begin (), seed.end ());
+        return std::mt19937 (sequence);
+    }
+
+    /*!
+        Generator for shuffles and other non secret values, seeded with the random
+        device. Key material comes from randomBytes instead, the state of a mersenne
+        twister can be recovered from its output.
     */
-    static thread_local std::mt19937 gen (device ());
+    static thread_local std::mt19937 gen = seededGenerator ();
+
+    /*!
+        Keccak sponge like the generator of the original CryptoNote code. The
+        whole 1600 bit state is filled from the random device, after every
+        permutation only the first 136 bytes are handed out and the remaining
+        512 bits never leave the state, so the output can't be used to predict
+        what comes next.
+    */
+    class KeccakGenerator
+    {
+    public:
+        KeccakGenerator()
+        {
+            for (auto &word : m_state) {
+                word = (static_cast<uint64_t>(device ()) << 32) | device ();
+            }
+        }
+
+        void generate(size_t n, uint8_t *result)
+        {
+            while (n > 0) {
+                keccakf (m_state, 24);
+
+                const size_t chunk = std::min (n, RATE);
+                std::memcpy (result, m_state, chunk);
+
+                result += chunk;
+                n -= chunk;
+            }
+        }
+
+    private:
+        static constexpr size_t RATE = 136;
+
+        uint64_t m_state[25];
+    };
+
+    static thread_local KeccakGenerator secureGenerator;
 
     /*!
         The distribution to get numbers for - in this case, uint8_t 
@@ -39,28 +99,22 @@ namespace Random {
     static std::uniform_int_distribution<int> distribution{0, (std::numeric_limits<uint8_t>::max) ()};
 
     /*!
-        Generate n random bytes (uint8_t), and place them in *result. Result should be large
+        Generate n secure random bytes (uint8_t), and place them in *result. Result should be large
         enough to contain the bytes.
     */
     inline void randomBytes(size_t n, uint8_t *result)
     {
-        for (size_t i = 0; i < n; i++) {
-            result[i] = distribution (gen);
-        }
+        secureGenerator.generate (n, result);
     }
 
     /*!
-        Generate n random bytes (uint8_t), and return them in a vector.
+        Generate n secure random bytes (uint8_t), and return them in a vector.
     */
     inline std::vector<uint8_t> randomBytes(size_t n)
     {
-        std::vector<uint8_t> result;
+        std::vector<uint8_t> result (n);
 
-        result.reserve (n);
-
-        for (size_t i = 0; i < n; i++) {
-            result.push_back (distribution (gen));
-        }
+        secureGenerator.generate (n, result.data ());
 
         return result;
     }
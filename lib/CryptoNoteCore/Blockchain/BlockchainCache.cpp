@@ -1130,6 +1130,10 @@ namespace CryptoNote {
         serialize (s);
     }
 
+    void BlockchainCache::setBulkSyncMode(bool /*enable*/)
+    {
+    }
+
     bool BlockchainCache::isTransactionSpendTimeUnlocked(uint64_t unlockTime) const
     {
         return isTransactionSpendTimeUnlocked (unlockTime, getTopBlockIndex ());
@@ -223,6 +223,11 @@ namespace CryptoNote {
         virtual void save() override;
         virtual void load() override;
 
+        /*!
+            This method does nothing, the cache lives in memory only
+        */
+        virtual void setBulkSyncMode(bool enable) override;
+
         virtual std::vector<BinaryArray>
         getRawTransactions(const std::vector<Crypto::Hash> &transactions,
                            std::vector<Crypto::Hash> &missedTransactions) const override;
@@ -141,6 +141,12 @@ BlockchainReadBatch &BlockchainReadBatch::requestKeyOutputAmountsCount()
     return *this;
 }
 
+BlockchainReadBatch &BlockchainReadBatch::requestKeyOutputAmount(uint32_t amountId)
+{
+    state.keyOutputAmounts.emplace (amountId, 0);
+    return *this;
+}
+
 BlockchainReadBatch &BlockchainReadBatch::requestTransactionCountByPaymentId(const Crypto::Hash &paymentId)
 {
     state.transactionCountsByPaymentIds.emplace (paymentId, 0);
@@ -179,12 +185,66 @@ BlockchainReadBatch::requestKeyOutputInfo(IBlockchainCache::Amount amount,
     return *this;
 }
 
+BlockchainReadBatch &
+BlockchainReadBatch::requestKeyOutputBlockCountsCountForAmount(IBlockchainCache::Amount amount)
+{
+    state.keyOutputBlockCountsCountForAmounts.emplace (amount, 0);
+    return *this;
+}
+
+BlockchainReadBatch &
+BlockchainReadBatch::requestKeyOutputBlockCountForAmount(IBlockchainCache::Amount amount,
+                                                         uint32_t entryIndexWithinAmount)
+{
+    state.keyOutputBlockCountsForAmounts.emplace (std::make_pair (amount,
+                                                                  entryIndexWithinAmount),
+                                                  KeyOutputBlockCount{});
+    return *this;
+}
+
+BlockchainReadBatch &
+BlockchainReadBatch::requestLockedKeyOutputsCountForAmount(IBlockchainCache::Amount amount)
+{
+    state.lockedKeyOutputsCountForAmounts.emplace (amount, 0);
+    return *this;
+}
+
+BlockchainReadBatch &
+BlockchainReadBatch::requestLockedKeyOutputForAmount(IBlockchainCache::Amount amount,
+                                                     uint32_t entryIndexWithinAmount)
+{
+    state.lockedKeyOutputsForAmounts.emplace (std::make_pair (amount,
+                                                              entryIndexWithinAmount),
+                                              LockedKeyOutput{});
+    return *this;
+}
+
+BlockchainReadBatch &BlockchainReadBatch::requestSpentKeyImageFilter()
+{
+    state.spentKeyImageFilter.second = true;
+    return *this;
+}
+
+BlockchainReadBatch &BlockchainReadBatch::requestNonEmptyBlocksCount()
+{
+    state.nonEmptyBlocksCount.second = true;
+    return *this;
+}
+
+BlockchainReadBatch &BlockchainReadBatch::requestNonEmptyBlockIndex(uint32_t entryIndex)
+{
+    state.nonEmptyBlockIndexes.emplace (entryIndex, 0);
+    return *this;
+}
+
 BlockchainReadResult BlockchainReadBatch::extractResult()
 {
     assert(resultSubmitted);
     auto st = std::move (state);
     state.lastBlockIndex = {0, false};
     state.keyOutputAmountsCount = {{}, false};
+    state.spentKeyImageFilter = {{}, false};
+    state.nonEmptyBlocksCount = {0, false};
 
     resultSubmitted = false;
     return BlockchainReadResult (st);
@@ -240,6 +300,21 @@ std::vector<std::string> BlockchainReadBatch::getRawKeys() const
     DB::serializeKeys (rawKeys,
                        DB::KEY_OUTPUT_KEY_PREFIX,
                        state.keyOutputKeys);
+    DB::serializeKeys (rawKeys,
+                       DB::KEY_OUTPUT_AMOUNT_BLOCK_COUNT_PREFIX,
+                       state.keyOutputBlockCountsCountForAmounts);
+    DB::serializeKeys (rawKeys,
+                       DB::KEY_OUTPUT_AMOUNT_BLOCK_COUNT_PREFIX,
+                       state.keyOutputBlockCountsForAmounts);
+    DB::serializeKeys (rawKeys,
+                       DB::KEY_OUTPUT_AMOUNT_LOCKED_PREFIX,
+                       state.lockedKeyOutputsCountForAmounts);
+    DB::serializeKeys (rawKeys,
+                       DB::KEY_OUTPUT_AMOUNT_LOCKED_PREFIX,
+                       state.lockedKeyOutputsForAmounts);
+    DB::serializeKeys (rawKeys,
+                       DB::NON_EMPTY_BLOCK_INDEX_PREFIX,
+                       state.nonEmptyBlockIndexes);
 
     if (state.lastBlockIndex.second) {
         rawKeys.emplace_back (DB::serializeKey (DB::BLOCK_INDEX_TO_BLOCK_HASH_PREFIX,
@@ -256,6 +331,16 @@ std::vector<std::string> BlockchainReadBatch::getRawKeys() const
                                                 DB::TRANSACTIONS_COUNT_KEY));
     }
 
+    if (state.spentKeyImageFilter.second) {
+        rawKeys.emplace_back (DB::serializeKey (DB::KEY_IMAGE_TO_BLOCK_INDEX_PREFIX,
+                                                DB::SPENT_KEY_IMAGE_FILTER_KEY));
+    }
+
+    if (state.nonEmptyBlocksCount.second) {
+        rawKeys.emplace_back (DB::serializeKey (DB::NON_EMPTY_BLOCK_INDEX_PREFIX,
+                                                DB::NON_EMPTY_BLOCKS_COUNT_KEY));
+    }
+
     assert(!rawKeys.empty ());
     return rawKeys;
 }
@@ -341,6 +426,11 @@ uint32_t BlockchainReadResult::getKeyOutputAmountsCount() const
     return state.keyOutputAmountsCount.first;
 }
 
+const std::unordered_map<uint32_t, IBlockchainCache::Amount> &BlockchainReadResult::getKeyOutputAmounts() const
+{
+    return state.keyOutputAmounts;
+}
+
 const std::unordered_map<Crypto::Hash, uint32_t> &
 BlockchainReadResult::getTransactionCountByPaymentIds() const
 {
@@ -369,6 +459,47 @@ const KeyOutputKeyResult &BlockchainReadResult::getKeyOutputInfo() const
     return state.keyOutputKeys;
 }
 
+const std::unordered_map<IBlockchainCache::Amount, uint32_t> &
+BlockchainReadResult::getKeyOutputBlockCountsCountForAmounts() const
+{
+    return state.keyOutputBlockCountsCountForAmounts;
+}
+
+const std::unordered_map<std::pair<IBlockchainCache::Amount,
+                                   uint32_t>, KeyOutputBlockCount> &
+BlockchainReadResult::getKeyOutputBlockCountsForAmounts() const
+{
+    return state.keyOutputBlockCountsForAmounts;
+}
+
+const std::unordered_map<IBlockchainCache::Amount, uint32_t> &
+BlockchainReadResult::getLockedKeyOutputsCountForAmounts() const
+{
+    return state.lockedKeyOutputsCountForAmounts;
+}
+
+const std::unordered_map<std::pair<IBlockchainCache::Amount,
+                                   uint32_t>, LockedKeyOutput> &
+BlockchainReadResult::getLockedKeyOutputsForAmounts() const
+{
+    return state.lockedKeyOutputsForAmounts;
+}
+
+const std::pair<SpentKeyImageFilter, bool> &BlockchainReadResult::getSpentKeyImageFilter() const
+{
+    return state.spentKeyImageFilter;
+}
+
+const std::unordered_map<uint32_t, uint32_t> &BlockchainReadResult::getNonEmptyBlockIndexes() const
+{
+    return state.nonEmptyBlockIndexes;
+}
+
+const std::pair<uint32_t, bool> &BlockchainReadResult::getNonEmptyBlocksCount() const
+{
+    return state.nonEmptyBlocksCount;
+}
+
 void BlockchainReadBatch::submitRawResult(const std::vector<std::string> &values,
                                           const std::vector<bool> &resultStates)
 {
@@ -422,6 +553,21 @@ void BlockchainReadBatch::submitRawResult(const std::vector<std::string> &values
     DB::deserializeValues (state.keyOutputKeys,
                            iter,
                            DB::KEY_OUTPUT_KEY_PREFIX);
+    DB::deserializeValues (state.keyOutputBlockCountsCountForAmounts,
+                           iter,
+                           DB::KEY_OUTPUT_AMOUNT_BLOCK_COUNT_PREFIX);
+    DB::deserializeValues (state.keyOutputBlockCountsForAmounts,
+                           iter,
+                           DB::KEY_OUTPUT_AMOUNT_BLOCK_COUNT_PREFIX);
+    DB::deserializeValues (state.lockedKeyOutputsCountForAmounts,
+                           iter,
+                           DB::KEY_OUTPUT_AMOUNT_LOCKED_PREFIX);
+    DB::deserializeValues (state.lockedKeyOutputsForAmounts,
+                           iter,
+                           DB::KEY_OUTPUT_AMOUNT_LOCKED_PREFIX);
+    DB::deserializeValues (state.nonEmptyBlockIndexes,
+                           iter,
+                           DB::NON_EMPTY_BLOCK_INDEX_PREFIX);
 
     DB::deserializeValue (state.lastBlockIndex,
                           iter,
@@ -432,6 +578,12 @@ void BlockchainReadBatch::submitRawResult(const std::vector<std::string> &values
     DB::deserializeValue (state.transactionsCount,
                           iter,
                           DB::TRANSACTION_HASH_TO_TRANSACTION_INFO_PREFIX);
+    DB::deserializeValue (state.spentKeyImageFilter,
+                          iter,
+                          DB::KEY_IMAGE_TO_BLOCK_INDEX_PREFIX);
+    DB::deserializeValue (state.nonEmptyBlocksCount,
+                          iter,
+                          DB::NON_EMPTY_BLOCK_INDEX_PREFIX);
 
     assert(iter == range.end ());
 
@@ -450,13 +602,20 @@ BlockchainReadState::BlockchainReadState(BlockchainReadState &&state)
       rawBlocks (std::move (state.rawBlocks)),
       blockHashesByTimestamp (std::move (state.blockHashesByTimestamp)),
       keyOutputKeys (std::move (state.keyOutputKeys)),
+      keyOutputBlockCountsCountForAmounts (std::move (state.keyOutputBlockCountsCountForAmounts)),
+      keyOutputBlockCountsForAmounts (std::move (state.keyOutputBlockCountsForAmounts)),
+      lockedKeyOutputsCountForAmounts (std::move (state.lockedKeyOutputsCountForAmounts)),
+      lockedKeyOutputsForAmounts (std::move (state.lockedKeyOutputsForAmounts)),
+      nonEmptyBlockIndexes (std::move (state.nonEmptyBlockIndexes)),
       closestTimestampBlockIndex (std::move (state.closestTimestampBlockIndex)),
       lastBlockIndex (std::move (state.lastBlockIndex)),
       keyOutputAmountsCount (std::move (state.keyOutputAmountsCount)),
       keyOutputAmounts (std::move (state.keyOutputAmounts)),
       transactionCountsByPaymentIds (std::move (state.transactionCountsByPaymentIds)),
       transactionHashesByPaymentIds (std::move (state.transactionHashesByPaymentIds)),
-      transactionsCount (std::move (state.transactionsCount))
+      transactionsCount (std::move (state.transactionsCount)),
+      spentKeyImageFilter (std::move (state.spentKeyImageFilter)),
+      nonEmptyBlocksCount (std::move (state.nonEmptyBlocksCount))
 {
 }
 
@@ -477,9 +636,16 @@ size_t BlockchainReadState::size() const
            transactionHashesByPaymentIds.size () +
            blockHashesByTimestamp.size () +
            keyOutputKeys.size () +
+           keyOutputBlockCountsCountForAmounts.size () +
+           keyOutputBlockCountsForAmounts.size () +
+           lockedKeyOutputsCountForAmounts.size () +
+           lockedKeyOutputsForAmounts.size () +
+           nonEmptyBlockIndexes.size () +
            (lastBlockIndex.second ? 1 : 0) +
            (keyOutputAmountsCount.second ? 1 : 0) +
-           (transactionsCount.second ? 1 : 0);
+           (transactionsCount.second ? 1 : 0) +
+           (spentKeyImageFilter.second ? 1 : 0) +
+           (nonEmptyBlocksCount.second ? 1 : 0);
 }
 
 BlockchainReadResult::BlockchainReadResult(BlockchainReadResult &&result)
@@ -25,6 +25,7 @@
 
 #include <CryptoNoteCore/Blockchain/BlockchainCache.h>
 #include <CryptoNoteCore/Database/DatabaseCacheData.h>
+#include <CryptoNoteCore/Database/SpentKeyImageFilter.h>
 
 namespace std {
     template<>
@@ -95,10 +96,22 @@ namespace CryptoNote {
         std::unordered_map<uint64_t,
                            std::vector<Crypto::Hash>> blockHashesByTimestamp;
         KeyOutputKeyResult keyOutputKeys;
+        std::unordered_map<IBlockchainCache::Amount,
+                           uint32_t> keyOutputBlockCountsCountForAmounts;
+        std::unordered_map<std::pair<IBlockchainCache::Amount, uint32_t>,
+                           KeyOutputBlockCount> keyOutputBlockCountsForAmounts;
+        std::unordered_map<IBlockchainCache::Amount,
+                           uint32_t> lockedKeyOutputsCountForAmounts;
+        std::unordered_map<std::pair<IBlockchainCache::Amount, uint32_t>,
+                           LockedKeyOutput> lockedKeyOutputsForAmounts;
+        std::unordered_map<uint32_t,
+                           uint32_t> nonEmptyBlockIndexes;
 
         std::pair<uint32_t, bool> lastBlockIndex = {0, false};
         std::pair<uint32_t, bool> keyOutputAmountsCount = {{}, false};
         std::pair<uint64_t, bool> transactionsCount = {0, false};
+        std::pair<SpentKeyImageFilter, bool> spentKeyImageFilter = {{}, false};
+        std::pair<uint32_t, bool> nonEmptyBlocksCount = {0, false};
 
         BlockchainReadState() = default;
         BlockchainReadState(const BlockchainReadState &) = default;
@@ -139,6 +152,8 @@ namespace CryptoNote {
         const std::unordered_map<uint64_t,
                                  uint32_t> &getClosestTimestampBlockIndex() const;
         uint32_t getKeyOutputAmountsCount() const;
+        const std::unordered_map<uint32_t,
+                                 IBlockchainCache::Amount> &getKeyOutputAmounts() const;
         const std::unordered_map<Crypto::Hash,
                                  uint32_t> &getTransactionCountByPaymentIds() const;
         const std::unordered_map<std::pair<Crypto::Hash,
@@ -149,6 +164,22 @@ namespace CryptoNote {
         const std::pair<uint64_t,
                         bool> &getTransactionsCount() const;
         const KeyOutputKeyResult &getKeyOutputInfo() const;
+        const std::unordered_map<IBlockchainCache::Amount,
+                                 uint32_t> &getKeyOutputBlockCountsCountForAmounts() const;
+        const std::unordered_map<std::pair<IBlockchainCache::Amount,
+                                           uint32_t>,
+                                 KeyOutputBlockCount> &getKeyOutputBlockCountsForAmounts() const;
+        const std::unordered_map<IBlockchainCache::Amount,
+                                 uint32_t> &getLockedKeyOutputsCountForAmounts() const;
+        const std::unordered_map<std::pair<IBlockchainCache::Amount,
+                                           uint32_t>,
+                                 LockedKeyOutput> &getLockedKeyOutputsForAmounts() const;
+        const std::pair<SpentKeyImageFilter,
+                        bool> &getSpentKeyImageFilter() const;
+        const std::unordered_map<uint32_t,
+                                 uint32_t> &getNonEmptyBlockIndexes() const;
+        const std::pair<uint32_t,
+                        bool> &getNonEmptyBlocksCount() const;
 
     private:
         BlockchainReadState state;
@@ -175,6 +206,7 @@ namespace CryptoNote {
         BlockchainReadBatch &requestLastBlockIndex();
         BlockchainReadBatch &requestClosestTimestampBlockIndex(uint64_t timestamp);
         BlockchainReadBatch &requestKeyOutputAmountsCount();
+        BlockchainReadBatch &requestKeyOutputAmount(uint32_t amountId);
         BlockchainReadBatch &requestTransactionCountByPaymentId(const Crypto::Hash &paymentId);
         BlockchainReadBatch &requestTransactionHashByPaymentId(const Crypto::Hash &paymentId,
                                                                uint32_t transactionIndexWithinPaymentId);
@@ -182,6 +214,15 @@ namespace CryptoNote {
         BlockchainReadBatch &requestTransactionsCount();
         BlockchainReadBatch &requestKeyOutputInfo(IBlockchainCache::Amount amount,
                                                   IBlockchainCache::GlobalOutputIndex globalIndex);
+        BlockchainReadBatch &requestKeyOutputBlockCountsCountForAmount(IBlockchainCache::Amount amount);
+        BlockchainReadBatch &requestKeyOutputBlockCountForAmount(IBlockchainCache::Amount amount,
+                                                                 uint32_t entryIndexWithinAmount);
+        BlockchainReadBatch &requestLockedKeyOutputsCountForAmount(IBlockchainCache::Amount amount);
+        BlockchainReadBatch &requestLockedKeyOutputForAmount(IBlockchainCache::Amount amount,
+                                                             uint32_t entryIndexWithinAmount);
+        BlockchainReadBatch &requestSpentKeyImageFilter();
+        BlockchainReadBatch &requestNonEmptyBlocksCount();
+        BlockchainReadBatch &requestNonEmptyBlockIndex(uint32_t entryIndex);
 
         std::vector<std::string> getRawKeys() const override;
         void submitRawResult(const std::vector<std::string> &values,
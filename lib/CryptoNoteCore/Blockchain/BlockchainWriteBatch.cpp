@@ -186,6 +186,80 @@ BlockchainWriteBatch::insertKeyOutputInfo(IBlockchainCache::Amount amount,
     return *this;
 }
 
+BlockchainWriteBatch &
+BlockchainWriteBatch::insertKeyOutputBlockCounts(IBlockchainCache::Amount amount,
+                                                 const std::vector<KeyOutputBlockCount> &blockCounts,
+                                                 uint32_t totalBlockCountsForAmount)
+{
+    assert(totalBlockCountsForAmount >= blockCounts.size ());
+    rawDataToInsert.reserve (rawDataToInsert.size () + blockCounts.size () + 1);
+    rawDataToInsert.emplace_back (DB::serialize (DB::KEY_OUTPUT_AMOUNT_BLOCK_COUNT_PREFIX,
+                                                 amount,
+                                                 totalBlockCountsForAmount));
+    uint32_t currentEntryId = totalBlockCountsForAmount - static_cast<uint32_t>(blockCounts.size ());
+
+    for (const KeyOutputBlockCount &blockCount : blockCounts) {
+        rawDataToInsert.emplace_back (DB::serialize (DB::KEY_OUTPUT_AMOUNT_BLOCK_COUNT_PREFIX,
+                                                     std::make_pair (amount,
+                                                                     currentEntryId++),
+                                                     blockCount));
+    }
+
+    return *this;
+}
+
+BlockchainWriteBatch &
+BlockchainWriteBatch::insertLockedKeyOutputs(IBlockchainCache::Amount amount,
+                                             const std::vector<LockedKeyOutput> &lockedOutputs,
+                                             uint32_t totalLockedOutputsForAmount)
+{
+    assert(totalLockedOutputsForAmount >= lockedOutputs.size ());
+    rawDataToInsert.reserve (rawDataToInsert.size () + lockedOutputs.size () + 1);
+    rawDataToInsert.emplace_back (DB::serialize (DB::KEY_OUTPUT_AMOUNT_LOCKED_PREFIX,
+                                                 amount,
+                                                 totalLockedOutputsForAmount));
+    uint32_t currentEntryId = totalLockedOutputsForAmount - static_cast<uint32_t>(lockedOutputs.size ());
+
+    for (const LockedKeyOutput &lockedOutput : lockedOutputs) {
+        rawDataToInsert.emplace_back (DB::serialize (DB::KEY_OUTPUT_AMOUNT_LOCKED_PREFIX,
+                                                     std::make_pair (amount,
+                                                                     currentEntryId++),
+                                                     lockedOutput));
+    }
+
+    return *this;
+}
+
+BlockchainWriteBatch &
+BlockchainWriteBatch::insertSpentKeyImageFilter(const SpentKeyImageFilter &filter)
+{
+    rawDataToInsert.emplace_back (DB::serialize (DB::KEY_IMAGE_TO_BLOCK_INDEX_PREFIX,
+                                                 DB::SPENT_KEY_IMAGE_FILTER_KEY,
+                                                 filter));
+
+    return *this;
+}
+
+BlockchainWriteBatch &
+BlockchainWriteBatch::insertNonEmptyBlockIndexes(const std::vector<uint32_t> &blockIndexes,
+                                                 uint32_t totalNonEmptyBlocksCount)
+{
+    assert(totalNonEmptyBlocksCount >= blockIndexes.size ());
+    rawDataToInsert.reserve (rawDataToInsert.size () + blockIndexes.size () + 1);
+    rawDataToInsert.emplace_back (DB::serialize (DB::NON_EMPTY_BLOCK_INDEX_PREFIX,
+                                                 DB::NON_EMPTY_BLOCKS_COUNT_KEY,
+                                                 totalNonEmptyBlocksCount));
+    uint32_t currentEntryId = totalNonEmptyBlocksCount - static_cast<uint32_t>(blockIndexes.size ());
+
+    for (uint32_t blockIndex : blockIndexes) {
+        rawDataToInsert.emplace_back (DB::serialize (DB::NON_EMPTY_BLOCK_INDEX_PREFIX,
+                                                     currentEntryId++,
+                                                     blockIndex));
+    }
+
+    return *this;
+}
+
 BlockchainWriteBatch &
 BlockchainWriteBatch::removeSpentKeyImages(uint32_t blockIndex,
                                            const std::vector<Crypto::KeyImage> &spentKeyImages)
@@ -301,6 +375,67 @@ BlockchainWriteBatch::removeKeyOutputInfo(IBlockchainCache::Amount amount,
     return *this;
 }
 
+BlockchainWriteBatch &
+BlockchainWriteBatch::removeKeyOutputBlockCounts(IBlockchainCache::Amount amount,
+                                                 uint32_t blockCountsToRemoveCount,
+                                                 uint32_t totalBlockCountsForAmount)
+{
+    rawKeysToRemove.reserve (rawKeysToRemove.size () + blockCountsToRemoveCount);
+    rawDataToInsert.emplace_back (DB::serialize (DB::KEY_OUTPUT_AMOUNT_BLOCK_COUNT_PREFIX,
+                                                 amount,
+                                                 totalBlockCountsForAmount));
+    for (uint32_t i = 0; i < blockCountsToRemoveCount; ++i) {
+        rawKeysToRemove.emplace_back (DB::serializeKey (DB::KEY_OUTPUT_AMOUNT_BLOCK_COUNT_PREFIX,
+                                                        std::make_pair (amount,
+                                                                        totalBlockCountsForAmount + i)));
+    }
+
+    return *this;
+}
+
+BlockchainWriteBatch &
+BlockchainWriteBatch::removeLockedKeyOutputs(IBlockchainCache::Amount amount,
+                                             uint32_t lockedOutputsToRemoveCount,
+                                             uint32_t totalLockedOutputsForAmount)
+{
+    rawKeysToRemove.reserve (rawKeysToRemove.size () + lockedOutputsToRemoveCount);
+    rawDataToInsert.emplace_back (DB::serialize (DB::KEY_OUTPUT_AMOUNT_LOCKED_PREFIX,
+                                                 amount,
+                                                 totalLockedOutputsForAmount));
+    for (uint32_t i = 0; i < lockedOutputsToRemoveCount; ++i) {
+        rawKeysToRemove.emplace_back (DB::serializeKey (DB::KEY_OUTPUT_AMOUNT_LOCKED_PREFIX,
+                                                        std::make_pair (amount,
+                                                                        totalLockedOutputsForAmount + i)));
+    }
+
+    return *this;
+}
+
+BlockchainWriteBatch &
+BlockchainWriteBatch::removeSpentKeyImageFilter()
+{
+    rawKeysToRemove.emplace_back (DB::serializeKey (DB::KEY_IMAGE_TO_BLOCK_INDEX_PREFIX,
+                                                    DB::SPENT_KEY_IMAGE_FILTER_KEY));
+
+    return *this;
+}
+
+BlockchainWriteBatch &
+BlockchainWriteBatch::removeNonEmptyBlockIndexes(uint32_t blockIndexesToRemoveCount,
+                                                 uint32_t totalNonEmptyBlocksCount)
+{
+    rawKeysToRemove.reserve (rawKeysToRemove.size () + blockIndexesToRemoveCount);
+    rawDataToInsert.emplace_back (DB::serialize (DB::NON_EMPTY_BLOCK_INDEX_PREFIX,
+                                                 DB::NON_EMPTY_BLOCKS_COUNT_KEY,
+                                                 totalNonEmptyBlocksCount));
+    for (uint32_t i = 0; i < blockIndexesToRemoveCount; ++i) {
+        rawKeysToRemove.emplace_back (DB::serializeKey (DB::NON_EMPTY_BLOCK_INDEX_PREFIX,
+                                                        totalNonEmptyBlocksCount + i));
+    }
+
+    return *this;
+}
+
 std::vector<std::pair<std::string, std::string>>
 BlockchainWriteBatch::extractRawDataToInsert()
 {
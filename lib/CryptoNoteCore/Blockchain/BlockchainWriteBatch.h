@@ -23,6 +23,7 @@
 
 #include <CryptoNoteCore/Blockchain/BlockchainCache.h>
 #include <CryptoNoteCore/Database/DatabaseCacheData.h>
+#include <CryptoNoteCore/Database/SpentKeyImageFilter.h>
 
 namespace CryptoNote {
 
@@ -56,6 +57,15 @@ namespace CryptoNote {
         BlockchainWriteBatch &insertKeyOutputInfo(IBlockchainCache::Amount amount,
                                                   IBlockchainCache::GlobalOutputIndex globalIndex,
                                                   const KeyOutputInfo &outputInfo);
+        BlockchainWriteBatch &insertKeyOutputBlockCounts(IBlockchainCache::Amount amount,
+                                                         const std::vector<KeyOutputBlockCount> &blockCounts,
+                                                         uint32_t totalBlockCountsForAmount);
+        BlockchainWriteBatch &insertLockedKeyOutputs(IBlockchainCache::Amount amount,
+                                                     const std::vector<LockedKeyOutput> &lockedOutputs,
+                                                     uint32_t totalLockedOutputsForAmount);
+        BlockchainWriteBatch &insertSpentKeyImageFilter(const SpentKeyImageFilter &filter);
+        BlockchainWriteBatch &insertNonEmptyBlockIndexes(const std::vector<uint32_t> &blockIndexes,
+                                                         uint32_t totalNonEmptyBlocksCount);
 
         BlockchainWriteBatch &removeSpentKeyImages(uint32_t blockIndex,
                                                    const std::vector<Crypto::KeyImage> &spentKeyImages);
@@ -73,6 +83,15 @@ namespace CryptoNote {
         BlockchainWriteBatch &removeTimestamp(uint64_t timestamp);
         BlockchainWriteBatch &removeKeyOutputInfo(IBlockchainCache::Amount amount,
                                                   IBlockchainCache::GlobalOutputIndex globalIndex);
+        BlockchainWriteBatch &removeKeyOutputBlockCounts(IBlockchainCache::Amount amount,
+                                                         uint32_t blockCountsToRemoveCount,
+                                                         uint32_t totalBlockCountsForAmount);
+        BlockchainWriteBatch &removeLockedKeyOutputs(IBlockchainCache::Amount amount,
+                                                     uint32_t lockedOutputsToRemoveCount,
+                                                     uint32_t totalLockedOutputsForAmount);
+        BlockchainWriteBatch &removeSpentKeyImageFilter();
+        BlockchainWriteBatch &removeNonEmptyBlockIndexes(uint32_t blockIndexesToRemoveCount,
+                                                         uint32_t totalNonEmptyBlocksCount);
 
         std::vector<std::pair<std::string, std::string>> extractRawDataToInsert() override;
         std::vector<std::string> extractRawKeysToRemove() override;
@@ -106,6 +106,16 @@ const Crypto::Hash &CachedBlock::getBlockLongHash() const
     }
 }
 
+void CachedBlock::setBlockLongHash(const Crypto::Hash &longHash) const
+{
+    blockLongHash = longHash;
+}
+
+bool CachedBlock::hasBlockLongHash() const
+{
+    return blockLongHash.is_initialized ();
+}
+
 const Crypto::Hash &CachedBlock::getAuxiliaryBlockHeaderHash() const
 {
     if (!auxiliaryBlockHeaderHash.is_initialized ()) {
@@ -35,6 +35,12 @@ namespace CryptoNote {
         const Crypto::Hash &getTransactionTreeHash() const;
         const Crypto::Hash &getBlockHash() const;
         const Crypto::Hash &getBlockLongHash() const;
+
+        /*!
+            seeds the lazily computed long hash with a value known from an earlier check
+        */
+        void setBlockLongHash(const Crypto::Hash &longHash) const;
+        bool hasBlockLongHash() const;
         const Crypto::Hash &getAuxiliaryBlockHeaderHash() const;
         const BinaryArray &getBlockHashingBinaryArray() const;
         const BinaryArray &getParentBlockBinaryArray(bool headerOnly) const;
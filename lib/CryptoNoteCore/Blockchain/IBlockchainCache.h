@@ -234,6 +234,12 @@ namespace CryptoNote {
         virtual void save() = 0;
         virtual void load() = 0;
 
+        /*!
+            Hint that blocks are being pushed far behind the network tip, caches backed by
+            a database may then group many blocks into a single write transaction
+        */
+        virtual void setBulkSyncMode(bool enable) = 0;
+
         virtual std::vector<uint64_t> getLastUnits(size_t count,
                                                    uint32_t blockIndex,
                                                    UseGenesis use,
@@ -18,6 +18,8 @@
 
 #pragma once
 
+#include <functional>
+
 #include <CryptoNote.h>
 #include <CryptoNoteCore/Transactions/ITransactionValidator.h>
 
@@ -36,6 +38,19 @@ namespace CryptoNote {
         virtual RawBlock getBlockByIndex(const uint32_t index) = 0;
         virtual uint32_t getBlockCount() const = 0;
 
+        /*!
+            hands the blocks from startIndex to the top to callback in order,
+            storages able to scan sequentially override this
+        */
+        virtual void forEachBlock(uint32_t startIndex,
+                                  const std::function<void(uint32_t, RawBlock &&)> &callback)
+        {
+            const uint32_t blockCount = getBlockCount ();
+            for (uint32_t index = startIndex; index < blockCount; ++index) {
+                callback (index, getBlockByIndex (index));
+            }
+        }
+
         virtual void clear() = 0;
     };
 } // namespace CryptoNote
@@ -948,6 +948,22 @@ namespace CryptoNote {
          */
         virtual std::vector<Crypto::Hash> getHashesRange(const uint64_t &h1, const uint64_t &h2) const = 0;
 
+        /*!
+         * @brief fetch the block info records of a range of blocks
+         *
+         * The subclass should return the block info of blocks with heights
+         * starting at h1 and ending at h2, inclusively, in height order.
+         *
+         * If the height range requested goes past the end of the blockchain,
+         * the subclass should throw BLOCK_DNE.
+         *
+         * @param h1    the start height
+         * @param h2    the end height
+         *
+         * @return a vector of block info records
+         */
+        virtual std::vector<BlockInfoT> getBlockInfoRange(const uint64_t &h1, const uint64_t &h2) const = 0;
+
         /*!
          * @brief fetch the top block's hash
          *
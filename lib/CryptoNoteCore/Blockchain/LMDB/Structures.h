@@ -34,6 +34,20 @@ namespace CryptoNote {
     };
 #pragma pack(pop)
 
+    /*!
+     * the per block values kept in the block info table
+     */
+    struct BlockInfoT
+    {
+        uint64_t        height;
+        uint64_t        timestamp;
+        uint64_t        alreadyGeneratedCoins;
+        uint64_t        alreadyGeneratedTransactions;
+        uint64_t        blockSize;
+        uint64_t        cumulativeDifficulty;
+        Crypto::Hash    hash;
+    };
+
     struct TxPoolTxMetaT
     {
         Crypto::Hash    maxUsedBlockId;
@@ -0,0 +1,73 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+// Copyright (c) 2014-2018, The Monero Project
+// Copyright (c) 2018-2019, The TurtleCoin Developers
+// Copyright (c) 2018-2019, The Plenteum Developers
+// Copyright (c) 2018-2020, The Qwertycoin Project
+//
+// This file is part of Qwertycoin.
+//
+// Qwertycoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Qwertycoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+
+#include <CryptoNoteCore/Blockchain/LongHashCache.h>
+
+namespace CryptoNote {
+
+    LongHashCache::LongHashCache(size_t capacity)
+        : capacity (capacity)
+    {
+    }
+
+    bool LongHashCache::find(const Crypto::Hash &blockHash, Crypto::Hash &longHash)
+    {
+        std::lock_guard<std::mutex> lock (mutex);
+
+        auto it = index.find (blockHash);
+        if (it == index.end ()) {
+            return false;
+        }
+
+        entries.splice (entries.begin (), entries, it->second);
+        longHash = it->second->second;
+
+        return true;
+    }
+
+    void LongHashCache::insert(const Crypto::Hash &blockHash, const Crypto::Hash &longHash)
+    {
+        std::lock_guard<std::mutex> lock (mutex);
+
+        auto it = index.find (blockHash);
+        if (it != index.end ()) {
+            it->second->second = longHash;
+            entries.splice (entries.begin (), entries, it->second);
+            return;
+        }
+
+        if (capacity == 0) {
+            return;
+        }
+
+        if (entries.size () >= capacity) {
+            index.erase (entries.back ().first);
+            entries.pop_back ();
+        }
+
+        entries.emplace_front (blockHash, longHash);
+        index.emplace (blockHash, entries.begin ());
+    }
+
+    size_t LongHashCache::size() const
+    {
+        std::lock_guard<std::mutex> lock (mutex);
+
+        return entries.size ();
+    }
+} // namespace CryptoNote
@@ -0,0 +1,56 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+// Copyright (c) 2014-2018, The Monero Project
+// Copyright (c) 2018-2019, The TurtleCoin Developers
+// Copyright (c) 2018-2019, The Plenteum Developers
+// Copyright (c) 2018-2020, The Qwertycoin Project
+//
+// This file is part of Qwertycoin.
+//
+// Qwertycoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Qwertycoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+
+#pragma once
+
+#include <cstddef>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+#include <CryptoTypes.h>
+
+namespace CryptoNote {
+    /*!
+        Bounded map from block hash to the block's proof of work (long) hash.
+        The long hash only depends on the block header, so a block that arrives
+        again - from another peer, on an alternative chain or re-assembled from
+        a lite block - is checked against the difficulty without hashing it twice.
+        Failed checks are remembered as well, since relays of an invalid block are
+        the cheapest way to keep a node busy. The least recently used entry is
+        evicted once the cache is full.
+    */
+    class LongHashCache
+    {
+    public:
+        explicit LongHashCache(size_t capacity);
+
+        bool find(const Crypto::Hash &blockHash, Crypto::Hash &longHash);
+        void insert(const Crypto::Hash &blockHash, const Crypto::Hash &longHash);
+
+        size_t size() const;
+
+    private:
+        using Entry = std::pair<Crypto::Hash, Crypto::Hash>;
+
+        const size_t capacity;
+        mutable std::mutex mutex;
+        std::list<Entry> entries;
+        std::unordered_map<Crypto::Hash, std::list<Entry>::iterator> index;
+    };
+} // namespace CryptoNote
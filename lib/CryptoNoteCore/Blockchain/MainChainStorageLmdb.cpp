@@ -23,22 +23,71 @@
 
 #include <lmdb/lmdbpp.h>
 
-#include <rapidjson/writer.h>
-#include <rapidjson/stringbuffer.h>
+#include <rapidjson/document.h>
 
 #include <Common/CryptoNoteTools.h>
 #include <Common/FileSystemShim.h>
+#include <Common/MemoryInputStream.h>
 
 #include <CryptoNoteCore/Blockchain/MainChainStorageLmdb.h>
 
 #include <Global/Constants.h>
 #include <Global/LMDBConfig.h>
 
+#include <Serialization/BinaryInputStreamSerializer.h>
+
 using namespace rapidjson;
 using namespace CryptoNote;
 using namespace LMDB;
 
 namespace CryptoNote {
+
+    namespace {
+        /*!
+            v2 layout: blocks live in the named database below, keyed by the
+            block index as 4 big endian bytes so that key order is height order
+            and every push is an append at the right edge of the B-tree. values
+            are binary serialized RawBlocks. the v1 layout kept hex JSON under
+            the decimal index in the unnamed database
+        */
+        const char *const BLOCKS_DB_NAME = "blocks";
+
+        std::string blockKey(uint32_t index)
+        {
+            std::string key (sizeof (index), '\0');
+            for (size_t i = 0; i < sizeof (index); ++i) {
+                key[i] = static_cast<char>((index >> (8 * (sizeof (index) - 1 - i))) & 0xff);
+            }
+
+            return key;
+        }
+
+        uint32_t blockIndexFromKey(std::string_view key)
+        {
+            uint32_t index = 0;
+            for (size_t i = 0; i < sizeof (index) && i < key.size (); ++i) {
+                index = (index << 8) | static_cast<uint8_t>(key[i]);
+            }
+
+            return index;
+        }
+
+        std::string_view blockValue(const BinaryArray &value)
+        {
+            return std::string_view (reinterpret_cast<const char *>(value.data ()), value.size ());
+        }
+
+        RawBlock rawBlockFromValue(std::string_view value)
+        {
+            RawBlock rawBlock;
+            Common::MemoryInputStream stream (value.data (), value.size ());
+            BinaryInputStreamSerializer serializer (stream);
+            serialize (rawBlock, serializer);
+
+            return rawBlock;
+        }
+    } // namespace
+
     MainChainStorageLmdb::MainChainStorageLmdb(const std::string &blocksFilename,
                                                const std::string &indexesFilename)
     {
@@ -70,6 +119,7 @@ namespace CryptoNote {
         }
 
         m_db.set_mapsize (mapsize);
+        m_db.set_max_dbs (1);
 
         /*!
             open database
@@ -86,8 +136,23 @@ namespace CryptoNote {
             prepare tx handle
         */
         lmdb::txn_begin (m_db, nullptr, MDB_RDONLY, &rtxn);
+
+        /*!
+            the map was sized from the file, make room for creating the blocks
+            database and for the first batch of a v1 migration
+        */
+        checkResize ();
+
+        lmdb::txn_begin (m_db, nullptr, 0, &wtxn);
+        m_blocks = lmdb::dbi::open (wtxn, BLOCKS_DB_NAME, MDB_CREATE);
+        lmdb::txn_commit (wtxn);
         lmdb::txn_begin (m_db, nullptr, 0, &wtxn);
 
+        /*!
+            move blocks over from the v1 layout, if any
+        */
+        migrateLegacyBlocks ();
+
         /*!
             initialize blockcount cache counter
         */
@@ -141,17 +206,10 @@ namespace CryptoNote {
             lmdb::txn_begin (m_db, nullptr, 0, &wtxn);
         }
 
-        /*!
-            stringify RawBlock for storage 
-        */
-        StringBuffer rblock;
-        Writer<StringBuffer> writer (rblock);
-        rawBlock.toJSON (writer);
+        const BinaryArray value = toBinaryArray (rawBlock);
 
         { // open lmdb cursor
-            lmdb::dbi dbi = lmdb::dbi::open (wtxn, nullptr);
-
-            dbi.put (wtxn, std::to_string (m_blockcount), rblock.GetString ());
+            m_blocks.put (wtxn, blockKey (m_blockcount), blockValue (value), MDB_APPEND);
 
             if (m_blockcount == 0) {
                 lmdb::txn_commit (wtxn);
@@ -170,13 +228,8 @@ namespace CryptoNote {
 
     void MainChainStorageLmdb::popBlock()
     {
-        lmdb::dbi dbi;
-
-        renewRoTxn ();
-
         { // open lmdb cursor
-            lmdb::dbi dbi = lmdb::dbi::open (rtxn, nullptr);
-            auto cursor = lmdb::cursor::open (wtxn, dbi);
+            auto cursor = lmdb::cursor::open (wtxn, m_blocks);
             std::string_view key, val;
 
             if (cursor.get (key, val, MDB_LAST)) {
@@ -185,6 +238,8 @@ namespace CryptoNote {
 
                 lmdb::txn_commit (wtxn);
                 lmdb::txn_begin (m_db, nullptr, 0, &wtxn);
+
+                m_blockcount--;
             } else {
                 cursor.close ();
             }
@@ -193,51 +248,51 @@ namespace CryptoNote {
 
     RawBlock MainChainStorageLmdb::getBlockByIndex(const uint32_t index)
     {
-        bool found = false;
-
         renewRoTxn ();
 
-        lmdb::dbi dbi;
-        RawBlock rawBlock;
-
-        { // open lmdb cursor
-            try {
-                dbi = lmdb::dbi::open (rtxn, nullptr);
-            } catch (const std::exception &e) {
-                try {
-                    lmdb::txn_commit (wtxn);
-                } catch (...) {
-
-                }
+        std::string_view val;
+        bool found = m_blocks.get (rtxn, blockKey (index), val);
 
-                throw std::runtime_error ("Could not find block in cache for given blockIndex: " +
-                                          std::string (e.what ()));
-            }
-
-            std::string_view val;
-            if (dbi.get (rtxn, std::to_string (index), val)) {
-                Document doc;
-                if (!doc.Parse<0> (std::string (val)).HasParseError ()) {
-                    rawBlock.fromJSON (doc);
-                    found = true;
-                } else {
-                    std::cout
-                        << doc.GetParseError ()
-                        << std::endl;
-                }
-            }
-        } // close lmdb cursor
+        /*!
+            the block may still be pending in the write tx
+        */
+        if (!found && index < static_cast<uint32_t>(m_blockcount)) {
+            renewRwTxn (false);
+            renewRoTxn ();
+            found = m_blocks.get (rtxn, blockKey (index), val);
+        }
 
         if (!found) {
-            try {
-                lmdb::txn_commit (wtxn);
-            } catch (...) {
-            }
             throw std::runtime_error ("Could not find block in cache for given blockIndex: " +
                                       std::to_string (index));
         }
 
-        return rawBlock;
+        return rawBlockFromValue (val);
+    }
+
+    void MainChainStorageLmdb::forEachBlock(uint32_t startIndex,
+                                            const std::function<void(uint32_t, RawBlock &&)> &callback)
+    {
+        /*!
+            commit pending writes so the scan sees them, then walk the blocks
+            in key order with a single cursor. the read tx is held for the
+            whole scan, so callback must not read through this storage
+        */
+        renewRwTxn (false);
+        renewRoTxn ();
+
+        auto cursor = lmdb::cursor::open (rtxn, m_blocks);
+        const std::string startKey = blockKey (startIndex);
+        std::string_view key = startKey;
+        std::string_view val;
+
+        bool found = cursor.get (key, val, MDB_SET_RANGE);
+        while (found) {
+            callback (blockIndexFromKey (key), rawBlockFromValue (val));
+            found = cursor.get (key, val, MDB_NEXT);
+        }
+
+        cursor.close ();
     }
 
     uint32_t MainChainStorageLmdb::getBlockCount() const
@@ -252,19 +307,75 @@ namespace CryptoNote {
         renewRoTxn ();
 
         { // open lmdb cursor
-            lmdb::dbi dbi = lmdb::dbi::open (rtxn, nullptr);
-            MDB_stat stat = dbi.stat (rtxn);
+            MDB_stat stat = m_blocks.stat (rtxn);
             m_blockcount = stat.ms_entries;
         } // close lmdb cursor
     }
 
+    void MainChainStorageLmdb::migrateLegacyBlocks()
+    {
+        /*!
+            copies v1 blocks over in batches of MAX_DIRTY, each batch deleting
+            what it copied in the same tx. an interrupted migration resumes
+            from the last committed batch on the next start
+        */
+        lmdb::dbi legacy = lmdb::dbi::open (wtxn, nullptr);
+        uint32_t index = static_cast<uint32_t>(m_blocks.size (wtxn));
+
+        std::string_view val;
+        if (!legacy.get (wtxn, std::to_string (index), val)) {
+            return;
+        }
+
+        std::cout
+            << "Migrating blockchain storage to the binary format, this may take a while..."
+            << std::endl;
+
+        do {
+            Document doc;
+            if (doc.Parse<0> (std::string (val)).HasParseError ()) {
+                throw std::runtime_error ("Failed to migrate block " + std::to_string (index) +
+                                          ": " + std::to_string (static_cast<int>(doc.GetParseError ())));
+            }
+
+            RawBlock rawBlock;
+            rawBlock.fromJSON (doc);
+
+            const BinaryArray value = toBinaryArray (rawBlock);
+            m_blocks.put (wtxn, blockKey (index), blockValue (value), MDB_APPEND);
+            legacy.del (wtxn, std::to_string (index));
+
+            ++index;
+
+            if (index % MAX_DIRTY == 0) {
+                lmdb::txn_commit (wtxn);
+                checkResize ();
+                lmdb::txn_begin (m_db, nullptr, 0, &wtxn);
+
+                std::cout
+                    << "Migrated "
+                    << index
+                    << " blocks"
+                    << std::endl;
+            }
+        } while (legacy.get (wtxn, std::to_string (index), val));
+
+        lmdb::txn_commit (wtxn);
+        lmdb::txn_begin (m_db, nullptr, 0, &wtxn);
+
+        std::cout
+            << "Blockchain storage migrated, "
+            << index
+            << " blocks"
+            << std::endl;
+    }
+
     void MainChainStorageLmdb::clear()
     {
         throw std::runtime_error ("NotImplemented");
 
         { // open lmdb cursor
-            lmdb::dbi dbi = lmdb::dbi::open (wtxn, nullptr);
-            dbi.drop (wtxn, 0);
+            m_blocks.drop (wtxn, false);
             lmdb::txn_commit (wtxn);
             lmdb::txn_begin (m_db, nullptr, 0, &wtxn);
         } // close lmdb cursor
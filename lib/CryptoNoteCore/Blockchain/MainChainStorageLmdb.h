@@ -43,15 +43,20 @@ namespace CryptoNote {
         virtual RawBlock getBlockByIndex(const uint32_t index) override;
         virtual uint32_t getBlockCount() const override;
 
+        virtual void forEachBlock(uint32_t startIndex,
+                                  const std::function<void(uint32_t, RawBlock &&)> &callback) override;
+
         virtual void clear() override;
 
     private:
+        void migrateLegacyBlocks();
         void initializeBlockCount();
         void checkResize();
         void renewRoTxn();
         void renewRwTxn(bool sync);
 
         lmdb::env m_db = lmdb::env::create ();
+        lmdb::dbi m_blocks;
         mutable MDB_txn *rtxn;
         mutable MDB_txn *wtxn;
         mutable std::atomic_int m_blockcount;
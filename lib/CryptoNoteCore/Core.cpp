@@ -23,14 +23,18 @@
 
 
 #include <algorithm>
+#include <atomic>
+#include <future>
 #include <numeric>
 #include <set>
+#include <thread>
 #include <unordered_set>
 
 #include <Common/CryptoNoteTools.h>
 #include <Common/ShuffleGenerator.h>
 #include <Common/Math.h>
 #include <Common/MemoryInputStream.h>
+#include <Common/Metrics.h>
 #include <CryptoNoteCore/Transactions/TransactionExtra.h>
 
 
@@ -52,10 +56,14 @@
 
 #include <Global/Constants.h>
 
+#include <System/Event.h>
+#include <System/InterruptedException.h>
 #include <System/Timer.h>
 
 #include <Utilities/Container.h>
 #include <Utilities/FormatTools.h>
+#include <Utilities/ParallelFor.h>
+#include <Utilities/ThreadPool.h>
 #include <Utilities/ParseExtra.h>
 
 #include <WalletTypes.h>
@@ -70,6 +78,21 @@ namespace CryptoNote {
 
         const std::chrono::seconds OUTDATED_TRANSACTION_POLLING_INTERVAL = std::chrono::seconds (60);
 
+        /*!
+            how long admission waits before trying a full worker pool queue again
+        */
+        const std::chrono::milliseconds WORKER_POOL_RETRY_INTERVAL = std::chrono::milliseconds (10);
+
+        /*!
+            main chain blocks older than this are pushed in bulk sync mode
+        */
+        const uint64_t BULK_SYNC_MIN_BLOCK_AGE = 24 * 60 * 60;
+
+        /*!
+            long hashes remembered for blocks seen again, about 128 KiB
+        */
+        const size_t LONG_HASH_CACHE_SIZE = 2048;
+
         template<class T>
         std::vector<T> preallocateVector(size_t elements)
         {
@@ -239,6 +262,26 @@ namespace CryptoNote {
 
             return left;
         }
+
+        /*!
+            relayed transaction going through the pool admission pipeline
+        */
+        struct PoolTransactionCandidate
+        {
+            boost::optional<CachedTransaction> transaction;
+            uint64_t fee = 0;
+            std::vector<std::vector<Crypto::PublicKey>> ringKeys;
+            std::string rejectReason;
+            bool valid = false;
+        };
+
+        Metrics::Counter &poolTransactionsAdded()
+        {
+            static auto &counter = Metrics::Registry::instance ().counter (
+                "core_pool_transactions_added_total",
+                "Transactions added to the pool, from RPC and relayed by peers");
+            return counter;
+        }
     } // namespace
 
     Core::Core(std::unique_ptr<BlockchainDB> &db,
@@ -265,7 +308,8 @@ namespace CryptoNote {
                    *this,
                    mTimeProvider,
                    logger,
-                   blockchainIndexesEnabled)
+                   blockchainIndexesEnabled),
+          longHashCache (LONG_HASH_CACHE_SIZE)
     {
         upgradeManager->addMajorBlockVersion (BLOCK_MAJOR_VERSION_1,
                                               currency.upgradeHeight (BLOCK_MAJOR_VERSION_1));
@@ -852,6 +896,19 @@ namespace CryptoNote {
                 return true;
             }
 
+            if (getCachedWalletSyncData (startIndex,
+                                         endIndex,
+                                         actualBlockCount,
+                                         skipCoinbaseTransactions,
+                                         currentHash,
+                                         walletBlocks)) {
+                if (walletBlocks.empty ()) {
+                    topBlockInfo = WalletTypes::TopBlock ({currentHash, currentIndex});
+                }
+
+                return true;
+            }
+
             std::vector<RawBlock> rawBlocks;
 
             if (skipCoinbaseTransactions) {
@@ -860,7 +917,7 @@ namespace CryptoNote {
                 rawBlocks = mainChain->getBlocksByHeight (startIndex, endIndex);
             }
 
-            for (const auto rawBlock : rawBlocks) {
+            for (const auto &rawBlock : rawBlocks) {
                 Block block;
 
                 fromBinaryArray (block, rawBlock.block);
@@ -902,6 +959,99 @@ namespace CryptoNote {
         }
     }
 
+    bool Core::getCachedWalletSyncData(uint64_t startIndex,
+                                       uint64_t endIndex,
+                                       uint64_t blockCount,
+                                       bool skipCoinbaseTransactions,
+                                       const Crypto::Hash &topBlockHash,
+                                       std::vector<WalletTypes::WalletBlockInfo> &walletBlocks) const
+    {
+        /*!
+            The cache has to end at the current tip, otherwise it's stale or
+            the requested range is older than what we keep
+        */
+        if (walletSyncBlocks.empty () ||
+            walletSyncBlocks.back ().blockHash != topBlockHash ||
+            startIndex < walletSyncBlocks.front ().blockHeight) {
+            return false;
+        }
+
+        auto it = walletSyncBlocks.begin () + (startIndex - walletSyncBlocks.front ().blockHeight);
+
+        if (skipCoinbaseTransactions) {
+            for (; it != walletSyncBlocks.end () && walletBlocks.size () < blockCount; ++it) {
+                if (it->transactions.empty ()) {
+                    continue;
+                }
+
+                walletBlocks.push_back (*it);
+                walletBlocks.back ().coinbaseTransaction = std::nullopt;
+            }
+        } else {
+            for (; it != walletSyncBlocks.end () && it->blockHeight < endIndex; ++it) {
+                walletBlocks.push_back (*it);
+            }
+        }
+
+        return true;
+    }
+
+    void Core::pushWalletSyncBlock(const CachedBlock &cachedBlock,
+                                   const std::vector<CachedTransaction> &transactions)
+    {
+        const Block &block = cachedBlock.getBlock ();
+
+        WalletTypes::WalletBlockInfo walletBlock;
+
+        walletBlock.blockHeight = cachedBlock.getBlockIndex ();
+        walletBlock.blockHash = cachedBlock.getBlockHash ();
+        walletBlock.blockTimestamp = block.timestamp;
+        walletBlock.coinbaseTransaction = getRawCoinbaseTransaction (block.baseTransaction);
+
+        walletBlock.transactions.reserve (transactions.size ());
+        for (const auto &transaction : transactions) {
+            walletBlock.transactions.push_back (
+                getRawTransaction (transaction.getTransaction (), transaction.getTransactionHash ())
+            );
+        }
+
+        /*!
+            Only a contiguous range ending at the tip can be served
+        */
+        if (!walletSyncBlocks.empty () &&
+            walletSyncBlocks.back ().blockHeight + 1 != walletBlock.blockHeight) {
+            walletSyncBlocks.clear ();
+        }
+
+        walletSyncBlocks.push_back (std::move (walletBlock));
+
+        while (walletSyncBlocks.size () > WALLET_SYNC_BLOCK_CACHE_SIZE) {
+            walletSyncBlocks.pop_front ();
+        }
+    }
+
+    void Core::switchWalletSyncBlocks(uint32_t splitBlockIndex, IBlockchainCache &newChain)
+    {
+        while (!walletSyncBlocks.empty () && walletSyncBlocks.back ().blockHeight >= splitBlockIndex) {
+            walletSyncBlocks.pop_back ();
+        }
+
+        for (uint32_t index = splitBlockIndex; index <= newChain.getTopBlockIndex (); ++index) {
+            const RawBlock rawBlock = newChain.getBlockByIndex (index);
+
+            Block block;
+            fromBinaryArray (block, rawBlock.block);
+
+            std::vector<CachedTransaction> transactions;
+            transactions.reserve (rawBlock.transactions.size ());
+            for (const auto &transaction : rawBlock.transactions) {
+                transactions.emplace_back (transaction);
+            }
+
+            pushWalletSyncBlock (CachedBlock (block), transactions);
+        }
+    }
+
     WalletTypes::RawCoinbaseTransaction
     Core::getRawCoinbaseTransaction(const CryptoNote::Transaction &t)
     {
@@ -937,12 +1087,18 @@ namespace CryptoNote {
         */
         fromBinaryArray (t, rawTX);
 
-        WalletTypes::RawTransaction transaction;
-
         /*!
             Get the transaction hash from the binary array
         */
-        transaction.hash = getBinaryArrayHash (rawTX);
+        return getRawTransaction (t, getBinaryArrayHash (rawTX));
+    }
+
+    WalletTypes::RawTransaction Core::getRawTransaction(const CryptoNote::Transaction &t,
+                                                        const Crypto::Hash &hash)
+    {
+        WalletTypes::RawTransaction transaction;
+
+        transaction.hash = hash;
 
         Utilities::ParsedExtra parsedExtra = Utilities::parseExtra (t.extra);
 
@@ -1101,16 +1257,15 @@ namespace CryptoNote {
     std::error_code Core::addBlock(const CachedBlock &cachedBlock,
                                    RawBlock &&rawBlock)
     {
+        static auto &addBlockDuration = Metrics::Registry::instance ().histogram (
+            "core_add_block_duration_seconds",
+            "Time spent adding a block, including blocks that are rejected");
+        Metrics::ScopedTimer timer (addBlockDuration);
+
         throwIfNotInitialized ();
         uint32_t blockIndex = cachedBlock.getBlockIndex ();
         Crypto::Hash blockHash = cachedBlock.getBlockHash ();
-        std::ostringstream os;
-        os
-            << blockIndex
-            << " ("
-            << blockHash
-            << ")";
-        std::string blockStr = os.str ();
+        const std::string blockStr = std::to_string (blockIndex) + " (" + Common::podToHex (blockHash) + ")";
 
         logger (Logging::DEBUGGING)
             << "Request to add block "
@@ -1248,31 +1403,43 @@ namespace CryptoNote {
                                 CryptoNote::parameters::CRYPTONOTE_MINED_MONEY_UNLOCK_WINDOW;
         }
 
-        auto[success, error] = Mixins::validate (transactions, blockIndex);
-
-        if (!success) {
-            /*!
-                Warning, this shadows the above variables
-            */
-            auto[success, error] = Mixins::validate (transactions, mixinChangeWindow);
+        /*!
+            mixin limits are relay policy, blocks pinned by checkpoints were accepted
+            by the network with them already
+        */
+        if (!checkpoints.isInCheckpointZone (blockIndex)) {
+            auto[success, error] = Mixins::validate (transactions, blockIndex);
 
             if (!success) {
-                logger (Logging::DEBUGGING)
-                    << error;
+                /*!
+                    Warning, this shadows the above variables
+                */
+                auto[success, error] = Mixins::validate (transactions, mixinChangeWindow);
 
-                return error::TransactionValidationError::INVALID_MIXIN;
+                if (!success) {
+                    logger (Logging::DEBUGGING)
+                        << error;
+
+                    return error::TransactionValidationError::INVALID_MIXIN;
+                }
             }
         }
 
         uint64_t cumulativeFee = 0;
 
+        /*!
+            only transactions of a block below the last checkpoint may skip checks
+        */
+        const bool pinnedByCheckpoint = checkpoints.isInCheckpointZone (blockIndex);
+
         for (const auto &transaction : transactions) {
             uint64_t fee = 0;
             auto transactionValidationResult = validateTransaction (transaction,
                                                                     validatorState,
                                                                     cache,
                                                                     fee,
-                                                                    previousBlockIndex);
+                                                                    previousBlockIndex,
+                                                                    pinnedByCheckpoint);
             if (transactionValidationResult) {
                 logger (Logging::DEBUGGING)
                     << "Failed to validate transaction "
@@ -1326,7 +1493,7 @@ namespace CryptoNote {
 
                 return error::BlockValidationError::CHECKPOINT_BLOCK_HASH_MISMATCH;
             }
-        } else if (!currency.checkProofOfWork (cachedBlock, currentDifficulty)) {
+        } else if (!checkProofOfWork (cachedBlock, currentDifficulty)) {
             logger (Logging::WARNING)
                 << "Proof of work too weak for block "
                 << blockStr;
@@ -1349,6 +1516,12 @@ namespace CryptoNote {
                 if (cache == chainsLeaves[0]) {
                     mainChainStorage->pushBlock (rawBlock);
 
+                    /*!
+                        the main chain storage already holds the block, so if bulk
+                        writes are lost on a crash they get imported again on load
+                    */
+                    cache->setBulkSyncMode (blockTemplate.timestamp + BULK_SYNC_MIN_BLOCK_AGE < getAdjustedTime ());
+
                     cache->pushBlock (cachedBlock,
                                       transactions,
                                       validatorState,
@@ -1357,6 +1530,8 @@ namespace CryptoNote {
                                       currentDifficulty,
                                       std::move (rawBlock));
 
+                    pushWalletSyncBlock (cachedBlock, transactions);
+
                     updateBlockMedianSize ();
                     actualizePoolTransactionsLite (validatorState);
 
@@ -1403,6 +1578,7 @@ namespace CryptoNote {
                         copyTransactionsToPool (chainsLeaves[endpointIndex]);
 
                         switchMainChainStorage (chainsLeaves[0]->getStartBlockIndex (), *chainsLeaves[0]);
+                        switchWalletSyncBlocks (chainsLeaves[0]->getStartBlockIndex (), *chainsLeaves[0]);
 
                         ret = error::AddBlockErrorCode::ADDED_TO_ALTERNATIVE_AND_SWITCHED;
 
@@ -1768,6 +1944,11 @@ namespace CryptoNote {
 
     bool Core::addTransactionToPool(CachedTransaction &&cachedTransaction)
     {
+        static auto &addTransactionDuration = Metrics::Registry::instance ().histogram (
+            "core_add_transaction_to_pool_duration_seconds",
+            "Time spent validating and adding a single transaction to the pool");
+        Metrics::ScopedTimer timer (addTransactionDuration);
+
         TransactionValidatorState validatorState;
 
         if (!isTransactionValidForPool (cachedTransaction, validatorState)) {
@@ -1788,9 +1969,234 @@ namespace CryptoNote {
             << "Transaction "
             << transactionHash
             << " has been added to pool";
+        poolTransactionsAdded ().inc ();
         return true;
     }
 
+    /*!
+        Admission pipeline for relayed transactions. Everything that doesn't need chain state
+        (deserialization, semantic and key image domain checks, ring signatures) runs on worker
+        threads while the dispatcher keeps serving other contexts. Ring members are read and the
+        final key image conflict check and insertion are done on the dispatcher.
+    */
+    std::vector<bool> Core::addTransactionsToPool(const std::vector<BinaryArray> &transactionBinaryArrays)
+    {
+        throwIfNotInitialized ();
+
+        std::vector<bool> added (transactionBinaryArrays.size (), false);
+        if (transactionBinaryArrays.empty ()) {
+            return added;
+        }
+
+        const uint32_t blockIndex = getTopBlockIndex ();
+        const Crypto::Hash topBlockHash = getTopBlockHash ();
+
+        uint64_t minMixin;
+        uint64_t maxMixin;
+        uint64_t defaultMixin;
+        std::tie (minMixin, maxMixin, defaultMixin) = Utilities::getMixinAllowableRange (blockIndex);
+
+        std::vector<PoolTransactionCandidate> candidates (transactionBinaryArrays.size ());
+
+        runOnWorkerPool ([&]()
+        {
+            Utilities::parallelFor (candidates.size (), [&](size_t i)
+            {
+                auto &candidate = candidates[i];
+
+                Transaction transaction;
+                if (!fromBinaryArray<Transaction> (transaction, transactionBinaryArrays[i])) {
+                    candidate.rejectReason = "deserialization error";
+                    return;
+                }
+
+                candidate.transaction.emplace (std::move (transaction));
+                const auto &cachedTransaction = *candidate.transaction;
+                cachedTransaction.getTransactionHash ();
+                cachedTransaction.getTransactionPrefixHash ();
+
+                auto[success, mixinError] = Mixins::validate (cachedTransaction, minMixin, maxMixin);
+                if (!success) {
+                    candidate.rejectReason = mixinError;
+                    return;
+                }
+
+                if (cachedTransaction.getTransaction ().extra.size () >=
+                    CryptoNote::parameters::MAX_EXTRA_SIZE_V2) {
+                    candidate.rejectReason = "extra too large";
+                    return;
+                }
+
+                auto validationResult = validateSemantic (cachedTransaction.getTransaction (),
+                                                          candidate.fee,
+                                                          blockIndex,
+                                                          true);
+                if (validationResult != error::TransactionValidationError::VALIDATION_SUCCESS) {
+                    candidate.rejectReason = validationResult.message ();
+                    return;
+                }
+
+                candidate.valid = true;
+            });
+        });
+
+        for (auto &candidate : candidates) {
+            if (!candidate.valid) {
+                continue;
+            }
+
+            if (transactionPool->checkIfTransactionPresent (candidate.transaction->getTransactionHash ())) {
+                candidate.valid = false;
+                candidate.rejectReason = "already in pool";
+                continue;
+            }
+
+            auto error = extractRingKeys (*candidate.transaction,
+                                          chainsLeaves[0],
+                                          blockIndex,
+                                          candidate.ringKeys);
+            if (error) {
+                candidate.valid = false;
+                candidate.rejectReason = error.message ();
+            }
+        }
+
+        runOnWorkerPool ([&]()
+        {
+            Utilities::parallelFor (candidates.size (), [&](size_t i)
+            {
+                auto &candidate = candidates[i];
+                if (!candidate.valid) {
+                    return;
+                }
+
+                auto error = checkRingSignatures (*candidate.transaction, candidate.ringKeys);
+                if (error) {
+                    candidate.valid = false;
+                    candidate.rejectReason = error.message ();
+                }
+            });
+        });
+
+        /*!
+            the chain may have moved while the workers were busy, then ring members and
+            unlock times read above can be stale and the transaction is validated again in full
+        */
+        const bool chainChanged = getTopBlockHash () != topBlockHash;
+
+        for (size_t i = 0; i < candidates.size (); ++i) {
+            auto &candidate = candidates[i];
+            if (!candidate.valid) {
+                logger (Logging::DEBUGGING)
+                    << "Transaction "
+                    << (candidate.transaction ? Common::podToHex (candidate.transaction->getTransactionHash ())
+                                              : std::string ("<unparsed>"))
+                    << " is not valid. Reason: "
+                    << candidate.rejectReason;
+                continue;
+            }
+
+            auto transactionHash = candidate.transaction->getTransactionHash ();
+
+            if (chainChanged) {
+                added[i] = addTransactionToPool (std::move (*candidate.transaction));
+            } else {
+                TransactionValidatorState validatorState;
+                auto error = validateKeyImages (*candidate.transaction,
+                                                validatorState,
+                                                chainsLeaves[0],
+                                                getTopBlockIndex (),
+                                                false);
+                if (error) {
+                    if (logger.enabled (Logging::DEBUGGING)) {
+                        logger (Logging::DEBUGGING)
+                            << "Transaction "
+                            << transactionHash
+                            << " is not valid. Reason: "
+                            << error.message ();
+                    }
+                    continue;
+                }
+
+                if (!isTransactionSizeAndFeeValidForPool (*candidate.transaction, candidate.fee)) {
+                    continue;
+                }
+
+                if (!transactionPool->pushTransaction (std::move (*candidate.transaction),
+                                                       std::move (validatorState))) {
+                    logger (Logging::DEBUGGING)
+                        << "Failed to push transaction "
+                        << transactionHash
+                        << " to pool, already exists";
+                    continue;
+                }
+
+                logger (Logging::DEBUGGING)
+                    << "Transaction "
+                    << transactionHash
+                    << " has been added to pool";
+                poolTransactionsAdded ().inc ();
+                added[i] = true;
+            }
+
+            if (added[i]) {
+                notifyObservers (makeAddTransactionMessage ({transactionHash}));
+            }
+        }
+
+        return added;
+    }
+
+    /*!
+        Runs work on the shared worker pool while the dispatcher keeps serving other
+        contexts. While the pool queue is full the calling context sleeps instead of
+        queueing more, which also stops reading from the peer that sent the batch.
+    */
+    void Core::runOnWorkerPool(const std::function<void()> &work)
+    {
+        System::Event done (dispatcher);
+        std::exception_ptr error;
+
+        const std::function<void()> task = [this, &work, &done, &error]()
+        {
+            try {
+                work ();
+            } catch (...) {
+                error = std::current_exception ();
+            }
+
+            dispatcher.remoteSpawn ([&done]()
+            {
+                done.set ();
+            });
+        };
+
+        System::Timer timer (dispatcher);
+        while (!Utilities::ThreadPool::shared ().tryPush (std::function<void()> (task))) {
+            timer.sleep (WORKER_POOL_RETRY_INTERVAL);
+        }
+
+        /*!
+            the task refers to this frame, so wait for it even when interrupted
+        */
+        bool interrupted = false;
+        while (!done.get ()) {
+            try {
+                done.wait ();
+            } catch (System::InterruptedException &) {
+                interrupted = true;
+            }
+        }
+
+        if (interrupted) {
+            dispatcher.interrupt ();
+        }
+
+        if (error) {
+            std::rethrow_exception (error);
+        }
+    }
+
     bool Core::isTransactionValidForPool(const CachedTransaction &cachedTransaction,
                                          TransactionValidatorState &validatorState)
     {
@@ -1815,16 +2221,24 @@ namespace CryptoNote {
                                                          validatorState,
                                                          chainsLeaves[0],
                                                          fee,
-                                                         getTopBlockIndex ())) {
-            logger (Logging::DEBUGGING)
-                << "Transaction "
-                << cachedTransaction.getTransactionHash ()
-                << " is not valid. Reason: "
-                << validationResult.message ();
+                                                         getTopBlockIndex (),
+                                                         false)) {
+            if (logger.enabled (Logging::DEBUGGING)) {
+                logger (Logging::DEBUGGING)
+                    << "Transaction "
+                    << cachedTransaction.getTransactionHash ()
+                    << " is not valid. Reason: "
+                    << validationResult.message ();
+            }
 
             return false;
         }
 
+        return isTransactionSizeAndFeeValidForPool (cachedTransaction, fee);
+    }
+
+    bool Core::isTransactionSizeAndFeeValidForPool(const CachedTransaction &cachedTransaction, uint64_t fee)
+    {
         auto maxTransactionSize = getMaximumTransactionAllowedSize (blockMedianSize, currency);
         if (cachedTransaction.getTransactionBinaryArray ().size () > maxTransactionSize) {
             logger (Logging::WARNING)
@@ -2239,79 +2653,154 @@ namespace CryptoNote {
                                               TransactionValidatorState &state,
                                               IBlockchainCache *cache,
                                               uint64_t &fee,
-                                              uint32_t blockIndex)
+                                              uint32_t blockIndex,
+                                              bool pinnedByCheckpoint)
     {
+        static auto &validateDuration = Metrics::Registry::instance ().histogram (
+            "core_validate_transaction_duration_seconds",
+            "Time spent validating a transaction against the chain");
+        Metrics::ScopedTimer timer (validateDuration);
+
+        /*!
+            Transactions of a block below the last checkpoint are pinned by the checkpoint
+            hashes, so only the checks needed to index them are run: no curve checks, no
+            chain lookups for spent key images and no ring signatures. Only block import
+            sets pinnedByCheckpoint, pool transactions are always checked in full.
+        */
+        const bool fastSync = pinnedByCheckpoint;
+
         // TransactionValidatorState currentState;
         const auto &transaction = cachedTransaction.getTransaction ();
-        auto error = validateSemantic (transaction, fee, blockIndex);
+        auto error = validateSemantic (transaction, fee, blockIndex, !fastSync);
         if (error != error::TransactionValidationError::VALIDATION_SUCCESS) {
             return error;
         }
 
-        size_t inputIndex = 0;
-        for (const auto &input : transaction.inputs) {
-            if (input.type () == typeid (KeyInput)) {
-                const KeyInput &in = boost::get<KeyInput> (input);
-                if (!state.spentKeyImages.insert (in.keyImage).second) {
-                    return error::TransactionValidationError::INPUT_KEYIMAGE_ALREADY_SPENT;
-                }
+        error = validateKeyImages (cachedTransaction, state, cache, blockIndex, pinnedByCheckpoint);
+        if (error != error::TransactionValidationError::VALIDATION_SUCCESS) {
+            return error;
+        }
 
-                if (!checkpoints.isInCheckpointZone (blockIndex + 1)) {
-                    if (cache->checkIfSpent (in.keyImage, blockIndex)) {
-                        return error::TransactionValidationError::INPUT_KEYIMAGE_ALREADY_SPENT;
-                    }
+        if (fastSync) {
+            return error::TransactionValidationError::VALIDATION_SUCCESS;
+        }
 
-                    std::vector<PublicKey> outputKeys;
-                    assert(!in.outputIndexes.empty ());
+        std::vector<std::vector<Crypto::PublicKey>> ringKeys;
+        error = extractRingKeys (cachedTransaction, cache, blockIndex, ringKeys);
+        if (error != error::TransactionValidationError::VALIDATION_SUCCESS) {
+            return error;
+        }
 
-                    std::vector<uint32_t> globalIndexes (in.outputIndexes.size ());
-                    globalIndexes[0] = in.outputIndexes[0];
-                    for (size_t i = 1; i < in.outputIndexes.size (); ++i) {
-                        globalIndexes[i] = globalIndexes[i - 1] + in.outputIndexes[i];
-                    }
+        return checkRingSignatures (cachedTransaction, ringKeys);
+    }
 
-                    auto result = cache->extractKeyOutputKeys (in.amount,
-                                                               blockIndex,
-                                                               {
-                                                                   globalIndexes.data (),
-                                                                   globalIndexes.size ()
-                                                               },
-                                                               outputKeys);
-                    if (result == ExtractOutputKeysResult::INVALID_GLOBAL_INDEX) {
-                        return error::TransactionValidationError::INPUT_INVALID_GLOBAL_INDEX;
-                    }
+    std::error_code Core::validateKeyImages(const CachedTransaction &cachedTransaction,
+                                            TransactionValidatorState &state,
+                                            IBlockchainCache *cache,
+                                            uint32_t blockIndex,
+                                            bool pinnedByCheckpoint)
+    {
+        const bool checkChain = !pinnedByCheckpoint;
 
-                    if (result == ExtractOutputKeysResult::OUTPUT_LOCKED) {
-                        return error::TransactionValidationError::INPUT_SPEND_LOCKED_OUT;
-                    }
+        for (const auto &input : cachedTransaction.getTransaction ().inputs) {
+            if (input.type () != typeid (KeyInput)) {
+                assert(false);
 
-                    if (blockIndex >=
-                        CryptoNote::parameters::TRANSACTION_SIGNATURE_COUNT_VALIDATION_HEIGHT &&
-                        outputKeys.size () !=
-                        cachedTransaction.getTransaction ().signatures[inputIndex].size ()) {
-                        return error::TransactionValidationError::INPUT_INVALID_SIGNATURES_COUNT;
-                    }
+                return error::TransactionValidationError::INPUT_UNKNOWN_TYPE;
+            }
 
-                    if (!Crypto::CryptoOps::checkRingSignature (cachedTransaction.getTransactionPrefixHash (),
-                                                                in.keyImage,
-                                                                outputKeys,
-                                                                transaction.signatures[inputIndex])) {
-                        return error::TransactionValidationError::INPUT_INVALID_SIGNATURES;
-                    }
-                }
-            } else {
-                assert(false);
+            const KeyInput &in = boost::get<KeyInput> (input);
+            if (!state.spentKeyImages.insert (in.keyImage).second) {
+                return error::TransactionValidationError::INPUT_KEYIMAGE_ALREADY_SPENT;
+            }
 
+            if (checkChain && cache->checkIfSpent (in.keyImage, blockIndex)) {
+                return error::TransactionValidationError::INPUT_KEYIMAGE_ALREADY_SPENT;
+            }
+        }
+
+        return error::TransactionValidationError::VALIDATION_SUCCESS;
+    }
+
+    std::error_code Core::extractRingKeys(const CachedTransaction &cachedTransaction,
+                                          IBlockchainCache *cache,
+                                          uint32_t blockIndex,
+                                          std::vector<std::vector<Crypto::PublicKey>> &ringKeys)
+    {
+        const auto &transaction = cachedTransaction.getTransaction ();
+        ringKeys.clear ();
+        ringKeys.reserve (transaction.inputs.size ());
+
+        size_t inputIndex = 0;
+        for (const auto &input : transaction.inputs) {
+            if (input.type () != typeid (KeyInput)) {
                 return error::TransactionValidationError::INPUT_UNKNOWN_TYPE;
             }
+
+            const KeyInput &in = boost::get<KeyInput> (input);
+            std::vector<PublicKey> outputKeys;
+            assert(!in.outputIndexes.empty ());
+
+            std::vector<uint32_t> globalIndexes (in.outputIndexes.size ());
+            globalIndexes[0] = in.outputIndexes[0];
+            for (size_t i = 1; i < in.outputIndexes.size (); ++i) {
+                globalIndexes[i] = globalIndexes[i - 1] + in.outputIndexes[i];
+            }
+
+            auto result = cache->extractKeyOutputKeys (in.amount,
+                                                       blockIndex,
+                                                       {
+                                                           globalIndexes.data (),
+                                                           globalIndexes.size ()
+                                                       },
+                                                       outputKeys);
+            if (result == ExtractOutputKeysResult::INVALID_GLOBAL_INDEX) {
+                return error::TransactionValidationError::INPUT_INVALID_GLOBAL_INDEX;
+            }
+
+            if (result == ExtractOutputKeysResult::OUTPUT_LOCKED) {
+                return error::TransactionValidationError::INPUT_SPEND_LOCKED_OUT;
+            }
+
+            if (blockIndex >=
+                CryptoNote::parameters::TRANSACTION_SIGNATURE_COUNT_VALIDATION_HEIGHT &&
+                outputKeys.size () != transaction.signatures[inputIndex].size ()) {
+                return error::TransactionValidationError::INPUT_INVALID_SIGNATURES_COUNT;
+            }
+
+            ringKeys.push_back (std::move (outputKeys));
             inputIndex++;
         }
+
+        return error::TransactionValidationError::VALIDATION_SUCCESS;
+    }
+
+    /*!
+        Pure CPU work on the transaction and its ring members, safe to call off the dispatcher
+    */
+    std::error_code Core::checkRingSignatures(const CachedTransaction &cachedTransaction,
+                                              const std::vector<std::vector<Crypto::PublicKey>> &ringKeys)
+    {
+        const auto &transaction = cachedTransaction.getTransaction ();
+        assert(ringKeys.size () == transaction.inputs.size ());
+
+        for (size_t inputIndex = 0; inputIndex < transaction.inputs.size (); ++inputIndex) {
+            const KeyInput &in = boost::get<KeyInput> (transaction.inputs[inputIndex]);
+            if (!Crypto::CryptoOps::checkRingSignature (cachedTransaction.getTransactionPrefixHash (),
+                                                        in.keyImage,
+                                                        ringKeys[inputIndex],
+                                                        transaction.signatures[inputIndex])) {
+                return error::TransactionValidationError::INPUT_INVALID_SIGNATURES;
+            }
+        }
+
         return error::TransactionValidationError::VALIDATION_SUCCESS;
     }
 
     std::error_code Core::validateSemantic(const Transaction &transaction,
                                            uint64_t &fee,
-                                           uint32_t blockIndex)
+                                           uint32_t blockIndex,
+                                           bool checkKeys)
     {
         if (transaction.inputs.empty ()) {
             return error::TransactionValidationError::EMPTY_INPUTS;
@@ -2336,7 +2825,7 @@ namespace CryptoNote {
             }
 
             if (output.target.type () == typeid (KeyOutput)) {
-                if (!checkKey (boost::get<KeyOutput> (output.target).key)) {
+                if (checkKeys && !checkKey (boost::get<KeyOutput> (output.target).key)) {
                     return error::TransactionValidationError::OUTPUT_INVALID_KEY;
                 }
             } else {
@@ -2402,7 +2891,7 @@ namespace CryptoNote {
                     so first can be zero, others can't
                     Fix discovered by Monero Lab and suggested by "fluffypony" (bitcointalk.org)
                 */
-                if (!(scalarmultKey (in.keyImage, L) == I)) {
+                if (checkKeys && !(scalarmultKey (in.keyImage, L) == I)) {
                     return error::TransactionValidationError::INPUT_INVALID_DOMAIN_KEYIMAGES;
                 }
 
@@ -2469,6 +2958,8 @@ namespace CryptoNote {
 
         minerReward = 0;
 
+        const bool checkKeys = !checkpoints.isInCheckpointZone (cachedBlock.getBlockIndex ());
+
         if (upgradeManager->getBlockMajorVersion (cachedBlock.getBlockIndex ()) != block.majorVersion) {
             return error::BlockValidationError::WRONG_VERSION;
         }
@@ -2540,7 +3031,7 @@ namespace CryptoNote {
             }
 
             if (output.target.type () == typeid (KeyOutput)) {
-                if (!checkKey (boost::get<KeyOutput> (output.target).key)) {
+                if (checkKeys && !checkKey (boost::get<KeyOutput> (output.target).key)) {
                     return error::TransactionValidationError::OUTPUT_INVALID_KEY;
                 }
             } else {
@@ -2557,6 +3048,23 @@ namespace CryptoNote {
         return error::BlockValidationError::VALIDATION_SUCCESS;
     }
 
+    bool Core::checkProofOfWork(const CachedBlock &cachedBlock, uint64_t currentDifficulty)
+    {
+        Crypto::Hash longHash;
+        const bool cached = longHashCache.find (cachedBlock.getBlockHash (), longHash);
+        if (cached) {
+            cachedBlock.setBlockLongHash (longHash);
+        }
+
+        const bool result = currency.checkProofOfWork (cachedBlock, currentDifficulty);
+
+        if (!cached && cachedBlock.hasBlockLongHash ()) {
+            longHashCache.insert (cachedBlock.getBlockHash (), cachedBlock.getBlockLongHash ());
+        }
+
+        return result;
+    }
+
     uint64_t CryptoNote::Core::getAdjustedTime() const
     {
         return time (NULL);
@@ -2651,8 +3159,14 @@ namespace CryptoNote {
 
         auto previousBlockHash = getBlockHash (mainChainStorage->getBlockByIndex (commonIndex));
         auto blockCount = mainChainStorage->getBlockCount ();
-        for (uint32_t i = commonIndex + 1; i < blockCount; ++i) {
-            RawBlock rawBlock = mainChainStorage->getBlockByIndex (i);
+
+        chainsLeaves[0]->setBulkSyncMode (true);
+
+        /*!
+            a sequential scan instead of one lookup per index
+        */
+        mainChainStorage->forEachBlock (commonIndex + 1, [&](uint32_t i, RawBlock &&rawBlock)
+        {
             auto blockTemplate = extractBlockTemplate (rawBlock);
             CachedBlock cachedBlock (blockTemplate);
 
@@ -2725,7 +3239,9 @@ namespace CryptoNote {
                     << " / "
                     << (blockCount - 1);
             }
-        }
+        });
+
+        chainsLeaves[0]->setBulkSyncMode (false);
     }
 
     void Core::cutSegment(IBlockchainCache &segment, uint32_t startIndex)
@@ -21,6 +21,7 @@
 #pragma once
 
 #include <ctime>
+#include <deque>
 #include <vector>
 #include <unordered_map>
 
@@ -30,6 +31,7 @@
 #include <CryptoNoteCore/Blockchain/IBlockchainCache.h>
 #include <CryptoNoteCore/Blockchain/IBlockchainCacheFactory.h>
 #include <CryptoNoteCore/Blockchain/IMainChainStorage.h>
+#include <CryptoNoteCore/Blockchain/LongHashCache.h>
 #include <CryptoNoteCore/Blockchain/LMDB/BlockchainDB.h>
 #include <CryptoNoteCore/Transactions/CachedTransaction.h>
 #include <CryptoNoteCore/Transactions/ITransactionPool.h>
@@ -150,6 +152,7 @@ namespace CryptoNote {
                                                                  std::vector<uint64_t>> &indexes) const override;
 
         virtual bool addTransactionToPool(const BinaryArray &transactionBinaryArray) override;
+        virtual std::vector<bool> addTransactionsToPool(const std::vector<BinaryArray> &transactionBinaryArrays) override;
 
         virtual std::vector<Crypto::Hash> getPoolTransactionHashes() const override;
         virtual std::tuple<bool, BinaryArray> getPoolTransaction(const Crypto::Hash &transactionHash) const override;
@@ -222,19 +225,46 @@ namespace CryptoNote {
 
         size_t blockMedianSize;
 
+        /*!
+            Wallet sync records of the most recent main chain blocks, oldest first.
+            Filled when blocks are added to the main chain and cut back on chain switch,
+            so the tip range most wallets ask for is served without touching the database.
+        */
+        std::deque<WalletTypes::WalletBlockInfo> walletSyncBlocks;
+
+        LongHashCache longHashCache;
+
         void throwIfNotInitialized() const;
         bool extractTransactions(const std::vector<BinaryArray> &rawTransactions,
                                  std::vector<CachedTransaction> &transactions,
                                  uint64_t &cumulativeSize);
 
+        /*!
+            checkKeys selects the curve checks on output keys and key images, they are
+            skipped for blocks anchored by checkpoints
+        */
         std::error_code validateSemantic(const Transaction &transaction,
                                          uint64_t &fee,
-                                         uint32_t blockIndex);
+                                         uint32_t blockIndex,
+                                         bool checkKeys);
         std::error_code validateTransaction(const CachedTransaction &transaction,
                                             TransactionValidatorState &state,
                                             IBlockchainCache *cache,
                                             uint64_t &fee,
-                                            uint32_t blockIndex);
+                                            uint32_t blockIndex,
+                                            bool pinnedByCheckpoint);
+        std::error_code validateKeyImages(const CachedTransaction &cachedTransaction,
+                                          TransactionValidatorState &state,
+                                          IBlockchainCache *cache,
+                                          uint32_t blockIndex,
+                                          bool pinnedByCheckpoint);
+        std::error_code extractRingKeys(const CachedTransaction &cachedTransaction,
+                                        IBlockchainCache *cache,
+                                        uint32_t blockIndex,
+                                        std::vector<std::vector<Crypto::PublicKey>> &ringKeys);
+        static std::error_code checkRingSignatures(const CachedTransaction &cachedTransaction,
+                                                   const std::vector<std::vector<Crypto::PublicKey>> &ringKeys);
+        void runOnWorkerPool(const std::function<void()> &work);
 
         uint32_t findBlockchainSupplement(const std::vector<Crypto::Hash> &remoteBlockIds) const;
         std::vector<Crypto::Hash> getBlockHashes(uint32_t startBlockIndex, uint32_t maxCount) const;
@@ -242,6 +272,7 @@ namespace CryptoNote {
         std::error_code validateBlock(const CachedBlock &block,
                                       IBlockchainCache *cache,
                                       uint64_t &minerReward);
+        bool checkProofOfWork(const CachedBlock &cachedBlock, uint64_t currentDifficulty);
 
         uint64_t getAdjustedTime() const;
         void updateMainChainSet();
@@ -325,6 +356,7 @@ namespace CryptoNote {
         bool addTransactionToPool(CachedTransaction &&cachedTransaction);
         bool isTransactionValidForPool(const CachedTransaction &cachedTransaction,
                                        TransactionValidatorState &validatorState);
+        bool isTransactionSizeAndFeeValidForPool(const CachedTransaction &cachedTransaction, uint64_t fee);
 
         void initRootSegment();
         void importBlocksFromStorage();
@@ -332,8 +364,21 @@ namespace CryptoNote {
 
         void switchMainChainStorage(uint32_t splitBlockIndex, IBlockchainCache &newChain);
 
+        void pushWalletSyncBlock(const CachedBlock &cachedBlock,
+                                 const std::vector<CachedTransaction> &transactions);
+        void switchWalletSyncBlocks(uint32_t splitBlockIndex, IBlockchainCache &newChain);
+        bool getCachedWalletSyncData(uint64_t startIndex,
+                                     uint64_t endIndex,
+                                     uint64_t blockCount,
+                                     bool skipCoinbaseTransactions,
+                                     const Crypto::Hash &topBlockHash,
+                                     std::vector<WalletTypes::WalletBlockInfo> &walletBlocks) const;
+
         static WalletTypes::RawCoinbaseTransaction getRawCoinbaseTransaction(const CryptoNote::Transaction &t);
 
         static WalletTypes::RawTransaction getRawTransaction(const std::vector<uint8_t> &rawTX);
+
+        static WalletTypes::RawTransaction getRawTransaction(const CryptoNote::Transaction &t,
+                                                             const Crypto::Hash &hash);
     };
 } // namespace CryptoNote
@@ -67,8 +67,18 @@ namespace CryptoNote {
 
         const std::string TRANSACTIONS_COUNT_KEY = "txs_count";
 
+        const std::string SPENT_KEY_IMAGE_FILTER_KEY = "spent_key_image_filter";
+
         const std::string KEY_OUTPUT_KEY_PREFIX = "j";
 
+        const std::string KEY_OUTPUT_AMOUNT_BLOCK_COUNT_PREFIX = "k";
+
+        const std::string KEY_OUTPUT_AMOUNT_LOCKED_PREFIX = "l";
+
+        const std::string NON_EMPTY_BLOCK_INDEX_PREFIX = "m";
+
+        const std::string NON_EMPTY_BLOCKS_COUNT_KEY = "non_empty_blocks_count";
+
         template<class Value>
         std::string serialize(const Value &value, const std::string &name)
         {
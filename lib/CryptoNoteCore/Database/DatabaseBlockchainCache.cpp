@@ -22,10 +22,10 @@
 #include <ctime>
 #include <cstdlib>
 
-#include <boost/iterator/iterator_facade.hpp>
-
 #include <Common/CryptoNoteTools.h>
+#include <Common/Metrics.h>
 #include <Common/ShuffleGenerator.h>
+#include <Common/StringTools.h>
 #include <Common/Util.h>
 
 #include <Crypto/Hash.h>
@@ -61,7 +61,53 @@ namespace CryptoNote {
 
         const std::string DB_VERSION_KEY = "db_scheme_version";
 
-        const uint32_t CURRENT_DB_SCHEME_VERSION = 2;
+        /*!
+            3: per amount key output index and non empty block index
+        */
+        const uint32_t CURRENT_DB_SCHEME_VERSION = 3;
+
+        const uint32_t KEY_OUTPUT_INDEX_REBUILD_BATCH_SIZE = 1000;
+
+        const uint32_t SPENT_KEY_IMAGE_FILTER_REBUILD_BATCH_SIZE = 1000;
+
+        const uint32_t DECOY_TABLE_LOAD_BATCH_SIZE = 10000;
+
+        /*!
+            public key plus unlock time per output
+        */
+        const size_t DECOY_TABLE_ENTRY_SIZE = sizeof (Crypto::PublicKey) + sizeof (uint64_t);
+
+        const size_t DECOY_TABLES_MEMORY_LIMIT = 256 * 1024 * 1024;
+
+        /*!
+            the filter is sized for twice the key images it's built with, so it
+            stays below its designed false positive rate while the chain grows
+        */
+        const uint64_t SPENT_KEY_IMAGE_FILTER_GROWTH_FACTOR = 2;
+
+        const uint64_t SPENT_KEY_IMAGE_FILTER_MIN_CAPACITY = 1 << 20;
+
+        const uint32_t NON_EMPTY_BLOCKS_REBUILD_BATCH_SIZE = 1000;
+
+        /*!
+            estimated database room a bulk sync transaction takes before it is committed.
+            LMDB can only grow its map in between transactions, so this has to stay well
+            below the room the wrapper reserves for one (LMDB::BULK_WRITE_MIN_AVAIL)
+        */
+        const size_t BULK_SYNC_COMMIT_SIZE = 128 * 1024 * 1024;
+
+        CachedBlockInfo toCachedBlockInfo(const BlockInfoT &blockInfo)
+        {
+            CachedBlockInfo cachedBlockInfo;
+            cachedBlockInfo.blockHash = blockInfo.hash;
+            cachedBlockInfo.timestamp = blockInfo.timestamp;
+            cachedBlockInfo.cumulativeDifficulty = blockInfo.cumulativeDifficulty;
+            cachedBlockInfo.alreadyGeneratedCoins = blockInfo.alreadyGeneratedCoins;
+            cachedBlockInfo.alreadyGeneratedTransactions = blockInfo.alreadyGeneratedTransactions;
+            cachedBlockInfo.blockSize = static_cast<uint32_t>(blockInfo.blockSize);
+
+            return cachedBlockInfo;
+        }
 
         bool requestPackedOutputs(IBlockchainCache::Amount amount,
                                   Common::ArrayView<uint32_t> globalIndexes,
@@ -357,87 +403,6 @@ namespace CryptoNote {
             }
         }
 
-        class DbOutputConstIterator: public boost::iterator_facade<DbOutputConstIterator,
-                                                                   const PackedOutIndex,
-                                                                   boost::random_access_traversal_tag
-            /*boost::forward_traversal_tag*/>
-        {
-        public:
-            DbOutputConstIterator(std::function<PackedOutIndex(IBlockchainCache::Amount amount,
-                                                               uint32_t globalOutputIndex)> retriever_,
-                                  IBlockchainCache::Amount amount_,
-                                  uint32_t globalOutputIndex_)
-                : retriever (retriever_),
-                  amount (amount_),
-                  globalOutputIndex (globalOutputIndex_)
-            {
-            }
-
-            const PackedOutIndex &dereference() const
-            {
-                cachedValue = retriever (amount, globalOutputIndex);
-                return cachedValue;
-            }
-
-            bool equal(const DbOutputConstIterator &other) const
-            {
-                return globalOutputIndex == other.globalOutputIndex;
-            }
-
-            void increment()
-            {
-                ++globalOutputIndex;
-            }
-
-            void decrement()
-            {
-                --globalOutputIndex;
-            }
-
-            void advance(difference_type n)
-            {
-                assert(n >= -static_cast<difference_type>(globalOutputIndex));
-                globalOutputIndex += static_cast<uint32_t>(n);
-            }
-
-            difference_type distance_to(const DbOutputConstIterator &to) const
-            {
-                return static_cast<difference_type>(to.globalOutputIndex) -
-                       static_cast<difference_type>(globalOutputIndex);
-            }
-
-        private:
-            std::function<PackedOutIndex(IBlockchainCache::Amount amount,
-                                         uint32_t globalOutputIndex)> retriever;
-            IBlockchainCache::Amount amount;
-            uint32_t globalOutputIndex;
-            mutable PackedOutIndex cachedValue;
-        };
-
-        PackedOutIndex retrieveKeyOutput(IBlockchainCache::Amount amount,
-                                         uint32_t globalOutputIndex,
-                                         IDataBase &database)
-        {
-            BlockchainReadBatch batch;
-            auto dbError = database.read (batch.requestKeyOutputGlobalIndexForAmount (amount, globalOutputIndex));
-            if (dbError) {
-                throw std::system_error (dbError,
-                                         "Error during retrieving key output by global output index");
-            }
-
-            auto result = batch.extractResult ();
-
-            try {
-                return result.getKeyOutputGlobalIndexesForAmounts ().at (std::make_pair (amount, globalOutputIndex));
-            } catch (std::exception &) {
-                assert(false);
-                throw std::runtime_error ("Couldn't find key output for amount " +
-                                          std::to_string (amount) +
-                                          " with global output index " +
-                                          std::to_string (globalOutputIndex));
-            }
-        }
-
         std::map<IBlockchainCache::Amount, IBlockchainCache::GlobalOutputIndex>
         getMinGlobalIndexesByAmount(const std::map<IBlockchainCache::Amount,
                                                    std::vector<IBlockchainCache::GlobalOutputIndex>> &outputIndexes)
@@ -486,7 +451,61 @@ namespace CryptoNote {
                          cache.end ());
         }
 
+        class DatabaseVersionReadBatch: public IReadBatch
+        {
+        public:
+            virtual ~DatabaseVersionReadBatch() = default;
+
+            virtual std::vector<std::string> getRawKeys() const override
+            {
+                return {DB_VERSION_KEY};
+            }
+
+            virtual void submitRawResult(const std::vector<std::string> &values,
+                                         const std::vector<bool> &resultStates) override
+            {
+                assert(values.size () == 1);
+                assert(resultStates.size () == values.size ());
+
+                if (!resultStates[0]) {
+                    return;
+                }
+
+                version = Common::fromString<uint32_t> (values[0]);
+            }
+
+            boost::optional<uint32_t> getDbSchemeVersion() const
+            {
+                return version;
+            }
+
+        private:
+            boost::optional<uint32_t> version;
+        };
+
+        class DatabaseVersionWriteBatch: public IWriteBatch
+        {
+        public:
+            explicit DatabaseVersionWriteBatch(uint32_t version)
+                : schemeVersion (version)
+            {
+            }
+
+            virtual ~DatabaseVersionWriteBatch() = default;
+
+            virtual std::vector<std::pair<std::string, std::string>> extractRawDataToInsert() override
+            {
+                return {std::make_pair (DB_VERSION_KEY, std::to_string (schemeVersion))};
+            }
+
+            virtual std::vector<std::string> extractRawKeysToRemove() override
+            {
+                return {};
+            }
 
+        private:
+            uint32_t schemeVersion;
+        };
 
     } // namespace
 
@@ -531,6 +550,130 @@ namespace CryptoNote {
                 << "top block index is nill, add genesis block";
             addGenesisBlock (CachedBlock (currency.genesisBlock ()));
         }
+
+        migrateDatabase ();
+        loadNonEmptyBlockIndexes ();
+        loadSpentKeyImageFilter ();
+    }
+
+    /*!
+        Indexes added by a scheme version are built here once, so the read paths
+        only ever load them. Every index is rebuilt from scratch and overwrites what
+        the database holds, so a migration interrupted by a crash just runs again.
+    */
+    void DatabaseBlockchainCache::migrateDatabase()
+    {
+        DatabaseVersionReadBatch versionBatch;
+        auto res = database.read (versionBatch);
+        if (res) {
+            logger (Logging::ERROR)
+                << "migrateDatabase: failed to read db scheme version: "
+                << res.message ();
+            throw std::runtime_error (res.message ());
+        }
+
+        auto version = versionBatch.getDbSchemeVersion ();
+        if (version && *version >= CURRENT_DB_SCHEME_VERSION) {
+            return;
+        }
+
+        logger (Logging::INFO)
+            << "Migrating database to scheme version "
+            << CURRENT_DB_SCHEME_VERSION
+            << ", this may take a while";
+
+        rebuildKeyOutputAmountIndexes ();
+        rebuildNonEmptyBlockIndexes ();
+
+        DatabaseVersionWriteBatch versionWriteBatch (CURRENT_DB_SCHEME_VERSION);
+        res = database.write (versionWriteBatch);
+        if (res) {
+            logger (Logging::ERROR)
+                << "migrateDatabase: failed to write db scheme version: "
+                << res.message ();
+            throw std::runtime_error (res.message ());
+        }
+
+        logger (Logging::INFO)
+            << "Database migrated to scheme version "
+            << CURRENT_DB_SCHEME_VERSION;
+    }
+
+    /*!
+        The filter snapshot is written by save () and consumed here, so a node which
+        wasn't shut down cleanly always rebuilds it from the stored key images.
+    */
+    void DatabaseBlockchainCache::loadSpentKeyImageFilter()
+    {
+        auto batch = BlockchainReadBatch ().requestSpentKeyImageFilter ();
+        auto res = database.read (batch);
+        if (!res) {
+            auto result = batch.extractResult ();
+            const auto &stored = result.getSpentKeyImageFilter ();
+            if (stored.second &&
+                stored.first.isBuilt () &&
+                !stored.first.isSaturated () &&
+                stored.first.getTopBlockIndex () == getTopBlockIndex () &&
+                stored.first.getTopBlockHash () == getTopBlockHash ()) {
+                spentKeyImageFilter = stored.first;
+
+                BlockchainWriteBatch removeBatch;
+                removeBatch.removeSpentKeyImageFilter ();
+                res = database.write (removeBatch);
+                if (!res) {
+                    logger (Logging::DEBUGGING)
+                        << "Loaded spent key image filter with "
+                        << spentKeyImageFilter.getInsertedCount ()
+                        << " key images";
+                    return;
+                }
+            }
+        }
+
+        rebuildSpentKeyImageFilter ();
+    }
+
+    void DatabaseBlockchainCache::rebuildSpentKeyImageFilter()
+    {
+        uint32_t blocksCount = getTopBlockIndex () + 1;
+        uint64_t capacity = std::max (getCachedTransactionsCount () * SPENT_KEY_IMAGE_FILTER_GROWTH_FACTOR,
+                                      SPENT_KEY_IMAGE_FILTER_MIN_CAPACITY);
+
+        logger (Logging::INFO)
+            << "Building spent key image filter for "
+            << blocksCount
+            << " blocks";
+
+        /*!
+            transactions count is only an estimate, if the chain holds more key
+            images than that the filter is built once more with the real count
+        */
+        do {
+            spentKeyImageFilter.reset (capacity);
+
+            for (uint32_t begin = 0; begin < blocksCount; begin += SPENT_KEY_IMAGE_FILTER_REBUILD_BATCH_SIZE) {
+                uint32_t end = std::min (begin + SPENT_KEY_IMAGE_FILTER_REBUILD_BATCH_SIZE, blocksCount);
+
+                BlockchainReadBatch batch;
+                for (uint32_t blockIndex = begin; blockIndex < end; ++blockIndex) {
+                    batch.requestSpentKeyImagesByBlock (blockIndex);
+                }
+
+                auto result = readDatabase (batch);
+                for (const auto &spentKeyImages : result.getSpentKeyImagesByBlock ()) {
+                    for (const auto &keyImage : spentKeyImages.second) {
+                        spentKeyImageFilter.insert (keyImage);
+                    }
+                }
+            }
+
+            capacity = spentKeyImageFilter.getInsertedCount () * SPENT_KEY_IMAGE_FILTER_GROWTH_FACTOR;
+        } while (spentKeyImageFilter.isSaturated ());
+
+        logger (Logging::INFO)
+            << "Spent key image filter built with "
+            << spentKeyImageFilter.getInsertedCount ()
+            << " key images";
     }
 
     void DatabaseBlockchainCache::deleteClosestTimestampBlockIndex(BlockchainWriteBatch &writeBatch,
@@ -585,6 +728,11 @@ namespace CryptoNote {
             << " started, top block index: "
             << getTopBlockIndex ();
 
+        /*!
+            removing blocks reads the payment id and timestamp indexes back
+        */
+        flushDeferredIndexes ();
+
         auto cache = blockchainCacheFactory.createBlockchainCache (currency, this, splitBlockIndex);
 
 
@@ -600,6 +748,12 @@ namespace CryptoNote {
         for (uint32_t blockIndex = splitBlockIndex; blockIndex <= currentTop; ++blockIndex) {
             ExtendedPushedBlockInfo extendedInfo = getExtendedPushedBlockInfo (blockIndex);
 
+            /*!
+                popBlock drops the block's spent key images, their filter bits stay
+                set and only count towards the next rebuild
+            */
+            spentKeyImageFilter.markRemoved (extendedInfo.pushedBlockInfo.validatorState.spentKeyImages.size ());
+
             auto block = mDb->getBlockFromHeight(blockIndex);
             std::vector<CryptoNote::Transaction> txHashes = mDb->getTxList(block.transactionHashes);
             logger (Logging::DEBUGGING)
@@ -649,6 +803,8 @@ namespace CryptoNote {
 
         deleteClosestTimestampBlockIndex (writeBatch, splitBlockIndex);
 
+        requestDeleteNonEmptyBlockIndexes (writeBatch, splitBlockIndex);
+
         logger (Logging::DEBUGGING)
             << "Performing delete operations";
 
@@ -815,6 +971,41 @@ namespace CryptoNote {
             writeBatch.removeKeyOutputInfo (amount, index);
         }
 
+        auto &amountIndex = getKeyOutputAmountIndex (amount);
+        auto blockCountsEnd = std::find_if (amountIndex.blockCounts.begin (),
+                                            amountIndex.blockCounts.end (),
+                                            [boundary](const KeyOutputBlockCount &blockCount)
+                                            {
+                                                return blockCount.outputsCount > boundary;
+                                            });
+        auto lockedOutputsEnd = std::lower_bound (amountIndex.lockedOutputs.begin (),
+                                                  amountIndex.lockedOutputs.end (),
+                                                  boundary,
+                                                  [](const LockedKeyOutput &lockedOutput,
+                                                     GlobalOutputIndex boundary)
+                                                  {
+                                                      return lockedOutput.globalIndex < boundary;
+                                                  });
+        amountIndex.blockCounts.erase (blockCountsEnd, amountIndex.blockCounts.end ());
+        amountIndex.lockedOutputs.erase (lockedOutputsEnd, amountIndex.lockedOutputs.end ());
+        truncateDecoyTable (amount, boundary);
+
+        auto blockCountsSize = static_cast<uint32_t>(amountIndex.blockCounts.size ());
+        if (amountIndex.storedBlockCounts > blockCountsSize) {
+            writeBatch.removeKeyOutputBlockCounts (amount,
+                                                   amountIndex.storedBlockCounts - blockCountsSize,
+                                                   blockCountsSize);
+            amountIndex.storedBlockCounts = blockCountsSize;
+        }
+
+        auto lockedOutputsSize = static_cast<uint32_t>(amountIndex.lockedOutputs.size ());
+        if (amountIndex.storedLockedOutputs > lockedOutputsSize) {
+            writeBatch.removeLockedKeyOutputs (amount,
+                                               amountIndex.storedLockedOutputs - lockedOutputsSize,
+                                               lockedOutputsSize);
+            amountIndex.storedLockedOutputs = lockedOutputsSize;
+        }
+
         updateKeyOutputCount (amount, boundary - outputsCount);
     }
 
@@ -851,7 +1042,8 @@ namespace CryptoNote {
     void DatabaseBlockchainCache::pushTransaction(const CachedTransaction &cachedTransaction,
                                                   uint32_t blockIndex,
                                                   uint16_t transactionBlockIndex,
-                                                  BlockchainWriteBatch &batch)
+                                                  BlockchainWriteBatch &batch,
+                                                  PendingKeyOutputs &pendingKeyOutputs)
     {
         bool r = !Tools::isLmdb();
         logger (Logging::TRACE)
@@ -904,6 +1096,7 @@ namespace CryptoNote {
                 outputInfo.outputIndex = poi.outputIndex;
 
                 batch.insertKeyOutputInfo (output.amount, globalIndex, outputInfo);
+                pendingKeyOutputs[output.amount].push_back ({globalIndex, outputInfo.publicKey, outputInfo.unlockTime});
             }
         }
 
@@ -915,59 +1108,579 @@ namespace CryptoNote {
                                                 updateKeyOutputCount (amountToOutputs.first, 0));
         }
 
-        if (!newKeyAmounts.empty ()) {
-            assert(keyOutputAmountsCount.is_initialized ());
-            batch.insertKeyOutputAmounts (newKeyAmounts, *keyOutputAmountsCount);
+        if (!newKeyAmounts.empty ()) {
+            assert(keyOutputAmountsCount.is_initialized ());
+            batch.insertKeyOutputAmounts (newKeyAmounts, *keyOutputAmountsCount);
+        }
+
+        Crypto::Hash paymentId;
+        if (getPaymentIdFromTxExtra (cachedTransaction.getTransaction ().extra, paymentId)) {
+            if (bulkSyncMode) {
+                deferredPaymentIds[paymentId].push_back (cachedTransaction.getTransactionHash ());
+            } else {
+                insertPaymentId (batch, cachedTransaction.getTransactionHash (), paymentId);
+            }
+        }
+
+        batch.insertCachedTransaction (transactionCacheInfo, getCachedTransactionsCount () + 1);
+        transactionsCount = *transactionsCount + 1;
+        logger (Logging::TRACE)
+            << "push transaction with hash "
+            << cachedTransaction.getTransactionHash ()
+            << " finished";
+    }
+
+    uint32_t DatabaseBlockchainCache::updateKeyOutputCount(Amount amount,
+                                                           int32_t diff) const
+    {
+        auto it = keyOutputCountsForAmounts.find (amount);
+        if (it == keyOutputCountsForAmounts.end ()) {
+            logger (Logging::TRACE)
+                << "updateKeyOutputCount: failed to found key for amount, request database";
+
+            BlockchainReadBatch batch;
+            auto result = readDatabase (batch.requestKeyOutputGlobalIndexesCountForAmount (amount));
+            auto found = result.getKeyOutputGlobalIndexesCountForAmounts ().find (amount);
+            auto val = found != result.getKeyOutputGlobalIndexesCountForAmounts ().end () ? found->second : 0;
+            it = keyOutputCountsForAmounts.insert ({amount, val}).first;
+            logger (Logging::TRACE)
+                << "updateKeyOutputCount: database replied: amount "
+                << amount
+                << " value "
+                << val;
+
+            if (val == 0) {
+                if (!keyOutputAmountsCount) {
+                    auto result = readDatabase (batch.requestKeyOutputAmountsCount ());
+                    keyOutputAmountsCount = result.getKeyOutputAmountsCount ();
+                }
+
+                keyOutputAmountsCount = *keyOutputAmountsCount + 1;
+            }
+        } else if (!keyOutputAmountsCount) {
+            auto result = readDatabase (BlockchainReadBatch ().requestKeyOutputAmountsCount ());
+            keyOutputAmountsCount = result.getKeyOutputAmountsCount ();
+        }
+
+        it->second += diff;
+        assert(it->second >= 0);
+        return it->second;
+    }
+
+    DatabaseBlockchainCache::KeyOutputAmountIndex &
+    DatabaseBlockchainCache::getKeyOutputAmountIndex(Amount amount) const
+    {
+        auto it = keyOutputAmountIndexes.find (amount);
+        if (it != keyOutputAmountIndexes.end ()) {
+            return it->second;
+        }
+
+        KeyOutputAmountIndex index;
+
+        BlockchainReadBatch countsBatch;
+        countsBatch.requestKeyOutputBlockCountsCountForAmount (amount)
+                   .requestLockedKeyOutputsCountForAmount (amount);
+        auto countsResult = readDatabase (countsBatch);
+
+        auto blockCountsIt = countsResult.getKeyOutputBlockCountsCountForAmounts ().find (amount);
+        if (blockCountsIt == countsResult.getKeyOutputBlockCountsCountForAmounts ().end () ||
+            blockCountsIt->second == 0) {
+            /*!
+                amount has no outputs yet, migrateDatabase () built the index of all others
+            */
+            return keyOutputAmountIndexes.emplace (amount, std::move (index)).first->second;
+        }
+
+        auto lockedIt = countsResult.getLockedKeyOutputsCountForAmounts ().find (amount);
+        index.storedBlockCounts = blockCountsIt->second;
+        index.storedLockedOutputs = lockedIt != countsResult.getLockedKeyOutputsCountForAmounts ().end ()
+                                    ? lockedIt->second
+                                    : 0;
+
+        BlockchainReadBatch entriesBatch;
+        for (uint32_t i = 0; i < index.storedBlockCounts; ++i) {
+            entriesBatch.requestKeyOutputBlockCountForAmount (amount, i);
+        }
+
+        for (uint32_t i = 0; i < index.storedLockedOutputs; ++i) {
+            entriesBatch.requestLockedKeyOutputForAmount (amount, i);
+        }
+
+        auto entriesResult = readDatabase (entriesBatch);
+        const auto &blockCounts = entriesResult.getKeyOutputBlockCountsForAmounts ();
+        const auto &lockedOutputs = entriesResult.getLockedKeyOutputsForAmounts ();
+        if (blockCounts.size () != index.storedBlockCounts ||
+            lockedOutputs.size () != index.storedLockedOutputs) {
+            logger (Logging::ERROR)
+                << "getKeyOutputAmountIndex: key output index for amount "
+                << amount
+                << " is incomplete";
+            throw std::runtime_error ("Couldn't read key output index");
+        }
+
+        index.blockCounts.resize (index.storedBlockCounts);
+        for (const auto &kv : blockCounts) {
+            index.blockCounts[kv.first.second] = kv.second;
+        }
+
+        index.lockedOutputs.resize (index.storedLockedOutputs);
+        for (const auto &kv : lockedOutputs) {
+            index.lockedOutputs[kv.first.second] = kv.second;
+        }
+
+        return keyOutputAmountIndexes.emplace (amount, std::move (index)).first->second;
+    }
+
+    void DatabaseBlockchainCache::rebuildKeyOutputAmountIndexes()
+    {
+        auto countResult = readDatabase (BlockchainReadBatch ().requestKeyOutputAmountsCount ());
+        const uint32_t amountsCount = countResult.getKeyOutputAmountsCount ();
+
+        logger (Logging::INFO)
+            << "Building key output index for "
+            << amountsCount
+            << " amounts";
+
+        for (uint32_t begin = 0; begin < amountsCount; begin += KEY_OUTPUT_INDEX_REBUILD_BATCH_SIZE) {
+            uint32_t end = std::min (begin + KEY_OUTPUT_INDEX_REBUILD_BATCH_SIZE, amountsCount);
+
+            BlockchainReadBatch batch;
+            for (uint32_t amountId = begin; amountId < end; ++amountId) {
+                batch.requestKeyOutputAmount (amountId);
+            }
+
+            auto result = readDatabase (batch);
+            for (const auto &amount : result.getKeyOutputAmounts ()) {
+                rebuildKeyOutputAmountIndex (amount.second);
+            }
+        }
+
+        /*!
+            indexes loaded before the migration may be outdated
+        */
+        keyOutputAmountIndexes.clear ();
+    }
+
+    void DatabaseBlockchainCache::rebuildKeyOutputAmountIndex(Amount amount)
+    {
+        const uint32_t outputsCount = requestKeyOutputGlobalIndexesCountForAmount (amount, database);
+        KeyOutputAmountIndex index;
+
+        logger (Logging::DEBUGGING)
+            << "Building key output index for amount "
+            << amount
+            << ", "
+            << outputsCount
+            << " outputs";
+
+        for (uint32_t begin = 0; begin < outputsCount; begin += KEY_OUTPUT_INDEX_REBUILD_BATCH_SIZE) {
+            uint32_t end = std::min (begin + KEY_OUTPUT_INDEX_REBUILD_BATCH_SIZE, outputsCount);
+
+            BlockchainReadBatch batch;
+            for (uint32_t globalIndex = begin; globalIndex < end; ++globalIndex) {
+                batch.requestKeyOutputGlobalIndexForAmount (amount, globalIndex)
+                     .requestKeyOutputInfo (amount, globalIndex);
+            }
+
+            auto result = readDatabase (batch);
+            for (uint32_t globalIndex = begin; globalIndex < end; ++globalIndex) {
+                auto key = std::make_pair (amount, globalIndex);
+                auto outIt = result.getKeyOutputGlobalIndexesForAmounts ().find (key);
+                auto infoIt = result.getKeyOutputInfo ().find (key);
+                if (outIt == result.getKeyOutputGlobalIndexesForAmounts ().end () ||
+                    infoIt == result.getKeyOutputInfo ().end ()) {
+                    logger (Logging::ERROR)
+                        << "rebuildKeyOutputAmountIndex: missing key output "
+                        << globalIndex
+                        << " for amount "
+                        << amount;
+                    throw std::runtime_error ("Couldn't rebuild key output index");
+                }
+
+                uint32_t blockIndex = outIt->second.blockIndex;
+                if (index.blockCounts.empty () || index.blockCounts.back ().blockIndex != blockIndex) {
+                    index.blockCounts.push_back ({blockIndex, 0});
+                }
+
+                index.blockCounts.back ().outputsCount = globalIndex + 1;
+
+                if (isKeyOutputLockedPastUnlockWindow (infoIt->second.unlockTime, blockIndex)) {
+                    index.lockedOutputs.push_back ({globalIndex, infoIt->second.unlockTime});
+                }
+            }
+        }
+
+        BlockchainWriteBatch writeBatch;
+        writeBatch.insertKeyOutputBlockCounts (amount,
+                                               index.blockCounts,
+                                               static_cast<uint32_t>(index.blockCounts.size ()));
+        writeBatch.insertLockedKeyOutputs (amount,
+                                           index.lockedOutputs,
+                                           static_cast<uint32_t>(index.lockedOutputs.size ()));
+
+        auto res = database.write (writeBatch);
+        if (res) {
+            logger (Logging::ERROR)
+                << "rebuildKeyOutputAmountIndex: write failed: "
+                << res.message ();
+            throw std::runtime_error (res.message ());
+        }
+    }
+
+    /*!
+        All key outputs of a block share one block count entry per amount, the
+        in memory index only follows in pushKeyOutputsToAmountIndexes () once the
+        batch is written
+    */
+    void DatabaseBlockchainCache::requestInsertKeyOutputAmountIndexes(BlockchainWriteBatch &batch,
+                                                                      uint32_t blockIndex,
+                                                                      const PendingKeyOutputs &pendingKeyOutputs)
+    {
+        for (const auto &pending : pendingKeyOutputs) {
+            const auto &index = getKeyOutputAmountIndex (pending.first);
+            assert(index.blockCounts.empty () || index.blockCounts.back ().blockIndex < blockIndex);
+            assert(index.storedBlockCounts == index.blockCounts.size ());
+            assert(index.storedLockedOutputs == index.lockedOutputs.size ());
+
+            batch.insertKeyOutputBlockCounts (pending.first,
+                                              {{blockIndex, pending.second.back ().globalIndex + 1}},
+                                              static_cast<uint32_t>(index.blockCounts.size () + 1));
+
+            std::vector<LockedKeyOutput> lockedOutputs;
+            for (const auto &output : pending.second) {
+                if (isKeyOutputLockedPastUnlockWindow (output.unlockTime, blockIndex)) {
+                    lockedOutputs.push_back ({output.globalIndex, output.unlockTime});
+                }
+            }
+
+            if (!lockedOutputs.empty ()) {
+                batch.insertLockedKeyOutputs (pending.first,
+                                              lockedOutputs,
+                                              static_cast<uint32_t>(index.lockedOutputs.size ()
+                                                                    + lockedOutputs.size ()));
+            }
+        }
+    }
+
+    void DatabaseBlockchainCache::pushKeyOutputsToAmountIndexes(uint32_t blockIndex,
+                                                                const PendingKeyOutputs &pendingKeyOutputs)
+    {
+        for (const auto &pending : pendingKeyOutputs) {
+            auto &index = getKeyOutputAmountIndex (pending.first);
+
+            index.blockCounts.push_back ({blockIndex, pending.second.back ().globalIndex + 1});
+            for (const auto &output : pending.second) {
+                if (isKeyOutputLockedPastUnlockWindow (output.unlockTime, blockIndex)) {
+                    index.lockedOutputs.push_back ({output.globalIndex, output.unlockTime});
+                }
+            }
+
+            index.storedBlockCounts = static_cast<uint32_t>(index.blockCounts.size ());
+            index.storedLockedOutputs = static_cast<uint32_t>(index.lockedOutputs.size ());
+        }
+    }
+
+    DatabaseBlockchainCache::DecoyTable *DatabaseBlockchainCache::findDecoyTable(Amount amount) const
+    {
+        auto it = decoyTables.find (amount);
+        if (it == decoyTables.end ()) {
+            return nullptr;
+        }
+
+        it->second.lastUsed = ++decoyTablesClock;
+
+        return &it->second;
+    }
+
+    /*!
+        Reads at most one batch of the outputs missing from the table of the amount,
+        so the first requests for a big amount don't stall the dispatcher. Until the
+        table is complete, lookups past its end go to the database.
+    */
+    void DatabaseBlockchainCache::extendDecoyTable(Amount amount) const
+    {
+        const uint32_t outputsCount = updateKeyOutputCount (amount, 0);
+
+        /*!
+            amounts too big for the limit keep being served from the database
+        */
+        if (outputsCount == 0 || outputsCount * DECOY_TABLE_ENTRY_SIZE > DECOY_TABLES_MEMORY_LIMIT) {
+            return;
+        }
+
+        auto &table = decoyTables[amount];
+        table.lastUsed = ++decoyTablesClock;
+
+        const uint32_t start = static_cast<uint32_t>(table.publicKeys.size ());
+        if (start >= outputsCount) {
+            return;
+        }
+
+        const uint32_t end = std::min (start + DECOY_TABLE_LOAD_BATCH_SIZE, outputsCount);
+
+        /*!
+            the table is the most recently used one and the whole of it fits, so
+            only other tables are dropped here
+        */
+        evictDecoyTables (DECOY_TABLES_MEMORY_LIMIT - (end - start) * DECOY_TABLE_ENTRY_SIZE);
+
+        BlockchainReadBatch batch;
+        for (uint32_t globalIndex = start; globalIndex < end; ++globalIndex) {
+            batch.requestKeyOutputInfo (amount, globalIndex);
+        }
+
+        auto result = readDatabase (batch);
+        const auto &keyOutputs = result.getKeyOutputInfo ();
+
+        for (uint32_t globalIndex = start; globalIndex < end; ++globalIndex) {
+            auto found = keyOutputs.find (std::make_pair (amount, globalIndex));
+            if (found == keyOutputs.end ()) {
+                logger (Logging::DEBUGGING)
+                    << "extendDecoyTable: key output "
+                    << globalIndex
+                    << " for amount "
+                    << amount
+                    << " not found";
+                break;
+            }
+
+            table.publicKeys.push_back (found->second.publicKey);
+            table.unlockTimes.push_back (found->second.unlockTime);
+            decoyTablesMemoryUsage += DECOY_TABLE_ENTRY_SIZE;
+        }
+
+        publishDecoyTablesMemoryUsage ();
+
+        if (table.publicKeys.size () == outputsCount) {
+            logger (Logging::INFO)
+                << "Loaded decoy table for amount "
+                << amount
+                << " with "
+                << outputsCount
+                << " outputs, decoy tables now use "
+                << decoyTablesMemoryUsage / (1024 * 1024)
+                << " MB of "
+                << DECOY_TABLES_MEMORY_LIMIT / (1024 * 1024)
+                << " MB";
+        }
+    }
+
+    void DatabaseBlockchainCache::evictDecoyTables(size_t targetUsage) const
+    {
+        while (decoyTablesMemoryUsage > targetUsage && !decoyTables.empty ()) {
+            auto oldest = std::min_element (decoyTables.begin (),
+                                            decoyTables.end (),
+                                            [](const auto &lhs, const auto &rhs)
+                                            {
+                                                return lhs.second.lastUsed < rhs.second.lastUsed;
+                                            });
+
+            decoyTablesMemoryUsage -= oldest->second.publicKeys.size () * DECOY_TABLE_ENTRY_SIZE;
+
+            logger (Logging::DEBUGGING)
+                << "Dropping decoy table for amount "
+                << oldest->first
+                << ", decoy tables now use "
+                << decoyTablesMemoryUsage / (1024 * 1024)
+                << " MB";
+
+            decoyTables.erase (oldest);
+        }
+    }
+
+    /*!
+        Only tables that reach the new outputs are extended, the others pick them
+        up from the database when they grow that far.
+    */
+    void DatabaseBlockchainCache::pushKeyOutputsToDecoyTables(const PendingKeyOutputs &pendingKeyOutputs)
+    {
+        bool changed = false;
+
+        for (const auto &pending : pendingKeyOutputs) {
+            auto it = decoyTables.find (pending.first);
+            if (it == decoyTables.end ()) {
+                continue;
+            }
+
+            auto &table = it->second;
+
+            for (const auto &output : pending.second) {
+                if (table.publicKeys.size () != output.globalIndex) {
+                    continue;
+                }
+
+                table.publicKeys.push_back (output.publicKey);
+                table.unlockTimes.push_back (output.unlockTime);
+                decoyTablesMemoryUsage += DECOY_TABLE_ENTRY_SIZE;
+                changed = true;
+            }
+        }
+
+        if (changed) {
+            evictDecoyTables (DECOY_TABLES_MEMORY_LIMIT);
+            publishDecoyTablesMemoryUsage ();
+        }
+    }
+
+    void DatabaseBlockchainCache::truncateDecoyTable(Amount amount, GlobalOutputIndex boundary)
+    {
+        auto it = decoyTables.find (amount);
+        if (it == decoyTables.end () || it->second.publicKeys.size () <= boundary) {
+            return;
+        }
+
+        auto &table = it->second;
+
+        decoyTablesMemoryUsage -= (table.publicKeys.size () - boundary) * DECOY_TABLE_ENTRY_SIZE;
+        table.publicKeys.resize (boundary);
+        table.unlockTimes.resize (boundary);
+
+        publishDecoyTablesMemoryUsage ();
+    }
+
+    void DatabaseBlockchainCache::publishDecoyTablesMemoryUsage() const
+    {
+        static auto &memoryUsage = Metrics::Registry::instance ().gauge (
+            "core_decoy_tables_bytes",
+            "Memory held by the in memory decoy tables");
+
+        memoryUsage.set (static_cast<int64_t>(decoyTablesMemoryUsage));
+    }
+
+    void DatabaseBlockchainCache::loadNonEmptyBlockIndexes()
+    {
+        std::vector<uint32_t> indexes;
+
+        auto countBatch = BlockchainReadBatch ().requestNonEmptyBlocksCount ();
+        auto countResult = readDatabase (countBatch);
+        uint32_t count = countResult.getNonEmptyBlocksCount ().second
+                         ? countResult.getNonEmptyBlocksCount ().first
+                         : 0;
+        indexes.reserve (count);
+
+        for (uint32_t begin = 0; begin < count; begin += NON_EMPTY_BLOCKS_REBUILD_BATCH_SIZE) {
+            uint32_t end = std::min (begin + NON_EMPTY_BLOCKS_REBUILD_BATCH_SIZE, count);
+
+            BlockchainReadBatch batch;
+            for (uint32_t i = begin; i < end; ++i) {
+                batch.requestNonEmptyBlockIndex (i);
+            }
+
+            auto result = readDatabase (batch);
+            const auto &entries = result.getNonEmptyBlockIndexes ();
+            for (uint32_t i = begin; i < end; ++i) {
+                auto it = entries.find (i);
+                if (it == entries.end ()) {
+                    logger (Logging::ERROR)
+                        << "loadNonEmptyBlockIndexes: non empty block index "
+                        << i
+                        << " is missing";
+                    throw std::runtime_error ("Couldn't read non empty block index");
+                }
+
+                indexes.push_back (it->second);
+            }
+        }
+
+        nonEmptyBlockIndexes = std::move (indexes);
+    }
+
+    void DatabaseBlockchainCache::rebuildNonEmptyBlockIndexes()
+    {
+        std::vector<uint32_t> indexes;
+        uint32_t blocksCount = getTopBlockIndex () + 1;
+
+        logger (Logging::INFO)
+            << "Building non empty block index for "
+            << blocksCount
+            << " blocks";
+
+        for (uint32_t begin = 0; begin < blocksCount; begin += NON_EMPTY_BLOCKS_REBUILD_BATCH_SIZE) {
+            uint32_t end = std::min (begin + NON_EMPTY_BLOCKS_REBUILD_BATCH_SIZE, blocksCount);
+
+            BlockchainReadBatch batch;
+            for (uint32_t blockIndex = begin; blockIndex < end; ++blockIndex) {
+                batch.requestTransactionHashesByBlock (blockIndex);
+            }
+
+            auto result = readDatabase (batch);
+            const auto &transactionHashes = result.getTransactionHashesByBlocks ();
+            for (uint32_t blockIndex = begin; blockIndex < end; ++blockIndex) {
+                auto it = transactionHashes.find (blockIndex);
+
+                /*!
+                    the first hash is always the coinbase transaction
+                */
+                if (it != transactionHashes.end () && it->second.size () > 1) {
+                    indexes.push_back (blockIndex);
+                }
+            }
         }
 
-        Crypto::Hash paymentId;
-        if (getPaymentIdFromTxExtra (cachedTransaction.getTransaction ().extra, paymentId)) {
-            insertPaymentId (batch, cachedTransaction.getTransactionHash (), paymentId);
+        BlockchainWriteBatch writeBatch;
+        writeBatch.insertNonEmptyBlockIndexes (indexes, static_cast<uint32_t>(indexes.size ()));
+        auto res = database.write (writeBatch);
+        if (res) {
+            logger (Logging::ERROR)
+                << "rebuildNonEmptyBlockIndexes: write failed: "
+                << res.message ();
+            throw std::runtime_error (res.message ());
         }
 
-        batch.insertCachedTransaction (transactionCacheInfo, getCachedTransactionsCount () + 1);
-        transactionsCount = *transactionsCount + 1;
-        logger (Logging::TRACE)
-            << "push transaction with hash "
-            << cachedTransaction.getTransactionHash ()
-            << " finished";
+        logger (Logging::INFO)
+            << "Non empty block index built, "
+            << indexes.size ()
+            << " blocks with transactions";
     }
 
-    uint32_t DatabaseBlockchainCache::updateKeyOutputCount(Amount amount,
-                                                           int32_t diff) const
+    void DatabaseBlockchainCache::requestDeleteNonEmptyBlockIndexes(BlockchainWriteBatch &writeBatch,
+                                                                    uint32_t splitBlockIndex)
     {
-        auto it = keyOutputCountsForAmounts.find (amount);
-        if (it == keyOutputCountsForAmounts.end ()) {
-            logger (Logging::TRACE)
-                << "updateKeyOutputCount: failed to found key for amount, request database";
+        auto &nonEmptyBlocks = nonEmptyBlockIndexes;
 
-            BlockchainReadBatch batch;
-            auto result = readDatabase (batch.requestKeyOutputGlobalIndexesCountForAmount (amount));
-            auto found = result.getKeyOutputGlobalIndexesCountForAmounts ().find (amount);
-            auto val = found != result.getKeyOutputGlobalIndexesCountForAmounts ().end () ? found->second : 0;
-            it = keyOutputCountsForAmounts.insert ({amount, val}).first;
-            logger (Logging::TRACE)
-                << "updateKeyOutputCount: database replied: amount "
-                << amount
-                << " value "
-                << val;
+        auto splitIt = std::lower_bound (nonEmptyBlocks.begin (), nonEmptyBlocks.end (), splitBlockIndex);
+        auto removeCount = static_cast<uint32_t>(std::distance (splitIt, nonEmptyBlocks.end ()));
+        if (removeCount == 0) {
+            return;
+        }
 
-            if (val == 0) {
-                if (!keyOutputAmountsCount) {
-                    auto result = readDatabase (batch.requestKeyOutputAmountsCount ());
-                    keyOutputAmountsCount = result.getKeyOutputAmountsCount ();
-                }
+        nonEmptyBlocks.erase (splitIt, nonEmptyBlocks.end ());
+        writeBatch.removeNonEmptyBlockIndexes (removeCount, static_cast<uint32_t>(nonEmptyBlocks.size ()));
+    }
 
-                keyOutputAmountsCount = *keyOutputAmountsCount + 1;
-            }
-        } else if (!keyOutputAmountsCount) {
-            auto result = readDatabase (BlockchainReadBatch ().requestKeyOutputAmountsCount ());
-            keyOutputAmountsCount = result.getKeyOutputAmountsCount ();
+    /*!
+        Decoys are only taken from blocks at least minedMoneyUnlockWindow deep, so an output
+        needs an exception entry only if its own unlock time may still be in the future then.
+    */
+    bool DatabaseBlockchainCache::isKeyOutputLockedPastUnlockWindow(uint64_t unlockTime,
+                                                                    uint32_t blockIndex) const
+    {
+        if (unlockTime == 0) {
+            return false;
         }
 
-        it->second += diff;
-        assert(it->second >= 0);
-        return it->second;
+        if (unlockTime >= currency.maxBlockHeight ()) {
+            return true;
+        }
+
+        return unlockTime > static_cast<uint64_t>(blockIndex) +
+                            currency.minedMoneyUnlockWindow () +
+                            currency.lockedTxAllowedDeltaBlocks ();
+    }
+
+    uint32_t DatabaseBlockchainCache::getKeyOutputsCountUpToBlock(const KeyOutputAmountIndex &index,
+                                                                  uint32_t blockIndex) const
+    {
+        auto it = std::upper_bound (index.blockCounts.begin (),
+                                    index.blockCounts.end (),
+                                    blockIndex,
+                                    [](uint32_t blockIndex,
+                                       const KeyOutputBlockCount &blockCount)
+                                    {
+                                        return blockIndex < blockCount.blockIndex;
+                                    });
+
+        return it == index.blockCounts.begin () ? 0 : std::prev (it)->outputsCount;
     }
 
     void DatabaseBlockchainCache::insertPaymentId(BlockchainWriteBatch &batch,
@@ -1006,6 +1719,93 @@ namespace CryptoNote {
         batch.insertTimestamp (timestamp, blockHashes);
     }
 
+    void DatabaseBlockchainCache::flushDeferredIndexes() const
+    {
+        if (deferredPaymentIds.empty () && deferredBlockTimestamps.empty ()) {
+            return;
+        }
+
+        BlockchainReadBatch readBatch;
+        for (const auto &paymentId : deferredPaymentIds) {
+            readBatch.requestTransactionCountByPaymentId (paymentId.first);
+        }
+
+        for (const auto &timestamp : deferredBlockTimestamps) {
+            readBatch.requestBlockHashesByTimestamp (timestamp.first);
+        }
+
+        auto readResult = readDatabase (readBatch);
+        const auto &storedCounts = readResult.getTransactionCountByPaymentIds ();
+        const auto &storedHashes = readResult.getBlockHashesByTimestamp ();
+
+        BlockchainWriteBatch batch;
+        for (const auto &paymentId : deferredPaymentIds) {
+            auto it = storedCounts.find (paymentId.first);
+            uint32_t count = it != storedCounts.end () ? it->second : 0;
+
+            for (const auto &transactionHash : paymentId.second) {
+                batch.insertPaymentId (transactionHash, paymentId.first, ++count);
+            }
+        }
+
+        for (const auto &timestamp : deferredBlockTimestamps) {
+            std::vector<Crypto::Hash> blockHashes;
+
+            auto it = storedHashes.find (timestamp.first);
+            if (it != storedHashes.end ()) {
+                blockHashes = it->second;
+            }
+
+            blockHashes.insert (blockHashes.end (), timestamp.second.begin (), timestamp.second.end ());
+            batch.insertTimestamp (timestamp.first, blockHashes);
+        }
+
+        auto res = database.write (batch);
+        if (res) {
+            logger (Logging::ERROR)
+                << "flush of deferred payment id and timestamp indexes failed: "
+                << res.message ();
+            throw std::runtime_error (res.message ());
+        }
+
+        deferredPaymentIds.clear ();
+        deferredBlockTimestamps.clear ();
+    }
+
+    void DatabaseBlockchainCache::commitBulkSync()
+    {
+        flushDeferredIndexes ();
+
+        logger (Logging::DEBUGGING)
+            << "Committing bulk sync transaction at block index "
+            << getTopBlockIndex ();
+        database.commitBulkWrite ();
+    }
+
+    void DatabaseBlockchainCache::setBulkSyncMode(bool enable)
+    {
+        if (enable == bulkSyncMode) {
+            return;
+        }
+
+        if (enable) {
+            logger (Logging::DEBUGGING)
+                << "Entering bulk sync mode at block index "
+                << getTopBlockIndex ();
+            database.beginBulkWrite ();
+            bulkSyncMode = true;
+            return;
+        }
+
+        flushDeferredIndexes ();
+        bulkSyncMode = false;
+        database.endBulkWrite ();
+
+        logger (Logging::DEBUGGING)
+            << "Left bulk sync mode at block index "
+            << getTopBlockIndex ();
+    }
+
     void DatabaseBlockchainCache::pushBlock(const CachedBlock &cachedBlock,
                                             const std::vector<CachedTransaction> &cachedTransactions,
                                             BlockVerificationContext &bVC,
@@ -1047,6 +1847,11 @@ namespace CryptoNote {
 
         batch.insertSpentKeyImages (getTopBlockIndex () + 1, validatorState.spentKeyImages);
 
+        if (!cachedTransactions.empty ()) {
+            batch.insertNonEmptyBlockIndexes ({getTopBlockIndex () + 1},
+                                              static_cast<uint32_t>(nonEmptyBlockIndexes.size () + 1));
+        }
+
         auto txHashes = cachedBlock.getBlock ().transactionHashes;
         auto baseTransaction = cachedBlock.getBlock ().baseTransaction;
         auto cachedBaseTransaction = CachedTransaction{std::move (baseTransaction)};
@@ -1057,13 +1862,16 @@ namespace CryptoNote {
         batch.insertCachedBlock (blockInfo, getTopBlockIndex () + 1, txHashes);
         batch.insertRawBlock (getTopBlockIndex () + 1, std::move (rawBlock));
 
+        PendingKeyOutputs pendingKeyOutputs;
         auto transactionIndex = 0;
-        pushTransaction (cachedBaseTransaction, getTopBlockIndex () + 1, transactionIndex++, batch);
+        pushTransaction (cachedBaseTransaction, getTopBlockIndex () + 1, transactionIndex++, batch, pendingKeyOutputs);
 
         for (const auto &transaction: cachedTransactions) {
-            pushTransaction (transaction, getTopBlockIndex () + 1, transactionIndex++, batch);
+            pushTransaction (transaction, getTopBlockIndex () + 1, transactionIndex++, batch, pendingKeyOutputs);
         }
 
+        requestInsertKeyOutputAmountIndexes (batch, getTopBlockIndex () + 1, pendingKeyOutputs);
+
         auto closestBlockIndexDb = requestClosestBlockIndexByTimestamp (
             roundToMidnight (cachedBlock.getBlock ().timestamp),
             database);
@@ -1080,9 +1888,13 @@ namespace CryptoNote {
                                                     getTopBlockIndex () + 1);
         }
 
-        insertBlockTimestamp (batch,
-                              cachedBlock.getBlock ().timestamp,
-                              cachedBlock.getBlockHash ());
+        if (bulkSyncMode) {
+            deferredBlockTimestamps[cachedBlock.getBlock ().timestamp].push_back (cachedBlock.getBlockHash ());
+        } else {
+            insertBlockTimestamp (batch,
+                                  cachedBlock.getBlock ().timestamp,
+                                  cachedBlock.getBlockHash ());
+        }
 
         auto res = database.write (batch);
         if (res) {
@@ -1094,6 +1906,17 @@ namespace CryptoNote {
             throw std::runtime_error (res.message ());
         }
 
+        for (const auto &keyImage : validatorState.spentKeyImages) {
+            spentKeyImageFilter.insert (keyImage);
+        }
+
+        if (!cachedTransactions.empty ()) {
+            nonEmptyBlockIndexes.push_back (getTopBlockIndex () + 1);
+        }
+
+        pushKeyOutputsToAmountIndexes (getTopBlockIndex () + 1, pendingKeyOutputs);
+        pushKeyOutputsToDecoyTables (pendingKeyOutputs);
+
         topBlockIndex = *topBlockIndex + 1;
         topBlockHash = cachedBlock.getBlockHash ();
         logger (Logging::TRACE)
@@ -1105,6 +1928,10 @@ namespace CryptoNote {
         if (unitsCache.size () > unitsCacheSize) {
             unitsCache.pop_front ();
         }
+
+        if (bulkSyncMode && database.getBulkWriteSize () >= BULK_SYNC_COMMIT_SIZE) {
+            commitBulkSync ();
+        }
     }
 
     PushedBlockInfo DatabaseBlockchainCache::getPushedBlockInfo(uint32_t blockIndex) const
@@ -1115,6 +1942,10 @@ namespace CryptoNote {
     bool DatabaseBlockchainCache::checkIfSpent(const Crypto::KeyImage &keyImage,
                                                uint32_t blockIndex) const
     {
+        if (!spentKeyImageFilter.mayContain (keyImage)) {
+            return false;
+        }
+
         auto batch = BlockchainReadBatch ().requestBlockIndexBySpentKeyImage (keyImage);
         auto res = database.read (batch);
         if (res) {
@@ -1191,31 +2022,48 @@ namespace CryptoNote {
                                                   Common::ArrayView<uint32_t> globalIndexes,
                                                   std::vector<Crypto::PublicKey> &publicKeys) const
     {
-        return extractKeyOutputs (amount,
-                                  blockIndex,
-                                  globalIndexes,
-                                  [
-                                      this,
-                                      &publicKeys,
-                                      blockIndex
-                                  ](const CachedTransactionInfo &info,
-                                    PackedOutIndex index,
-                                    uint32_t globalIndex)
-                                  {
-                                      if (!isTransactionSpendTimeUnlocked (info.unlockTime, blockIndex)) {
-                                          logger (Logging::DEBUGGING)
-                                              << "extractKeyOutputKeys: output "
-                                              << globalIndex
-                                              << " is locked";
-                                          return ExtractOutputKeysResult::OUTPUT_LOCKED;
-                                      }
-
-                                      auto &output = info.outputs[index.outputIndex];
-                                      assert(output.type () == typeid (KeyOutput));
-                                      publicKeys.push_back (boost::get<KeyOutput> (output).key);
+        const DecoyTable *table = findDecoyTable (amount);
+        if (table != nullptr && std::all_of (globalIndexes.begin (),
+                                             globalIndexes.end (),
+                                             [table](uint32_t globalIndex)
+                                             {
+                                                 return globalIndex < table->publicKeys.size ();
+                                             })) {
+            publicKeys.reserve (publicKeys.size () + globalIndexes.getSize ());
+            for (const uint32_t globalIndex : globalIndexes) {
+                if (!isTransactionSpendTimeUnlocked (table->unlockTimes[globalIndex], blockIndex)) {
+                    logger (Logging::DEBUGGING)
+                        << "extractKeyOutputKeys: output "
+                        << globalIndex
+                        << " is locked";
+                    return ExtractOutputKeysResult::OUTPUT_LOCKED;
+                }
 
-                                      return ExtractOutputKeysResult::SUCCESS;
-                                  });
+                publicKeys.push_back (table->publicKeys[globalIndex]);
+            }
+
+            return ExtractOutputKeysResult::SUCCESS;
+        }
+
+        std::vector<KeyOutputInfo> outputs;
+        if (!requestKeyOutputInfos (amount, globalIndexes, outputs)) {
+            return ExtractOutputKeysResult::INVALID_GLOBAL_INDEX;
+        }
+
+        publicKeys.reserve (publicKeys.size () + outputs.size ());
+        for (size_t i = 0; i < outputs.size (); ++i) {
+            if (!isTransactionSpendTimeUnlocked (outputs[i].unlockTime, blockIndex)) {
+                logger (Logging::DEBUGGING)
+                    << "extractKeyOutputKeys: output "
+                    << globalIndexes[i]
+                    << " is locked";
+                return ExtractOutputKeysResult::OUTPUT_LOCKED;
+            }
+
+            publicKeys.push_back (outputs[i].publicKey);
+        }
+
+        return ExtractOutputKeysResult::SUCCESS;
     }
 
     ExtractOutputKeysResult
@@ -1434,15 +2282,10 @@ namespace CryptoNote {
 
     CachedBlockInfo DatabaseBlockchainCache::getCachedBlockInfo(uint32_t index) const
     {
-        CachedBlockInfo blockInfo;
-        blockInfo.blockHash = mDb->getBlockHashFromHeight(index);
-        blockInfo.timestamp = mDb->getBlockTimestamp(index);
-        blockInfo.cumulativeDifficulty = mDb->getBlockDifficulty(index);
-        blockInfo.alreadyGeneratedCoins = mDb->getBlockAlreadyGeneratedCoins(index);
-        blockInfo.alreadyGeneratedTransactions = mDb->getBlockAlreadyGeneratedTransactions(index);
-        blockInfo.blockSize = mDb->getBlockSize(index);
+        auto blockInfos = mDb->getBlockInfoRange (index, index);
+        assert(blockInfos.size () == 1);
 
-        return blockInfo;
+        return toCachedBlockInfo (blockInfos[0]);
     }
 
     uint64_t DatabaseBlockchainCache::getAlreadyGeneratedCoins() const
@@ -1510,29 +2353,28 @@ namespace CryptoNote {
             readFrom += 1;
         }
 
-        uint32_t toRead = blockIndex - readFrom + 1;
         std::vector<CachedBlockInfo> units;
-        units.reserve (toRead);
-
-        const uint32_t step = 200;
-        while (toRead > 0) {
-            auto next = std::min (toRead, step);
-            toRead -= next;
-
-            BlockchainReadBatch batch;
-            for (auto id = readFrom; id < readFrom + next; ++id) {
-                batch.requestCachedBlock (id);
-            }
+        if (readFrom > blockIndex) {
+            return units;
+        }
 
-            readFrom += next;
+        /*!
+            the cached block records are what pushBlock writes, the BlockchainLMDB
+            block info table only ever holds the genesis block. one batch for the
+            whole window, the result is keyed by index so sort it back
+        */
+        BlockchainReadBatch batch;
+        for (auto id = readFrom; id <= blockIndex; ++id) {
+            batch.requestCachedBlock (id);
+        }
 
-            auto res = readDatabase (batch);
+        auto res = readDatabase (batch);
 
-            std::map<uint32_t, CachedBlockInfo> sortedResult (res.getCachedBlocks ().begin (),
-                                                              res.getCachedBlocks ().end ());
-            for (const auto &kv: sortedResult) {
-                units.push_back (kv.second);
-            }
+        std::map<uint32_t, CachedBlockInfo> sortedResult (res.getCachedBlocks ().begin (),
+                                                          res.getCachedBlocks ().end ());
+        units.reserve (sortedResult.size ());
+        for (const auto &kv : sortedResult) {
+            units.push_back (kv.second);
         }
 
         return units;
@@ -1628,27 +2470,12 @@ namespace CryptoNote {
     size_t DatabaseBlockchainCache::getKeyOutputsCountForAmount(uint64_t amount,
                                                                 uint32_t blockIndex) const
     {
-        uint32_t outputsCount = requestKeyOutputGlobalIndexesCountForAmount (amount, database);
-
-        auto getOutput = std::bind (retrieveKeyOutput,
-                                    std::placeholders::_1,
-                                    std::placeholders::_2,
-                                    std::ref (database));
-        auto begin = DbOutputConstIterator (getOutput, amount, 0);
-        auto end = DbOutputConstIterator (getOutput,
-                                          amount,
-                                          outputsCount);
-
-        auto it = std::lower_bound (begin,
-                                    end,
-                                    blockIndex,
-                                    [](const PackedOutIndex &output,
-                                       uint32_t blockIndex)
-                                    {
-                                        return output.blockIndex < blockIndex;
-                                    });
-
-        size_t result = static_cast<size_t>(std::distance (begin, it));
+        /*!
+            outputs created strictly before blockIndex
+        */
+        size_t result = blockIndex == 0
+                        ? 0
+                        : getKeyOutputsCountUpToBlock (getKeyOutputAmountIndex (amount), blockIndex - 1);
         logger (Logging::DEBUGGING)
             << "Key outputs count for amount "
             << amount
@@ -1756,6 +2583,22 @@ namespace CryptoNote {
 
     void DatabaseBlockchainCache::save()
     {
+        setBulkSyncMode (false);
+
+        if (!spentKeyImageFilter.isBuilt () || spentKeyImageFilter.isSaturated ()) {
+            return;
+        }
+
+        spentKeyImageFilter.setTopBlock (getTopBlockIndex (), getTopBlockHash ());
+
+        BlockchainWriteBatch batch;
+        batch.insertSpentKeyImageFilter (spentKeyImageFilter);
+        auto res = database.write (batch);
+        if (res) {
+            logger (Logging::WARNING)
+                << "Failed to store spent key image filter: "
+                << res.message ();
+        }
     }
 
     void DatabaseBlockchainCache::load()
@@ -1857,72 +2700,57 @@ namespace CryptoNote {
                                                                          size_t count,
                                                                          uint32_t blockIndex) const
     {
-        auto batch = BlockchainReadBatch ().requestKeyOutputGlobalIndexesCountForAmount (amount);
-        auto result = readDatabase (batch);
-        auto outputsCount = result.getKeyOutputGlobalIndexesCountForAmounts ();
-        auto outputsToPick = std::min (static_cast<uint32_t>(count), outputsCount[amount]);
-
         std::vector<uint32_t> resultOuts;
-        resultOuts.reserve (outputsToPick);
 
-        ShuffleGenerator<uint32_t> generator (outputsCount[amount]);
+        /*!
+            nothing mined before the unlock window can be spent yet
+        */
+        if (blockIndex + currency.lockedTxAllowedDeltaBlocks () < currency.minedMoneyUnlockWindow ()) {
+            return resultOuts;
+        }
 
-        while (outputsToPick) {
-            std::vector<uint32_t> globalIndexes;
-            globalIndexes.reserve (outputsToPick);
+        uint32_t upperBlockIndex = 0;
+        if (blockIndex > currency.minedMoneyUnlockWindow ()) {
+            upperBlockIndex = blockIndex - currency.minedMoneyUnlockWindow ();
+        }
 
-            try {
-                for (uint32_t i = 0; i < outputsToPick; ++i, globalIndexes.push_back (generator ())) {
+        /*!
+            the keys for the picked outputs are read next, from memory as far as the table reaches
+        */
+        extendDecoyTable (amount);
 
-                }
-                //std::generate_n(std::back_inserter(globalIndexes), outputsToPick, generator);
+        const auto &index = getKeyOutputAmountIndex (amount);
+        uint32_t outputsCount = getKeyOutputsCountUpToBlock (index, upperBlockIndex);
+        auto outputsToPick = std::min (static_cast<uint32_t>(count), outputsCount);
+        resultOuts.reserve (outputsToPick);
+
+        ShuffleGenerator<uint32_t> generator (outputsCount);
+
+        while (resultOuts.size () < outputsToPick) {
+            uint32_t globalIndex;
+            try {
+                globalIndex = generator ();
             } catch (const SequenceEnded &) {
                 logger (Logging::TRACE)
                     << "getRandomOutsByAmount: generator reached sequence end";
                 return resultOuts;
             }
 
-            std::vector<PackedOutIndex> outputs;
-            if (extractKeyOtputIndexes (amount,
-                                        Common::ArrayView<uint32_t> (globalIndexes.data (),
-                                                                     globalIndexes.size ()),
-                                        outputs) != ExtractOutputKeysResult::SUCCESS) {
-                logger (Logging::DEBUGGING)
-                    << "getRandomOutsByAmount: failed to extract key output indexes";
-                /*!
-                    TODO: make error code
-                */
-                throw std::runtime_error ("Invalid output index");
-            }
-
-            std::vector<ExtendedTransactionInfo> transactions;
-            if (!requestExtendedTransactionInfos (outputs, database, transactions)) {
-                logger (Logging::TRACE)
-                    << "getRandomOutsByAmount: requestExtendedTransactionInfos failed";
-                /*!
-                    TODO: make error code
-                */
-                throw std::runtime_error ("Error while requesting transactions");
-            }
-
-            assert(globalIndexes.size () == transactions.size ());
-
-            uint32_t uppperBlockIndex = 0;
-            if (blockIndex > currency.minedMoneyUnlockWindow ()) {
-                uppperBlockIndex = blockIndex - currency.minedMoneyUnlockWindow ();
+            auto locked = std::lower_bound (index.lockedOutputs.begin (),
+                                            index.lockedOutputs.end (),
+                                            globalIndex,
+                                            [](const LockedKeyOutput &lockedOutput,
+                                               uint32_t globalIndex)
+                                            {
+                                                return lockedOutput.globalIndex < globalIndex;
+                                            });
+            if (locked != index.lockedOutputs.end () &&
+                locked->globalIndex == globalIndex &&
+                !isTransactionSpendTimeUnlocked (locked->unlockTime, blockIndex)) {
+                continue;
             }
 
-            for (size_t i = 0; i < transactions.size (); ++i) {
-                if (!isTransactionSpendTimeUnlocked (transactions[i].unlockTime,
-                                                     blockIndex) ||
-                    transactions[i].blockIndex >
-                    uppperBlockIndex) {
-                    continue;
-                }
-
-                resultOuts.push_back (globalIndexes[i]);
-                --outputsToPick;
-            }
+            resultOuts.push_back (globalIndex);
         }
 
         return resultOuts;
@@ -1936,30 +2764,25 @@ namespace CryptoNote {
                                                                            PackedOutIndex index,
                                                                            uint32_t globalIndex)> callback) const
     {
-        BlockchainReadBatch batch;
-        for (auto it = globalIndexes.begin (); it != globalIndexes.end (); ++it) {
-            batch.requestKeyOutputInfo (amount, *it);
+        std::vector<KeyOutputInfo> outputs;
+        if (!requestKeyOutputInfos (amount, globalIndexes, outputs)) {
+            return ExtractOutputKeysResult::INVALID_GLOBAL_INDEX;
         }
 
-        auto result = readDatabase (batch).getKeyOutputInfo ();
-        std::map<std::pair<IBlockchainCache::Amount,
-                           IBlockchainCache::GlobalOutputIndex>,
-                 KeyOutputInfo> sortedResult (result.begin (),
-                                              result.end ());
-        for (const auto &kv: sortedResult) {
+        for (size_t i = 0; i < outputs.size (); ++i) {
             ExtendedTransactionInfo tx;
-            tx.unlockTime = kv.second.unlockTime;
-            tx.transactionHash = kv.second.transactionHash;
-            tx.outputs.resize (kv.second.outputIndex + 1);
-            tx.outputs[kv.second.outputIndex] = KeyOutput{kv.second.publicKey};
+            tx.unlockTime = outputs[i].unlockTime;
+            tx.transactionHash = outputs[i].transactionHash;
+            tx.outputs.resize (outputs[i].outputIndex + 1);
+            tx.outputs[outputs[i].outputIndex] = KeyOutput{outputs[i].publicKey};
             PackedOutIndex fakePoi;
-            fakePoi.outputIndex = kv.second.outputIndex;
+            fakePoi.outputIndex = outputs[i].outputIndex;
 
             /*!
-                TODO: change the interface of extractKeyOutputs to return vector of 
+                TODO: change the interface of extractKeyOutputs to return vector of
                       structures instead of passing callback as predicate
             */
-            auto ret = callback (tx, fakePoi, kv.first.second);
+            auto ret = callback (tx, fakePoi, globalIndexes[i]);
             if (ret != ExtractOutputKeysResult::SUCCESS) {
                 logger (Logging::DEBUGGING)
                     << "extractKeyOutputs failed : callback returned error";
@@ -1970,9 +2793,49 @@ namespace CryptoNote {
         return ExtractOutputKeysResult::SUCCESS;
     }
 
+    /*!
+        Reads key outputs in one batch, results are in the order of globalIndexes
+    */
+    bool DatabaseBlockchainCache::requestKeyOutputInfos(uint64_t amount,
+                                                        Common::ArrayView<uint32_t> globalIndexes,
+                                                        std::vector<KeyOutputInfo> &outputs) const
+    {
+        if (globalIndexes.isEmpty ()) {
+            return true;
+        }
+
+        BlockchainReadBatch batch;
+        for (auto it = globalIndexes.begin (); it != globalIndexes.end (); ++it) {
+            batch.requestKeyOutputInfo (amount, *it);
+        }
+
+        auto result = readDatabase (batch);
+        const auto &keyOutputs = result.getKeyOutputInfo ();
+
+        outputs.reserve (outputs.size () + globalIndexes.getSize ());
+        for (auto it = globalIndexes.begin (); it != globalIndexes.end (); ++it) {
+            auto found = keyOutputs.find (std::make_pair (amount, *it));
+            if (found == keyOutputs.end ()) {
+                logger (Logging::DEBUGGING)
+                    << "requestKeyOutputInfos: key output "
+                    << *it
+                    << " for amount "
+                    << amount
+                    << " not found";
+                return false;
+            }
+
+            outputs.push_back (found->second);
+        }
+
+        return true;
+    }
+
     std::vector<Crypto::Hash>
     DatabaseBlockchainCache::getTransactionHashesByPaymentId(const Crypto::Hash &paymentId) const
     {
+        flushDeferredIndexes ();
+
         auto countBatch = BlockchainReadBatch ().requestTransactionCountByPaymentId (paymentId);
         uint32_t
             transactionsCountByPaymentId = readDatabase (countBatch).getTransactionCountByPaymentIds ().at (paymentId);
@@ -2001,6 +2864,8 @@ namespace CryptoNote {
             return blockHashes;
         }
 
+        flushDeferredIndexes ();
+
         BlockchainReadBatch batch;
         for (uint64_t timestamp = timestampBegin;
              timestamp < timestampBegin + static_cast<uint64_t>(secondsCount);
@@ -2030,35 +2895,28 @@ namespace CryptoNote {
     {
         std::vector<RawBlock> orderedBlocks;
 
-        const uint32_t storageBlockCount = getBlockCount ();
-
-        uint64_t height = startHeight;
-
-        while (orderedBlocks.size () < blockCount && height < storageBlockCount) {
-            uint64_t startHeight = height;
-
-            /*!
-                Lets try taking the amount we need *2, to try and balance not needing
-                multiple DB requests to get the amount we need of non empty blocks, with
-                not taking too many
-            */
-            uint64_t endHeight = startHeight + (blockCount * 2);
-
-            auto blockBatch = BlockchainReadBatch ().requestRawBlocks (startHeight, endHeight);
-            const auto rawBlocks = readDatabase (blockBatch).getRawBlocks ();
+        const auto &nonEmptyBlocks = nonEmptyBlockIndexes;
 
-            while (orderedBlocks.size () < blockCount &&
-                   height < startHeight + rawBlocks.size ()) {
-                const auto block = rawBlocks.at (height);
+        auto begin = std::lower_bound (nonEmptyBlocks.begin (), nonEmptyBlocks.end (), startHeight);
+        auto end = begin + std::min (blockCount, static_cast<size_t>(std::distance (begin, nonEmptyBlocks.end ())));
+        if (begin == end) {
+            return orderedBlocks;
+        }
 
-                height++;
+        /*!
+            Only the blocks we return are read
+        */
+        BlockchainReadBatch blockBatch;
+        for (auto it = begin; it != end; ++it) {
+            blockBatch.requestRawBlock (*it);
+        }
 
-                if (block.transactions.empty ()) {
-                    continue;
-                }
+        auto result = readDatabase (blockBatch);
+        const auto &rawBlocks = result.getRawBlocks ();
 
-                orderedBlocks.push_back (block);
-            }
+        orderedBlocks.reserve (rawBlocks.size ());
+        for (auto it = begin; it != end; ++it) {
+            orderedBlocks.push_back (rawBlocks.at (*it));
         }
 
         return orderedBlocks;
@@ -2199,7 +3057,9 @@ namespace CryptoNote {
             std::move (baseTransaction)
         };
 
-        pushTransaction (cachedBaseTransaction, 0, 0, batch);
+        PendingKeyOutputs pendingKeyOutputs;
+        pushTransaction (cachedBaseTransaction, 0, 0, batch, pendingKeyOutputs);
+        requestInsertKeyOutputAmountIndexes (batch, 0, pendingKeyOutputs);
 
         /*!
         batch.insertCachedBlock (blockInfo,
@@ -2230,6 +3090,9 @@ namespace CryptoNote {
             throw std::runtime_error (res.message ());
         }
 
+        pushKeyOutputsToAmountIndexes (0, pendingKeyOutputs);
+        pushKeyOutputsToDecoyTables (pendingKeyOutputs);
+
         topBlockHash = genesisBlock.getBlockHash ();
 
         unitsCache.push_back (blockInfo);
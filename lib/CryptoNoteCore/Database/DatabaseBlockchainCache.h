@@ -29,6 +29,7 @@
 #include <CryptoNoteCore/Blockchain/BlockchainWriteBatch.h>
 #include <CryptoNoteCore/Blockchain/LMDB/BlockchainDB.h>
 #include <CryptoNoteCore/Database/DatabaseCacheData.h>
+#include <CryptoNoteCore/Database/SpentKeyImageFilter.h>
 #include <CryptoNoteCore/Transactions/ITransactionValidator.h>
 #include <CryptoNoteCore/Transactions/TransactionPool.h>
 #include <CryptoNoteCore/Currency.h>
@@ -185,6 +186,14 @@ namespace CryptoNote {
         virtual void save() override;
         virtual void load() override;
 
+        /*!
+            In bulk sync mode blocks are written into one database transaction until it
+            grows past BULK_SYNC_COMMIT_SIZE, and the payment id and timestamp indexes are
+            merged in memory and written right before each commit. Every commit thus holds
+            whole blocks with their indexes, so a crash resumes from the last one.
+        */
+        virtual void setBulkSyncMode(bool enable) override;
+
         virtual std::vector<BinaryArray> getRawTransactions(const std::vector<Crypto::Hash> &transactions,
                                                             std::vector<Crypto::Hash> &missedTransactions) const override;
         virtual std::vector<BinaryArray>
@@ -214,6 +223,7 @@ namespace CryptoNote {
 
         virtual std::vector<RawBlock> getNonEmptyBlocks(const uint64_t startHeight,
                                                         const size_t blockCount) const override;
+
         BlockchainDB *mDb;
         Hardfork *mHardfork;
         TxMemoryPool &mTxMemPool;
@@ -238,6 +248,65 @@ namespace CryptoNote {
         mutable boost::optional<uint64_t> transactionsCount;
         mutable boost::optional<uint32_t> keyOutputAmountsCount;
         mutable std::unordered_map<Amount, int32_t> keyOutputCountsForAmounts;
+
+        /*!
+            Per amount index used to pick decoys without touching the outputs themselves:
+            cumulative key output counts by block and the outputs which are still locked
+            after the mined money unlock window. Entries past the stored counts are not
+            yet written to the database.
+        */
+        struct KeyOutputAmountIndex
+        {
+            std::vector<KeyOutputBlockCount> blockCounts;
+            std::vector<LockedKeyOutput> lockedOutputs;
+            uint32_t storedBlockCounts = 0;
+            uint32_t storedLockedOutputs = 0;
+        };
+        mutable std::unordered_map<Amount, KeyOutputAmountIndex> keyOutputAmountIndexes;
+
+        /*!
+            key output of a block being pushed, it joins the in memory index of its
+            amount once the block is written
+        */
+        struct PendingKeyOutput
+        {
+            GlobalOutputIndex globalIndex;
+            Crypto::PublicKey publicKey;
+            uint64_t unlockTime;
+        };
+        using PendingKeyOutputs = std::map<Amount, std::vector<PendingKeyOutput>>;
+
+        /*!
+            Public key and unlock time of every key output of an amount, by global index,
+            so decoys and ring members are served without database reads. A table grows by one
+            batch on every decoy request for its amount until it is complete, written blocks
+            extend complete tables and splits truncate them, the least recently used ones are
+            dropped to stay within the memory limit.
+        */
+        struct DecoyTable
+        {
+            std::vector<Crypto::PublicKey> publicKeys;
+            std::vector<uint64_t> unlockTimes;
+            uint64_t lastUsed = 0;
+        };
+        mutable std::unordered_map<Amount, DecoyTable> decoyTables;
+        mutable size_t decoyTablesMemoryUsage = 0;
+        mutable uint64_t decoyTablesClock = 0;
+        SpentKeyImageFilter spentKeyImageFilter;
+
+        /*!
+            Ascending indexes of the blocks holding transactions besides the coinbase one,
+            loaded when the cache is created and kept in sync with the database on push and split
+        */
+        std::vector<uint32_t> nonEmptyBlockIndexes;
+
+        bool bulkSyncMode = false;
+        /*!
+            flushed into the pending bulk transaction before the payment id and
+            timestamp queries too, so those see the recently pushed blocks
+        */
+        mutable std::unordered_map<Crypto::Hash, std::vector<Crypto::Hash>> deferredPaymentIds;
+        mutable std::map<uint64_t, std::vector<Crypto::Hash>> deferredBlockTimestamps;
         std::vector<IBlockchainCache *> children;
         Logging::LoggerRef logger;
         std::deque<CachedBlockInfo> unitsCache;
@@ -251,21 +320,45 @@ namespace CryptoNote {
         BlockchainReadResult readDatabase(BlockchainReadBatch &batch) const;
 
         void addSpentKeyImage(const Crypto::KeyImage &keyImage, uint32_t blockIndex);
+        void loadSpentKeyImageFilter();
+        void rebuildSpentKeyImageFilter();
+        void migrateDatabase();
+        void loadNonEmptyBlockIndexes();
+        void rebuildNonEmptyBlockIndexes();
+        void requestDeleteNonEmptyBlockIndexes(BlockchainWriteBatch &writeBatch, uint32_t splitBlockIndex);
         void pushTransaction(const CachedTransaction &cachedTransaction,
                              uint32_t blockIndex,
                              uint16_t transactionBlockIndex,
-                             BlockchainWriteBatch &batch);
+                             BlockchainWriteBatch &batch,
+                             PendingKeyOutputs &pendingKeyOutputs);
         /*!
             TODO: Not implemented. Should it be removed?
         */
         uint32_t insertKeyOutputToGlobalIndex(uint64_t amount, PackedOutIndex output);
         uint32_t updateKeyOutputCount(Amount amount, int32_t diff) const;
+        KeyOutputAmountIndex &getKeyOutputAmountIndex(Amount amount) const;
+        void rebuildKeyOutputAmountIndexes();
+        void rebuildKeyOutputAmountIndex(Amount amount);
+        void requestInsertKeyOutputAmountIndexes(BlockchainWriteBatch &batch,
+                                                 uint32_t blockIndex,
+                                                 const PendingKeyOutputs &pendingKeyOutputs);
+        void pushKeyOutputsToAmountIndexes(uint32_t blockIndex, const PendingKeyOutputs &pendingKeyOutputs);
+        DecoyTable *findDecoyTable(Amount amount) const;
+        void extendDecoyTable(Amount amount) const;
+        void evictDecoyTables(size_t targetUsage) const;
+        void pushKeyOutputsToDecoyTables(const PendingKeyOutputs &pendingKeyOutputs);
+        void truncateDecoyTable(Amount amount, GlobalOutputIndex boundary);
+        void publishDecoyTablesMemoryUsage() const;
+        bool isKeyOutputLockedPastUnlockWindow(uint64_t unlockTime, uint32_t blockIndex) const;
+        uint32_t getKeyOutputsCountUpToBlock(const KeyOutputAmountIndex &index, uint32_t blockIndex) const;
         void insertPaymentId(BlockchainWriteBatch &batch,
                              const Crypto::Hash &transactionHash,
                              const Crypto::Hash &paymentId);
         void insertBlockTimestamp(BlockchainWriteBatch &batch,
                                   uint64_t timestamp,
                                   const Crypto::Hash &blockHash);
+        void flushDeferredIndexes() const;
+        void commitBulkSync();
 
         void addGenesisBlock(CachedBlock &&genesisBlock);
 
@@ -294,6 +387,9 @@ namespace CryptoNote {
                                     const Crypto::Hash &blockHash);
 
         ExtendedTransactionInfo requestCachedTransaction(const Crypto::Hash &hash);
+        bool requestKeyOutputInfos(uint64_t amount,
+                                   Common::ArrayView<uint32_t> globalIndexes,
+                                   std::vector<KeyOutputInfo> &outputs) const;
 
         uint8_t getBlockMajorVersionForHeight(uint32_t height) const;
         uint64_t getCachedTransactionsCount() const;
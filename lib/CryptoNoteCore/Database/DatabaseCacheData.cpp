@@ -39,4 +39,16 @@ namespace CryptoNote {
         s (outputIndex, "outputIndex");
     }
 
+    void KeyOutputBlockCount::serialize(ISerializer &s)
+    {
+        s (blockIndex, "block_index");
+        s (outputsCount, "outputs_count");
+    }
+
+    void LockedKeyOutput::serialize(ISerializer &s)
+    {
+        s (globalIndex, "global_index");
+        s (unlockTime, "unlock_time");
+    }
+
 }
@@ -34,6 +34,28 @@ namespace CryptoNote {
         void serialize(CryptoNote::ISerializer &s);
     };
 
+    /*!
+        cumulative count of key outputs for an amount at the end of a block
+    */
+    struct KeyOutputBlockCount
+    {
+        uint32_t blockIndex;
+        uint32_t outputsCount;
+
+        void serialize(CryptoNote::ISerializer &s);
+    };
+
+    /*!
+        key output whose unlock time outlasts the mined money unlock window
+    */
+    struct LockedKeyOutput
+    {
+        uint32_t globalIndex;
+        uint64_t unlockTime;
+
+        void serialize(CryptoNote::ISerializer &s);
+    };
+
     /*!
         inherit here to avoid breaking IBlockchainCache interface
     */
@@ -1924,10 +1924,64 @@ namespace CryptoNote {
         checkOpen ();
         std::vector<Crypto::Hash> v;
 
+        const std::vector<BlockInfoT> blockInfos = getBlockInfoRange (h1, h2);
+        v.reserve (blockInfos.size ());
+        for (const auto &blockInfo : blockInfos) {
+            v.push_back (blockInfo.hash);
+        }
+
+        return v;
+    }
+
+    /*!
+     * block info records are duplicates of a single key sorted by height, so a
+     * range is one positioned read followed by MDB_NEXT_DUP in the same cursor
+     */
+    std::vector<BlockInfoT> BlockchainLMDB::getBlockInfoRange(const uint64_t &h1, const uint64_t &h2) const
+    {
+        checkOpen ();
+        std::vector<BlockInfoT> v;
+
+        if (h2 < h1) {
+            return v;
+        }
+
+        TXN_PREFIX_RDONLY ();
+        RCURSOR (BlockInfo);
+
+        v.reserve (h2 - h1 + 1);
+
+        MDBValSet (result, h1);
+        MDB_cursor_op op = MDB_GET_BOTH;
         for (uint64_t height = h1; height <= h2; ++height) {
-            v.push_back(getBlockHashFromHeight (height));
+            MDB_val key = zeroKVal;
+            auto getResult = mdb_cursor_get (mCurBlockInfo, &key, &result, op);
+            op = MDB_NEXT_DUP;
+            if (getResult == MDB_NOTFOUND) {
+                throw (BLOCK_DNE(std::string("Attempt to get block info from height ")
+                                 .append(boost::lexical_cast<std::string>(height))
+                                 .append(" failed -- block info not in db").c_str()));
+            } else if (getResult) {
+                throw (DB_ERROR(LMDBError ("Error attempting to retrieve block info from the db: ",
+                                           getResult).c_str()));
+            }
+
+            const mdbBlockInfo *bI = (const mdbBlockInfo *)result.mv_data;
+
+            BlockInfoT blockInfo;
+            blockInfo.height = bI->biHeight;
+            blockInfo.timestamp = bI->biTimestamp;
+            blockInfo.alreadyGeneratedCoins = bI->biCoins;
+            blockInfo.alreadyGeneratedTransactions = bI->biTransactions;
+            blockInfo.blockSize = bI->biSize;
+            blockInfo.cumulativeDifficulty = bI->biDiff;
+            blockInfo.hash = bI->biHash;
+
+            v.push_back (blockInfo);
         }
 
+        TXN_POSTFIX_RDONLY ();
+
         return v;
     }
 
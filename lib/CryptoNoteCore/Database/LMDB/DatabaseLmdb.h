@@ -176,6 +176,7 @@ namespace CryptoNote {
         virtual Crypto::Hash getBlockHashFromHeight(const uint64_t &height) const;
         virtual std::vector<CryptoNote::Block> getBlocksRange(const uint64_t &h1, const uint64_t &h2) const;
         virtual std::vector<Crypto::Hash> getHashesRange(const uint64_t &h1, const uint64_t &h2) const;
+        virtual std::vector<BlockInfoT> getBlockInfoRange(const uint64_t &h1, const uint64_t &h2) const;
         virtual Crypto::Hash getTopBlockHash() const;
         virtual CryptoNote::Block getTopBlock() const;
         virtual uint64_t height() const;
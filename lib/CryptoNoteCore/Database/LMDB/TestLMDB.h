@@ -113,6 +113,12 @@ namespace CryptoNote {
             return std::vector<Crypto::Hash>();
         }
 
+        virtual std::vector<BlockInfoT> getBlockInfoRange(const uint64_t &h1,
+                                                          const uint64_t &h2) const override
+        {
+            return std::vector<BlockInfoT>();
+        }
+
         virtual Crypto::Hash topBlockHash(uint64_t *blockHeight = NULL) const
         {
             if (blockHeight) {
@@ -17,13 +17,16 @@
 // You should have received a copy of the GNU Lesser General Public License
 // along with Qwertycoin.  If not, see <http://www.gnu.org/licenses/>.
 
+#include <algorithm>
 #include <iostream>
 #include <fstream>
+#include <numeric>
 #include <string_view>
 
 #include <lmdb/lmdbpp.h>
 
 #include <Common/FileSystemShim.h>
+#include <Common/Metrics.h>
 
 #include <CryptoNoteCore/Database/DatabaseConfig.h>
 #include <CryptoNoteCore/Database/DatabaseErrors.h>
@@ -45,6 +48,9 @@ LmDBWrapper::LmDBWrapper(std::shared_ptr<Logging::ILogger> logger)
 LmDBWrapper::~LmDBWrapper()
 {
     try {
+        if (m_bulkTxn != nullptr) {
+            lmdb::txn_abort (m_bulkTxn);
+        }
         m_db.sync ();
         m_db.close ();
     } catch (...) {
@@ -126,7 +132,7 @@ void LmDBWrapper::init(const DataBaseConfig &config)
     /*!
         resize mapsize if needed
     */
-    checkResize ();
+    checkResize (MAPSIZE_MIN_AVAIL);
 
     logger (INFO)
         << "DB opened in "
@@ -144,6 +150,17 @@ void LmDBWrapper::shutdown()
 
     logger (INFO)
         << "Closing DB.";
+    /*!
+        a bulk transaction still open here wasn't finished by its writer, drop it
+        so the db stays at the last complete commit
+    */
+    if (m_bulkTxn != nullptr) {
+        logger (WARNING)
+            << "Discarding unfinished bulk write transaction";
+        lmdb::txn_abort (m_bulkTxn);
+        m_bulkTxn = nullptr;
+        m_bulkThread.store (std::thread::id ());
+    }
     m_db.sync ();
     state.store (NOT_INITIALIZED);
 }
@@ -182,36 +199,77 @@ void LmDBWrapper::destroy(const DataBaseConfig &config)
 
 std::error_code LmDBWrapper::write(IWriteBatch &batch)
 {
+    static auto &writeDuration = Metrics::Registry::instance ().histogram (
+        "db_write_duration_seconds",
+        "Time spent writing a batch, including the commit outside of bulk mode");
+    static auto &writeKeys = Metrics::Registry::instance ().counter (
+        "db_write_keys_total",
+        "Keys put or deleted by write batches");
+    Metrics::ScopedTimer timer (writeDuration);
+
     if (state.load () != INITIALIZED) {
         throw std::system_error (make_error_code (CryptoNote::error::DataBaseErrorCodes::NOT_INITIALIZED));
     }
 
+    const std::vector<std::pair<std::string, std::string>> rawData (batch.extractRawDataToInsert ());
+    const std::vector<std::string> rawKeys (batch.extractRawKeysToRemove ());
+
     /*!
-        resize if needed
+        in bulk mode the batch goes into the long running transaction. The map
+        can't grow while it is open, so a batch which might not fit into the
+        room left commits it early and continues in a fresh one
     */
-    checkResize ();
+    const bool bulk = ownsBulkTxn ();
 
     MDB_txn *wtxn;
     lmdb::dbi dbi;
     std::error_code errCode;
 
-    try {
-        lmdb::txn_begin (m_db, nullptr, 0, &wtxn);
-    } catch (const std::exception &e) {
-        logger (ERROR)
-            << "Failed to prepare db write transaction: "
-            << e.what ();
-        throw std::system_error (make_error_code (CryptoNote::error::DataBaseErrorCodes::INTERNAL_ERROR));
+    size_t bulkFootprint = 0;
+    if (bulk) {
+        for (const std::pair<std::string, std::string> &kvPair : rawData) {
+            bulkFootprint += kvPair.first.size () + kvPair.second.size () + m_pageSize;
+        }
+        for (const std::string &key : rawKeys) {
+            bulkFootprint += key.size () + m_pageSize;
+        }
+
+        if (m_bulkSize != 0 && m_bulkSize + bulkFootprint > m_bulkRoom) {
+            logger (DEBUGGING)
+                << "Bulk write transaction is running out of map room, committing early";
+            commitBulkTxn ();
+            beginBulkWrite ();
+        }
+
+        wtxn = m_bulkTxn;
+    } else {
+        /*!
+            resize if needed
+        */
+        checkResize (MAPSIZE_MIN_AVAIL);
+
+        try {
+            lmdb::txn_begin (m_db, nullptr, 0, &wtxn);
+        } catch (const std::exception &e) {
+            logger (ERROR)
+                << "Failed to prepare db write transaction: "
+                << e.what ();
+            throw std::system_error (make_error_code (CryptoNote::error::DataBaseErrorCodes::INTERNAL_ERROR));
+        }
     }
 
     dbi = lmdb::dbi::open (wtxn, nullptr);
 
     {
         // insert
-        const std::vector<std::pair<std::string, std::string>> rawData (batch.extractRawDataToInsert ());
+        /*!
+            puts don't use MDB_APPEND, the raw keys are prefixed hashes and
+            indexes which don't arrive in key order
+        */
         logger (TRACE)
             << "Writing rawdata, len: "
             << rawData.size ();
+        writeKeys.inc (rawData.size ());
 
         for (const std::pair<std::string, std::string> &kvPair : rawData) {
             if (dbi.put (wtxn, kvPair.first, kvPair.second)) {
@@ -226,10 +284,10 @@ std::error_code LmDBWrapper::write(IWriteBatch &batch)
 
     {
         // delete
-        const std::vector<std::string> rawKeys (batch.extractRawKeysToRemove ());
         logger (TRACE)
             << "Removing rawKeys, len: "
             << rawKeys.size ();
+        writeKeys.inc (rawKeys.size ());
         for (const std::string &key : rawKeys) {
             if (dbi.del (wtxn, key)) {
                 m_dirty++;
@@ -241,6 +299,11 @@ std::error_code LmDBWrapper::write(IWriteBatch &batch)
         }
     }
 
+    if (bulk) {
+        m_bulkSize += bulkFootprint;
+        return errCode;
+    }
+
     try {
         lmdb::txn_commit (wtxn);
     } catch (const std::exception &e) {
@@ -261,7 +324,7 @@ std::error_code LmDBWrapper::write(IWriteBatch &batch)
     return errCode;
 }
 
-void LmDBWrapper::checkResize()
+uint64_t LmDBWrapper::checkResize(uint64_t minAvail)
 {
     uint64_t size_avail;
     uint64_t mapsize;
@@ -279,59 +342,99 @@ void LmDBWrapper::checkResize()
         size_avail = mapsize - size_used;
     }
 
-    if (size_avail > MAPSIZE_MIN_AVAIL) {
+    if (size_avail > minAvail) {
         logger (TRACE)
             << "DB Resize: no resize required, size avail: "
             << size_avail
             << " bytes.";
-        return;
+        return size_avail;
     }
 
     m_db.sync ();
 
     const uint64_t extra = 1ULL
         << SHIFTING_VAL;
-    mapsize += extra;
+    while (size_avail <= minAvail) {
+        mapsize += extra;
+        size_avail += extra;
+    }
 
     logger (DEBUGGING)
         << "Resizing database. New mapsize: "
         << mapsize
         << " bytes.";
     m_db.set_mapsize (mapsize);
+
+    return size_avail;
 }
 
 std::error_code LmDBWrapper::read(IReadBatch &batch)
 {
+    static auto &readDuration = Metrics::Registry::instance ().histogram (
+        "db_read_duration_seconds",
+        "Time spent reading a batch");
+    static auto &readKeys = Metrics::Registry::instance ().counter (
+        "db_read_keys_total",
+        "Keys looked up by read batches");
+    Metrics::ScopedTimer timer (readDuration);
+
     if (state.load () != INITIALIZED) {
         throw std::runtime_error ("Not initialized.");
     }
 
     const std::vector<std::string> rawKeys (batch.getRawKeys ());
+    readKeys.inc (rawKeys.size ());
     logger (ALL)
         << "Batch reading rawKeys, len: "
         << rawKeys.size ();
-    std::vector<bool> resultStates;
-    std::vector<std::string> values;
+
+    /*!
+        look keys up in database order, so a single cursor walks the B-tree
+        leaf pages forward instead of descending from the root for every key
+    */
+    std::vector<size_t> order (rawKeys.size ());
+    std::iota (order.begin (), order.end (), 0);
+    std::sort (order.begin (),
+               order.end (),
+               [&rawKeys](size_t lhs, size_t rhs)
+               {
+                   return rawKeys[lhs] < rawKeys[rhs];
+               });
+
+    /*!
+        TODO: get rid of this
+        rocksdb MultiGet compat: pass empty string if the key wasn't found
+    */
+    std::vector<bool> resultStates (rawKeys.size (), false);
+    std::vector<std::string> values (rawKeys.size ());
     lmdb::dbi dbi;
 
+    auto lookup = [&](MDB_txn *txn)
     {
-        auto rtxn = lmdb::txn::begin (m_db, nullptr, MDB_RDONLY);
-        dbi = lmdb::dbi::open (rtxn, nullptr);
+        dbi = lmdb::dbi::open (txn, nullptr);
+        auto cursor = lmdb::cursor::open (txn, dbi);
 
-        for (const std::string &key : rawKeys) {
+        for (size_t i : order) {
+            std::string_view key (rawKeys[i]);
             std::string_view val;
-            if (dbi.get (rtxn, key, val)) {
-                values.push_back (std::string (val));
-                resultStates.push_back (true);
-            } else {
-                /*!
-                    TODO: get rid of this
-                    rocksdb MultiGet compat: pass empty string if the key wasn't found
-                */
-                values.push_back (std::string (""));
-                resultStates.push_back (false);
+            if (cursor.get (key, val, MDB_SET)) {
+                values[i].assign (val.data (), val.size ());
+                resultStates[i] = true;
             }
         }
+
+        cursor.close ();
+    };
+
+    if (ownsBulkTxn ()) {
+        /*!
+            the writing thread has to see what it wrote so far and may not
+            open a second transaction anyway
+        */
+        lookup (m_bulkTxn);
+    } else {
+        auto rtxn = lmdb::txn::begin (m_db, nullptr, MDB_RDONLY);
+        lookup (rtxn);
     }
     /*!
         rtxn will be aborted/dropped here
@@ -341,6 +444,101 @@ std::error_code LmDBWrapper::read(IReadBatch &batch)
     return std::error_code ();
 }
 
+void LmDBWrapper::beginBulkWrite()
+{
+    if (state.load () != INITIALIZED) {
+        throw std::system_error (make_error_code (CryptoNote::error::DataBaseErrorCodes::NOT_INITIALIZED));
+    }
+
+    if (m_bulkThread.load () != std::thread::id ()) {
+        return;
+    }
+
+    /*!
+        keep a part of the room for the branch pages and the free list, which
+        the footprint estimate of the written entries doesn't cover
+    */
+    m_bulkRoom = checkResize (BULK_WRITE_MIN_AVAIL) - MAPSIZE_MIN_AVAIL;
+
+    MDB_stat stat;
+    lmdb::env_stat (m_db, &stat);
+    m_pageSize = stat.ms_psize;
+
+    try {
+        lmdb::txn_begin (m_db, nullptr, 0, &m_bulkTxn);
+    } catch (const std::exception &e) {
+        m_bulkTxn = nullptr;
+        logger (ERROR)
+            << "Failed to prepare db bulk write transaction: "
+            << e.what ();
+        throw std::system_error (make_error_code (CryptoNote::error::DataBaseErrorCodes::INTERNAL_ERROR));
+    }
+
+    m_bulkSize = 0;
+    m_bulkThread.store (std::this_thread::get_id ());
+
+    logger (TRACE)
+        << "Bulk write transaction started";
+}
+
+void LmDBWrapper::commitBulkWrite()
+{
+    if (!ownsBulkTxn ()) {
+        return;
+    }
+
+    commitBulkTxn ();
+    beginBulkWrite ();
+}
+
+void LmDBWrapper::endBulkWrite()
+{
+    if (!ownsBulkTxn ()) {
+        return;
+    }
+
+    commitBulkTxn ();
+}
+
+size_t LmDBWrapper::getBulkWriteSize() const
+{
+    return ownsBulkTxn () ? m_bulkSize : 0;
+}
+
+void LmDBWrapper::commitBulkTxn()
+{
+    MDB_txn *wtxn = m_bulkTxn;
+    m_bulkTxn = nullptr;
+    m_bulkThread.store (std::thread::id ());
+
+    logger (TRACE)
+        << "Committing bulk write transaction, len: "
+        << m_bulkSize
+        << " bytes";
+
+    try {
+        lmdb::txn_commit (wtxn);
+    } catch (const std::exception &e) {
+        logger (ERROR)
+            << "Failed to commit db bulk write transaction: "
+            << e.what ();
+        throw std::system_error (make_error_code (CryptoNote::error::DataBaseErrorCodes::INTERNAL_ERROR));
+    }
+
+    m_bulkSize = 0;
+
+    /*!
+        every bulk commit covers far more than MAX_DIRTY writes
+    */
+    m_dirty = 0;
+    m_db.sync (0);
+}
+
+bool LmDBWrapper::ownsBulkTxn() const
+{
+    return m_bulkThread.load () == std::this_thread::get_id ();
+}
+
 void LmDBWrapper::setDataDir(const DataBaseConfig &config)
 {
     if (config.getTestnet ()) {
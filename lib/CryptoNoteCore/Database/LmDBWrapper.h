@@ -22,6 +22,7 @@
 #include <atomic>
 #include <memory>
 #include <string>
+#include <thread>
 
 #include <lmdb/lmdbpp.h>
 
@@ -54,8 +55,18 @@ namespace CryptoNote {
         std::error_code write(IWriteBatch &batch) override;
         std::error_code read(IReadBatch &batch) override;
 
+        void beginBulkWrite() override;
+        void commitBulkWrite() override;
+        void endBulkWrite() override;
+        size_t getBulkWriteSize() const override;
+
     private:
-        void checkResize();
+        /*!
+            grows the map until more than minAvail bytes are free, returns the free room
+        */
+        uint64_t checkResize(uint64_t minAvail);
+        void commitBulkTxn();
+        bool ownsBulkTxn() const;
         void setDataDir(const DataBaseConfig &config);
         fs::path getDataDir(const DataBaseConfig &config);
 
@@ -71,5 +82,16 @@ namespace CryptoNote {
         fs::path m_dbFile;
         lmdb::env m_db = lmdb::env::create ();
         std::atomic_uint m_dirty;
+
+        /*!
+            long running write transaction of the bulk write mode. Only the thread
+            stored in m_bulkThread touches it and the sizes below, other threads
+            just compare their id against m_bulkThread
+        */
+        MDB_txn *m_bulkTxn = nullptr;
+        std::atomic<std::thread::id> m_bulkThread{std::thread::id ()};
+        size_t m_bulkSize = 0;
+        size_t m_bulkRoom = 0;
+        size_t m_pageSize = 0;
     };
 } // namespace CryptoNote
@@ -0,0 +1,185 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+// Copyright (c) 2018-2020, The Qwertycoin Project
+//
+// This file is part of Qwertycoin.
+//
+// Qwertycoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Qwertycoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Qwertycoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <cstring>
+#include <string>
+
+#include <CryptoNoteCore/Database/SpentKeyImageFilter.h>
+
+#include <Serialization/CryptoNoteSerialization.h>
+#include <Serialization/SerializationOverloads.h>
+
+namespace CryptoNote {
+
+    namespace {
+
+        /*!
+            10 bits per key image with 7 probes inside one 512 bit block gives
+            roughly a 1% false positive rate while touching a single cache line
+        */
+        const uint64_t BITS_PER_KEY_IMAGE = 10;
+
+        const uint64_t BLOCK_WORDS = 8;
+
+        const uint64_t BLOCK_BITS = BLOCK_WORDS * 64;
+
+        const uint32_t PROBES_COUNT = 7;
+
+        const uint32_t PROBE_BITS = 9;
+
+        /*!
+            key images are curve points picked by the spenders, their bytes are
+            already uniformly distributed, so no extra hashing is done
+        */
+        void probeWords(const Crypto::KeyImage &keyImage, uint64_t &blockWord, uint64_t &probeWord)
+        {
+            uint64_t words[4];
+            static_assert(sizeof (words) == sizeof (keyImage), "unexpected key image size");
+            std::memcpy (words, &keyImage, sizeof (words));
+
+            blockWord = words[0];
+            probeWord = words[1] ^ words[2];
+        }
+
+    } // namespace
+
+    SpentKeyImageFilter::SpentKeyImageFilter()
+        : mCapacity (0),
+          mInsertedCount (0),
+          mRemovedCount (0),
+          mTopBlockIndex (0),
+          mTopBlockHash ()
+    {
+    }
+
+    void SpentKeyImageFilter::reset(uint64_t capacity)
+    {
+        uint64_t blocksCount = (capacity * BITS_PER_KEY_IMAGE + BLOCK_BITS - 1) / BLOCK_BITS;
+        if (blocksCount == 0) {
+            blocksCount = 1;
+        }
+
+        mBits.assign (blocksCount * BLOCK_WORDS, 0);
+        mCapacity = capacity;
+        mInsertedCount = 0;
+        mRemovedCount = 0;
+    }
+
+    void SpentKeyImageFilter::insert(const Crypto::KeyImage &keyImage)
+    {
+        if (mBits.empty ()) {
+            return;
+        }
+
+        uint64_t blockWord;
+        uint64_t probeWord;
+        probeWords (keyImage, blockWord, probeWord);
+
+        uint64_t *block = &mBits[(blockWord % (mBits.size () / BLOCK_WORDS)) * BLOCK_WORDS];
+        for (uint32_t i = 0; i < PROBES_COUNT; ++i) {
+            uint64_t bit = (probeWord >> (i * PROBE_BITS)) & (BLOCK_BITS - 1);
+            block[bit / 64] |= uint64_t (1) << (bit % 64);
+        }
+
+        ++mInsertedCount;
+    }
+
+    void SpentKeyImageFilter::markRemoved(uint64_t count)
+    {
+        mRemovedCount += count;
+    }
+
+    bool SpentKeyImageFilter::mayContain(const Crypto::KeyImage &keyImage) const
+    {
+        if (mBits.empty ()) {
+            return true;
+        }
+
+        uint64_t blockWord;
+        uint64_t probeWord;
+        probeWords (keyImage, blockWord, probeWord);
+
+        const uint64_t *block = &mBits[(blockWord % (mBits.size () / BLOCK_WORDS)) * BLOCK_WORDS];
+        for (uint32_t i = 0; i < PROBES_COUNT; ++i) {
+            uint64_t bit = (probeWord >> (i * PROBE_BITS)) & (BLOCK_BITS - 1);
+            if ((block[bit / 64] & (uint64_t (1) << (bit % 64))) == 0) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    bool SpentKeyImageFilter::isSaturated() const
+    {
+        return mInsertedCount > mCapacity || mRemovedCount > mInsertedCount / 2;
+    }
+
+    bool SpentKeyImageFilter::isBuilt() const
+    {
+        return !mBits.empty ();
+    }
+
+    uint64_t SpentKeyImageFilter::getInsertedCount() const
+    {
+        return mInsertedCount;
+    }
+
+    uint32_t SpentKeyImageFilter::getTopBlockIndex() const
+    {
+        return mTopBlockIndex;
+    }
+
+    const Crypto::Hash &SpentKeyImageFilter::getTopBlockHash() const
+    {
+        return mTopBlockHash;
+    }
+
+    void SpentKeyImageFilter::setTopBlock(uint32_t blockIndex, const Crypto::Hash &blockHash)
+    {
+        mTopBlockIndex = blockIndex;
+        mTopBlockHash = blockHash;
+    }
+
+    void SpentKeyImageFilter::serialize(ISerializer &s)
+    {
+        s (mCapacity, "capacity");
+        s (mInsertedCount, "inserted_count");
+        s (mRemovedCount, "removed_count");
+        s (mTopBlockIndex, "top_block_index");
+        s (mTopBlockHash, "top_block_hash");
+
+        std::string bits;
+        if (s.type () == ISerializer::OUTPUT) {
+            bits.assign (reinterpret_cast<const char *>(mBits.data ()), mBits.size () * sizeof (uint64_t));
+        }
+
+        s.binary (bits, "bits");
+
+        if (s.type () == ISerializer::INPUT) {
+            if (bits.size () % (BLOCK_WORDS * sizeof (uint64_t)) != 0) {
+                mBits.clear ();
+                return;
+            }
+
+            mBits.resize (bits.size () / sizeof (uint64_t));
+            std::memcpy (mBits.data (), bits.data (), bits.size ());
+        }
+    }
+
+} // namespace CryptoNote
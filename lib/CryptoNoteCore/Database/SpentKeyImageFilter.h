@@ -0,0 +1,84 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+// Copyright (c) 2018-2020, The Qwertycoin Project
+//
+// This file is part of Qwertycoin.
+//
+// Qwertycoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Qwertycoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Qwertycoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <CryptoTypes.h>
+
+namespace CryptoNote {
+    class ISerializer;
+
+    /*!
+        Blocked bloom filter over the spent key images stored in the database.
+        A negative answer is definite, a positive one has to be confirmed by the
+        database. Bits are never cleared: removed key images keep answering
+        "maybe" until the filter is rebuilt, so the filter stays a superset of
+        the stored key images.
+    */
+    class SpentKeyImageFilter
+    {
+    public:
+        SpentKeyImageFilter();
+
+        /*!
+            drops all entries and sizes the filter for the given amount of key images
+        */
+        void reset(uint64_t capacity);
+
+        void insert(const Crypto::KeyImage &keyImage);
+
+        /*!
+            bits can't be cleared, removals are only counted to know when a rebuild pays off
+        */
+        void markRemoved(uint64_t count);
+
+        /*!
+            returns false only if the key image was never inserted. An empty
+            (not yet built) filter answers true for everything
+        */
+        bool mayContain(const Crypto::KeyImage &keyImage) const;
+
+        /*!
+            true when more key images were inserted than the filter was sized for,
+            or most of the inserted ones were removed again, so that the false
+            positive rate is past the designed one and the filter should be rebuilt
+        */
+        bool isSaturated() const;
+
+        bool isBuilt() const;
+
+        uint64_t getInsertedCount() const;
+
+        uint32_t getTopBlockIndex() const;
+        const Crypto::Hash &getTopBlockHash() const;
+        void setTopBlock(uint32_t blockIndex, const Crypto::Hash &blockHash);
+
+        void serialize(ISerializer &s);
+
+    private:
+        std::vector<uint64_t> mBits;
+        uint64_t mCapacity;
+        uint64_t mInsertedCount;
+        uint64_t mRemovedCount;
+        uint32_t mTopBlockIndex;
+        Crypto::Hash mTopBlockHash;
+    };
+} // namespace CryptoNote
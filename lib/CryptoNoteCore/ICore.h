@@ -139,6 +139,11 @@ namespace CryptoNote {
                                                                  std::vector<uint64_t>> &indexes) const = 0;
 
         virtual bool addTransactionToPool(const BinaryArray &transactionBinaryArray) = 0;
+        /*!
+            Validates a batch of relayed transactions, result has one entry per transaction
+            telling whether it was added to the pool
+        */
+        virtual std::vector<bool> addTransactionsToPool(const std::vector<BinaryArray> &transactionBinaryArrays) = 0;
 
         virtual std::vector<Crypto::Hash> getPoolTransactionHashes() const = 0;
         virtual std::tuple<bool, CryptoNote::BinaryArray>
@@ -0,0 +1,114 @@
+// Copyright (c) 2018-2020, The Qwertycoin Project
+//
+// This file is part of Qwertycoin.
+//
+// Qwertycoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Qwertycoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Qwertycoin.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <cstring>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <Crypto/Hash.h>
+
+#include <CryptoNoteProtocol/CompactBlock.h>
+
+namespace CryptoNote {
+
+    Crypto::Hash getCompactBlockKey(const Crypto::Hash &blockHash, uint64_t nonce)
+    {
+        uint8_t data[sizeof (Crypto::Hash) + sizeof (nonce)];
+        std::memcpy (data, blockHash.data, sizeof (Crypto::Hash));
+        std::memcpy (data + sizeof (Crypto::Hash), &nonce, sizeof (nonce));
+
+        return Crypto::CnFastHash (data, sizeof (data));
+    }
+
+    uint64_t getShortTransactionId(const Crypto::Hash &key, const Crypto::Hash &transactionHash)
+    {
+        uint8_t data[2 * sizeof (Crypto::Hash)];
+        std::memcpy (data, key.data, sizeof (Crypto::Hash));
+        std::memcpy (data + sizeof (Crypto::Hash), transactionHash.data, sizeof (Crypto::Hash));
+
+        const Crypto::Hash hash = Crypto::CnFastHash (data, sizeof (data));
+
+        uint64_t shortId = 0;
+        for (size_t i = 0; i < COMPACT_BLOCK_SHORT_ID_SIZE; ++i) {
+            shortId |= static_cast<uint64_t>(hash.data[i]) << (8 * i);
+        }
+
+        return shortId;
+    }
+
+    std::string packShortTransactionIds(const std::vector<uint64_t> &shortTxIds)
+    {
+        std::string packed;
+        packed.reserve (shortTxIds.size () * COMPACT_BLOCK_SHORT_ID_SIZE);
+        for (const auto shortId : shortTxIds) {
+            for (size_t j = 0; j < COMPACT_BLOCK_SHORT_ID_SIZE; ++j) {
+                packed.push_back (static_cast<char>((shortId >> (8 * j)) & 0xff));
+            }
+        }
+
+        return packed;
+    }
+
+    bool unpackShortTransactionIds(const std::string &packed, std::vector<uint64_t> &shortTxIds)
+    {
+        if (packed.size () % COMPACT_BLOCK_SHORT_ID_SIZE != 0) {
+            return false;
+        }
+
+        shortTxIds.resize (packed.size () / COMPACT_BLOCK_SHORT_ID_SIZE);
+        for (size_t i = 0; i < shortTxIds.size (); ++i) {
+            uint64_t shortId = 0;
+            for (size_t j = 0; j < COMPACT_BLOCK_SHORT_ID_SIZE; ++j) {
+                const auto byte = static_cast<uint8_t>(packed[i * COMPACT_BLOCK_SHORT_ID_SIZE + j]);
+                shortId |= static_cast<uint64_t>(byte) << (8 * j);
+            }
+            shortTxIds[i] = shortId;
+        }
+
+        return true;
+    }
+
+    bool resolveShortTransactionIds(const Crypto::Hash &key,
+                                    const std::vector<Crypto::Hash> &poolTransactionHashes,
+                                    const std::vector<uint64_t> &shortTxIds,
+                                    std::vector<Crypto::Hash> &transactionHashes)
+    {
+        std::unordered_map<uint64_t, Crypto::Hash> poolShortIds;
+        std::unordered_set<uint64_t> ambiguousShortIds;
+        poolShortIds.reserve (poolTransactionHashes.size ());
+        for (const auto &transactionHash : poolTransactionHashes) {
+            const uint64_t shortId = getShortTransactionId (key, transactionHash);
+            if (!poolShortIds.emplace (shortId, transactionHash).second) {
+                ambiguousShortIds.insert (shortId);
+            }
+        }
+
+        transactionHashes.reserve (transactionHashes.size () + shortTxIds.size ());
+        for (const auto shortId : shortTxIds) {
+            auto poolSearch = poolShortIds.find (shortId);
+            if (poolSearch == poolShortIds.end () || ambiguousShortIds.count (shortId) != 0) {
+                return false;
+            }
+
+            transactionHashes.push_back (poolSearch->second);
+        }
+
+        return true;
+    }
+
+} // namespace CryptoNote
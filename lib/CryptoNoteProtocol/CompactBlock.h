@@ -0,0 +1,58 @@
+// Copyright (c) 2018-2020, The Qwertycoin Project
+//
+// This file is part of Qwertycoin.
+//
+// Qwertycoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Qwertycoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Qwertycoin.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <CryptoTypes.h>
+
+namespace CryptoNote {
+
+    const size_t COMPACT_BLOCK_SHORT_ID_SIZE = 6;
+
+    /*!
+        the short id key is salted with a per announce nonce, so a collision crafted
+        against one announce doesn't carry over to the next hop
+    */
+    Crypto::Hash getCompactBlockKey(const Crypto::Hash &blockHash, uint64_t nonce);
+
+    /*!
+        the first COMPACT_BLOCK_SHORT_ID_SIZE bytes of keccak(key || transactionHash)
+    */
+    uint64_t getShortTransactionId(const Crypto::Hash &key, const Crypto::Hash &transactionHash);
+
+    /*!
+        short ids go on the wire as one blob, COMPACT_BLOCK_SHORT_ID_SIZE little endian
+        bytes each. unpacking fails on a blob of any other length
+    */
+    std::string packShortTransactionIds(const std::vector<uint64_t> &shortTxIds);
+    bool unpackShortTransactionIds(const std::string &packed, std::vector<uint64_t> &shortTxIds);
+
+    /*!
+        maps the short ids of a compact block back to transaction hashes of the pool.
+        fails if a short id matches no pool transaction, or two of them
+    */
+    bool resolveShortTransactionIds(const Crypto::Hash &key,
+                                    const std::vector<Crypto::Hash> &poolTransactionHashes,
+                                    const std::vector<uint64_t> &shortTxIds,
+                                    std::vector<Crypto::Hash> &transactionHashes);
+
+} // namespace CryptoNote
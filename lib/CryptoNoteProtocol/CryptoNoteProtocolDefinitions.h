@@ -181,4 +181,52 @@ namespace CryptoNote {
         const static int ID = BC_COMMANDS_POOL_BASE + 10;
         typedef NOTIFY_MISSING_TXS_request request;
     };
+
+    /*!
+        a lite block whose transaction hashes are replaced by salted 6 byte short ids,
+        the coinbase travels in full inside the stripped block template
+    */
+    struct NOTIFY_NEW_COMPACT_BLOCK_request
+    {
+        BinaryArray blockTemplate;
+        Crypto::Hash blockHash;
+        uint64_t nonce;
+        std::vector<uint64_t> shortTxIds;
+        uint32_t current_blockchain_height;
+        uint32_t hop;
+    };
+
+    struct NOTIFY_NEW_COMPACT_BLOCK
+    {
+        const static int ID = BC_COMMANDS_POOL_BASE + 11;
+        typedef NOTIFY_NEW_COMPACT_BLOCK_request request;
+    };
+
+    struct NOTIFY_NEW_TRANSACTION_HASHES_request
+    {
+        std::vector<Crypto::Hash> txs;
+    };
+
+    struct NOTIFY_NEW_TRANSACTION_HASHES
+    {
+        const static int ID = BC_COMMANDS_POOL_BASE + 12;
+        typedef NOTIFY_NEW_TRANSACTION_HASHES_request request;
+    };
+
+    struct NOTIFY_REQUEST_TRANSACTIONS_request
+    {
+        std::vector<Crypto::Hash> txs;
+    };
+
+    struct NOTIFY_REQUEST_TRANSACTIONS
+    {
+        const static int ID = BC_COMMANDS_POOL_BASE + 13;
+        typedef NOTIFY_REQUEST_TRANSACTIONS_request request;
+    };
+
+    struct NOTIFY_RESPONSE_TRANSACTIONS
+    {
+        const static int ID = BC_COMMANDS_POOL_BASE + 14;
+        typedef NOTIFY_NEW_TRANSACTIONS_request request;
+    };
 } // namespace CryptoNote
@@ -20,7 +20,10 @@
 // along with Qwertycoin.  If not, see <http://www.gnu.org/licenses/>.
 
 
+#include <algorithm>
 #include <future>
+#include <iterator>
+#include <map>
 #include <boost/scope_exit.hpp>
 #include <boost/uuid/uuid_io.hpp>
 #include <System/Dispatcher.h>
@@ -31,7 +34,11 @@
 #include <CryptoNoteCore/CryptoNoteFormatUtils.h>
 #include <CryptoNoteCore/Currency.h>
 
+#include <CryptoNoteProtocol/CompactBlock.h>
 #include <CryptoNoteProtocol/CryptoNoteProtocolHandler.h>
+#include <CryptoNoteProtocol/GetObjectsResponseEncoder.h>
+
+#include <Crypto/Random.h>
 
 #include <Global/Constants.h>
 #include <Global/CryptoNoteConfig.h>
@@ -57,26 +64,6 @@ namespace CryptoNote {
             return p2p.invokeNotifyToPeer (t_parametr::ID, LevinProtocol::encode (arg), context);
         }
 
-        template<class t_parametr>
-        void relay_post_notify(IP2pEndpoint &p2p,
-                               typename t_parametr::request &arg,
-                               const boost::uuids::uuid *excludeConnection = nullptr)
-        {
-            p2p.externalRelayNotifyToAll (t_parametr::ID, LevinProtocol::encode (arg), excludeConnection);
-        }
-
-        std::vector<RawBlockLegacy> convertRawBlocksToRawBlocksLegacy(const std::vector<RawBlock> &rawBlocks)
-        {
-            std::vector<RawBlockLegacy> legacy;
-            legacy.reserve (rawBlocks.size ());
-
-            for (const auto &rawBlock: rawBlocks) {
-                legacy.emplace_back (RawBlockLegacy{rawBlock.block, rawBlock.transactions});
-            }
-
-            return legacy;
-        }
-
         std::vector<RawBlock> convertRawBlocksLegacyToRawBlocks(const std::vector<RawBlockLegacy> &legacy)
         {
             std::vector<RawBlock> rawBlocks;
@@ -88,6 +75,24 @@ namespace CryptoNote {
 
             return rawBlocks;
         }
+
+        /*!
+         * number of peers a new block is announced to as a compact block, they are the
+         * peers which delivered new blocks to us most recently, everyone else gets a
+         * lite block and can't be made to wait on a round trip by a short id miss
+         */
+        const size_t COMPACT_BLOCK_HIGH_BANDWIDTH_PEERS = 3;
+
+        /*!
+         * an announced transaction requested from one peer isn't requested from
+         * the others announcing it until the first request had this long to answer
+         */
+        const time_t TRANSACTION_REQUEST_TIMEOUT = 30;
+
+        /*!
+         * number of further announcers remembered per requested transaction
+         */
+        const size_t TRANSACTION_ANNOUNCERS_LIMIT = 8;
     } // namespace
 
     /*!
@@ -202,6 +207,46 @@ namespace CryptoNote {
         serializeAsBinary (request.missing_txs, "missing_txs", s);
     }
 
+    static inline void serialize(NOTIFY_NEW_TRANSACTION_HASHES_request &request, ISerializer &s)
+    {
+        serializeAsBinary (request.txs, "txs", s);
+    }
+
+    static inline void serialize(NOTIFY_REQUEST_TRANSACTIONS_request &request, ISerializer &s)
+    {
+        serializeAsBinary (request.txs, "txs", s);
+    }
+
+    /*!
+     * short ids are packed 6 bytes each, little endian, into a single blob
+     */
+    static inline void serialize(NOTIFY_NEW_COMPACT_BLOCK_request &request, ISerializer &s)
+    {
+        std::string blockTemplate;
+        std::string shortTxIds;
+
+        s (request.current_blockchain_height, "current_blockchain_height");
+        s (request.hop, "hop");
+        s (request.blockHash, "blockHash");
+        s (request.nonce, "nonce");
+
+        if (s.type () == ISerializer::INPUT) {
+            s (blockTemplate, "blockTemplate");
+            request.blockTemplate.assign (blockTemplate.begin (), blockTemplate.end ());
+
+            s (shortTxIds, "shortTxIds");
+            if (!unpackShortTransactionIds (shortTxIds, request.shortTxIds)) {
+                throw std::runtime_error ("Compact block short transaction ids size mismatch");
+            }
+        } else {
+            blockTemplate.assign (request.blockTemplate.begin (), request.blockTemplate.end ());
+            s (blockTemplate, "blockTemplate");
+
+            shortTxIds = packShortTransactionIds (request.shortTxIds);
+            s (shortTxIds, "shortTxIds");
+        }
+    }
+
     CryptoNoteProtocolHandler::CryptoNoteProtocolHandler(const Currency &currency,
                                                          System::Dispatcher &dispatcher,
                                                          ICore &rcore,
@@ -217,7 +262,8 @@ namespace CryptoNote {
         m_observedHeight (0),
         m_blockchainHeight (0),
         m_peersCount (0),
-        logger (log, "protocol")
+        logger (log, "protocol"),
+        m_requestedTransactions (TRANSACTION_REQUEST_TIMEOUT, TRANSACTION_ANNOUNCERS_LIMIT)
     {
 
         if (!m_p2p) {
@@ -268,6 +314,12 @@ namespace CryptoNote {
             m_observerManager.notify (&ICryptoNoteProtocolObserver::lastKnownBlockHeightUpdated, m_observedHeight);
         }
 
+        /*!
+            transactions asked from this peer are asked from their next announcer
+            on the next idle tick instead of waiting out the request timeout
+        */
+        m_requestedTransactions.onPeerDisconnected (context.m_connection_id);
+
         if (context.m_state != CryptoNoteConnectionContext::StateBeforeHandshake) {
             m_peersCount--;
             m_observerManager.notify (&ICryptoNoteProtocolObserver::peerCountUpdated, m_peersCount.load ());
@@ -453,10 +505,37 @@ namespace CryptoNote {
             /*!
              * let the socket to send response to handshake, but request callback, to let send request data after response
              */
-            logger (Logging::TRACE)
-                << context
-                << "requesting synchronization";
-            context.m_state = CryptoNoteConnectionContext::StateSyncRequired;
+            /*!
+             * blocks are downloaded from a few peers at once, a peer scoring no better
+             * than those already at it waits for the next timed sync to try again.
+             * Scores include what the peerlist remembers of each address, so a fresh
+             * connection isn't preferred just because nothing was measured on it yet
+             */
+            const int64_t score = m_p2p->getPeerStats (context).score ();
+            size_t betterSynchronizingPeers = 0;
+            m_p2p->forEachConnection ([&](const CryptoNoteConnectionContext &ctx, uint64_t peerId)
+                                      {
+                                          if (ctx.m_connection_id != context.m_connection_id
+                                              && (ctx.m_state == CryptoNoteConnectionContext::StateSynchronizing
+                                                  || ctx.m_state == CryptoNoteConnectionContext::StateSyncRequired)
+                                              && m_p2p->getPeerStats (ctx).score () >= score) {
+                                              ++betterSynchronizingPeers;
+                                          }
+                                      });
+
+            if (betterSynchronizingPeers >= P2P_MAX_SYNCHRONIZING_PEERS) {
+                logger (Logging::TRACE)
+                    << context
+                    << "enough better scored peers are synchronizing, not requesting synchronization";
+                context.m_state = is_inital
+                                  ? CryptoNoteConnectionContext::StatePoolSyncRequired
+                                  : CryptoNoteConnectionContext::StateNormal;
+            } else {
+                logger (Logging::TRACE)
+                    << context
+                    << "requesting synchronization";
+                context.m_state = CryptoNoteConnectionContext::StateSyncRequired;
+            }
         }
 
         updateObservedHeight (hshd.current_height, context);
@@ -536,6 +615,10 @@ namespace CryptoNote {
             HANDLE_NOTIFY(NOTIFY_REQUEST_TX_POOL, handleRequestTxPool)
             HANDLE_NOTIFY(NOTIFY_NEW_LITE_BLOCK, handleNotifyNewLiteBlock)
             HANDLE_NOTIFY(NOTIFY_MISSING_TXS, handleNotifyMissingTxs)
+            HANDLE_NOTIFY(NOTIFY_NEW_COMPACT_BLOCK, handleNotifyNewCompactBlock)
+            HANDLE_NOTIFY(NOTIFY_NEW_TRANSACTION_HASHES, handleNotifyNewTransactionHashes)
+            HANDLE_NOTIFY(NOTIFY_REQUEST_TRANSACTIONS, handleRequestTransactions)
+            HANDLE_NOTIFY(NOTIFY_RESPONSE_TRANSACTIONS, handleResponseTransactions)
 
             default:
                 handled = false;
@@ -564,12 +647,14 @@ namespace CryptoNote {
         auto result = m_core.addBlock (RawBlock{arg.block.blockTemplate, arg.block.transactions});
         if (result == error::AddBlockErrorCondition::BLOCK_ADDED) {
             if (result == error::AddBlockErrorCode::ADDED_TO_ALTERNATIVE_AND_SWITCHED) {
+                context.m_last_new_block_time = static_cast<uint64_t>(time (nullptr));
                 ++arg.hop;
                 //TODO: Add here announce protocol usage
                 relayBlock (arg);
                 // relay_block(arg, context);
                 requestMissingPoolTransactions (context);
             } else if (result == error::AddBlockErrorCode::ADDED_TO_MAIN) {
+                context.m_last_new_block_time = static_cast<uint64_t>(time (nullptr));
                 ++arg.hop;
                 //TODO: Add here announce protocol usage
                 relayBlock (arg);
@@ -597,6 +682,7 @@ namespace CryptoNote {
                 << context
                 << "Block verification failed, dropping connection: "
                 << result.message ();
+            ++context.m_stats.invalidObjects;
             context.m_state = CryptoNoteConnectionContext::StateShutdown;
         }
 
@@ -621,30 +707,166 @@ namespace CryptoNote {
                 << context
                 << " Pending lite block detected, handling request as missing lite block transactions response";
             return doPushLiteBlock (context.m_pending_lite_block->request, context, std::move (arg.txs));
-        } else {
-            const auto it = std::remove_if (arg.txs.begin (), arg.txs.end (), [this, &context](const auto &tx)
-            {
-                bool failed = !this->m_core.addTransactionToPool (tx);
+        }
+
+        processNewTransactions (std::move (arg.txs), context);
+
+        return true;
+    }
+
+    int CryptoNoteProtocolHandler::handleNotifyNewTransactionHashes(int command,
+                                                                    NOTIFY_NEW_TRANSACTION_HASHES::request &arg,
+                                                                    CryptoNoteConnectionContext &context)
+    {
+        logger (Logging::TRACE)
+            << context
+            << "NOTIFY_NEW_TRANSACTION_HASHES: txs.size()="
+            << arg.txs.size ();
+
+        if (context.m_state != CryptoNoteConnectionContext::StateNormal) {
+            return 1;
+        }
+
+        std::unordered_set<Crypto::Hash> announcedHashes;
+        for (const auto &transactionHash : arg.txs) {
+            context.m_known_transactions.insert (transactionHash);
+
+            if (m_requestedTransactions.onAnnounced (transactionHash, context.m_connection_id)) {
+                announcedHashes.insert (transactionHash);
+            }
+        }
+
+        if (announcedHashes.empty ()) {
+            return 1;
+        }
+
+        std::unordered_set<Crypto::Hash> inPool, inBlockchain, unknown;
+        m_core.getTransactionsStatus (std::move (announcedHashes), inPool, inBlockchain, unknown);
+        if (unknown.empty ()) {
+            return 1;
+        }
+
+        /*!
+            the peer serves at most P2P_MAX_PENDING_TRANSACTIONS_PER_PEER
+            transactions per request, so bigger announces are asked in parts
+        */
+        const time_t now = time (nullptr);
+        NOTIFY_REQUEST_TRANSACTIONS::request req;
+        auto flush = [&]()
+        {
+            logger (Logging::TRACE)
+                << context
+                << "-->>NOTIFY_REQUEST_TRANSACTIONS: txs.size()="
+                << req.txs.size ();
+            post_notify<NOTIFY_REQUEST_TRANSACTIONS> (*m_p2p, req, context);
+            req.txs.clear ();
+        };
+
+        for (const auto &transactionHash : unknown) {
+            req.txs.push_back (transactionHash);
+            m_requestedTransactions.onRequested (transactionHash, context.m_connection_id, now);
+
+            if (req.txs.size () == P2P_MAX_PENDING_TRANSACTIONS_PER_PEER) {
+                flush ();
+            }
+        }
+
+        if (!req.txs.empty ()) {
+            flush ();
+        }
+
+        return 1;
+    }
+
+    int CryptoNoteProtocolHandler::handleRequestTransactions(int command,
+                                                             NOTIFY_REQUEST_TRANSACTIONS::request &arg,
+                                                             CryptoNoteConnectionContext &context)
+    {
+        logger (Logging::TRACE)
+            << context
+            << "NOTIFY_REQUEST_TRANSACTIONS: txs.size()="
+            << arg.txs.size ();
+
+        for (const auto &transactionHash : arg.txs) {
+            context.m_known_transactions.insert (transactionHash);
+        }
+
+        /*!
+            answered in parts of P2P_MAX_PENDING_TRANSACTIONS_PER_PEER, the
+            most the peer validates in one go
+        */
+        for (size_t offset = 0; offset < arg.txs.size (); offset += P2P_MAX_PENDING_TRANSACTIONS_PER_PEER) {
+            const size_t end = std::min (arg.txs.size (), offset + P2P_MAX_PENDING_TRANSACTIONS_PER_PEER);
+            const std::vector<Crypto::Hash> transactionHashes (arg.txs.begin () + offset, arg.txs.begin () + end);
+
+            NOTIFY_RESPONSE_TRANSACTIONS::request rsp;
+            std::vector<Crypto::Hash> missedHashes;
+            m_core.getTransactions (transactionHashes, rsp.txs, missedHashes);
+            if (!rsp.txs.empty ()) {
+                post_notify<NOTIFY_RESPONSE_TRANSACTIONS> (*m_p2p, rsp, context);
+            }
+        }
+
+        return 1;
+    }
+
+    int CryptoNoteProtocolHandler::handleResponseTransactions(int command,
+                                                              NOTIFY_RESPONSE_TRANSACTIONS::request &arg,
+                                                              CryptoNoteConnectionContext &context)
+    {
+        logger (Logging::TRACE)
+            << context
+            << "NOTIFY_RESPONSE_TRANSACTIONS: txs.size()="
+            << arg.txs.size ();
+
+        if (context.m_state != CryptoNoteConnectionContext::StateNormal) {
+            return 1;
+        }
+
+        processNewTransactions (std::move (arg.txs), context);
+
+        return 1;
+    }
+
+    void CryptoNoteProtocolHandler::processNewTransactions(std::vector<BinaryArray> &&transactions,
+                                                           CryptoNoteConnectionContext &context)
+    {
+        std::vector<Crypto::Hash> transactionHashes;
+        transactionHashes.reserve (transactions.size ());
+        for (const auto &transaction : transactions) {
+            transactionHashes.push_back (getBinaryArrayHash (transaction));
+            context.m_known_transactions.insert (transactionHashes.back ());
+            m_requestedTransactions.onReceived (transactionHashes.back ());
+        }
 
-                if (failed) {
-                    this->logger (Logging::DEBUGGING)
+        /*!
+            the peer's connection is not read while its batch is validated, so
+            a big batch goes to the pool in parts of at most
+            P2P_MAX_PENDING_TRANSACTIONS_PER_PEER transactions
+        */
+        std::vector<std::pair<Crypto::Hash, BinaryArray>> relayed;
+        relayed.reserve (transactions.size ());
+        for (size_t offset = 0; offset < transactions.size (); offset += P2P_MAX_PENDING_TRANSACTIONS_PER_PEER) {
+            const size_t end = std::min (transactions.size (), offset + P2P_MAX_PENDING_TRANSACTIONS_PER_PEER);
+            std::vector<BinaryArray> part (std::make_move_iterator (transactions.begin () + offset),
+                                           std::make_move_iterator (transactions.begin () + end));
+
+            const std::vector<bool> added = m_core.addTransactionsToPool (part);
+            for (size_t i = 0; i < part.size (); ++i) {
+                if (!added[i]) {
+                    logger (Logging::DEBUGGING)
                         << context
                         << "Tx verification failed";
+                    continue;
                 }
 
-                return failed;
-            });
-            if (it != arg.txs.end ()) {
-                arg.txs.erase (it, arg.txs.end ());
-            }
-
-            if (arg.txs.size () > 0) {
-                //TODO: add announce usage here
-                relay_post_notify<NOTIFY_NEW_TRANSACTIONS> (*m_p2p, arg, &context.m_connection_id);
+                relayed.emplace_back (transactionHashes[offset + i], std::move (part[i]));
             }
         }
 
-        return true;
+        if (!relayed.empty ()) {
+            queueTransactionsForRelay (std::move (relayed));
+        }
     }
 
     int CryptoNoteProtocolHandler::handleRequestGetObjects(int command,
@@ -654,30 +876,34 @@ namespace CryptoNote {
         logger (Logging::TRACE)
             << context
             << "NOTIFY_REQUEST_GET_OBJECTS";
-        NOTIFY_RESPONSE_GET_OBJECTS::request rsp;
-
-        rsp.current_blockchain_height = m_core.getTopBlockIndex () + 1;
+        const uint32_t currentBlockchainHeight = m_core.getTopBlockIndex () + 1;
         std::vector<RawBlock> rawBlocks;
-        m_core.getBlocks (arg.blocks, rawBlocks, rsp.missed_ids);
+        std::vector<Crypto::Hash> missedIds;
+        m_core.getBlocks (arg.blocks, rawBlocks, missedIds);
         if (!arg.txs.empty ()) {
             logger (Logging::WARNING, Logging::BRIGHT_YELLOW)
                 << context
                 << "NOTIFY_RESPONSE_GET_OBJECTS: request.txs.empty() != true";
         }
 
-        rsp.blocks = convertRawBlocksToRawBlocksLegacy (rawBlocks);
-
         logger (Logging::TRACE)
             << context
             << "-->>NOTIFY_RESPONSE_GET_OBJECTS: blocks.size()="
-            << rsp.blocks.size ()
+            << rawBlocks.size ()
             << ", txs.size()="
-            << rsp.txs.size ()
+            << arg.txs.size ()
             << ", rsp.m_current_blockchain_height="
-            << rsp.current_blockchain_height
+            << currentBlockchainHeight
             << ", missed_ids.size()="
-            << rsp.missed_ids.size ();
-        post_notify<NOTIFY_RESPONSE_GET_OBJECTS> (*m_p2p, rsp, context);
+            << missedIds.size ();
+
+        /*!
+         * serving sync is mostly this message, so it skips the generic serializer
+         * and goes to the peer's write queue without further copies
+         */
+        m_p2p->invokeNotifyToPeer (NOTIFY_RESPONSE_GET_OBJECTS::ID,
+                                   encodeGetObjectsResponse (rawBlocks, missedIds, currentBlockchainHeight),
+                                   context);
         return 1;
     }
 
@@ -710,6 +936,24 @@ namespace CryptoNote {
 
         std::vector<RawBlock> rawBlocks = convertRawBlocksLegacyToRawBlocks (arg.blocks);
 
+        if (context.m_objects_requested_at != std::chrono::steady_clock::time_point ()) {
+            const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds> (
+                std::chrono::steady_clock::now () - context.m_objects_requested_at).count ();
+            context.m_objects_requested_at = std::chrono::steady_clock::time_point ();
+
+            uint64_t bytes = 0;
+            for (const auto &rawBlock : rawBlocks) {
+                bytes += rawBlock.block.size ();
+                for (const auto &transaction : rawBlock.transactions) {
+                    bytes += transaction.size ();
+                }
+            }
+
+            if (elapsed > 0) {
+                context.m_stats.addThroughput (bytes * 1000 / static_cast<uint64_t>(elapsed));
+            }
+        }
+
         for (size_t index = 0; index < rawBlocks.size (); ++index) {
             if (!fromBinaryArray (blockTemplates[index], rawBlocks[index].block)) {
                 logger (Logging::ERROR)
@@ -717,6 +961,7 @@ namespace CryptoNote {
                     << "sent wrong block: failed to parse and validate block: \r\n"
                     << toHex (rawBlocks[index].block)
                     << "\r\n dropping connection";
+                ++context.m_stats.invalidObjects;
                 context.m_state = CryptoNoteConnectionContext::StateShutdown;
                 return 1;
             }
@@ -755,6 +1000,7 @@ namespace CryptoNote {
                     << " mismatch with block_complete_entry.m_txs.size()="
                     << rawBlocks[index].transactions.size ()
                     << ", dropping connection";
+                ++context.m_stats.invalidObjects;
                 context.m_state = CryptoNoteConnectionContext::StateShutdown;
                 return 1;
             }
@@ -773,6 +1019,19 @@ namespace CryptoNote {
             return 1;
         }
 
+        /*!
+            outside of synchronization the only block we ask for is the one of a compact
+            block the pool couldn't rebuild, add and relay it like a lite block
+        */
+        if (context.m_state == CryptoNoteConnectionContext::StateNormal && rawBlocks.size () == 1) {
+            NOTIFY_NEW_LITE_BLOCK::request liteArg;
+            liteArg.blockTemplate = std::move (rawBlocks.front ().block);
+            liteArg.current_blockchain_height = arg.current_blockchain_height;
+            liteArg.hop = 0;
+
+            return doPushLiteBlock (std::move (liteArg), context, std::move (rawBlocks.front ().transactions));
+        }
+
         {
             int result = processObjects (context, std::move (rawBlocks), cachedBlocks);
             if (result != 0) {
@@ -810,6 +1069,7 @@ namespace CryptoNote {
                     << context
                     << "Block verification failed, dropping connection: "
                     << addResult.message ();
+                ++context.m_stats.invalidObjects;
                 context.m_state = CryptoNoteConnectionContext::StateShutdown;
                 return 1;
             } else if (addResult == error::AddBlockErrorCondition::BLOCK_REJECTED) {
@@ -895,6 +1155,7 @@ void CryptoNoteProtocolHandler::setTxThreshold(size_t count)
             logger (Logging::WARNING)
                 << context
                 << "Deserialization of Block Template failed, dropping connection";
+            ++context.m_stats.invalidObjects;
             context.m_state = CryptoNoteConnectionContext::StateShutdown;
             return 1;
         }
@@ -956,16 +1217,14 @@ void CryptoNoteProtocolHandler::setTxThreshold(size_t count)
             auto result = m_core.addBlock (RawBlock{arg.blockTemplate, have_txs});
             if (result == error::AddBlockErrorCondition::BLOCK_ADDED) {
                 if (result == error::AddBlockErrorCode::ADDED_TO_ALTERNATIVE_AND_SWITCHED) {
+                    context.m_last_new_block_time = static_cast<uint64_t>(time (nullptr));
                     ++arg.hop;
-                    //TODO: Add here announce protocol usage
-                    relay_post_notify<NOTIFY_NEW_LITE_BLOCK> (*m_p2p, arg, &context.m_connection_id);
-                    // relay_block(arg, context);
+                    relayBlockToPeers (arg, newBlockTemplate, nullptr, &context.m_connection_id);
                     requestMissingPoolTransactions (context);
                 } else if (result == error::AddBlockErrorCode::ADDED_TO_MAIN) {
+                    context.m_last_new_block_time = static_cast<uint64_t>(time (nullptr));
                     ++arg.hop;
-                    //TODO: Add here announce protocol usage
-                    relay_post_notify<NOTIFY_NEW_LITE_BLOCK> (*m_p2p, arg, &context.m_connection_id);
-                    // relay_block(arg, context);
+                    relayBlockToPeers (arg, newBlockTemplate, nullptr, &context.m_connection_id);
                 } else if (result == error::AddBlockErrorCode::ADDED_TO_ALTERNATIVE) {
                     logger (Logging::TRACE)
                         << context
@@ -989,6 +1248,7 @@ void CryptoNoteProtocolHandler::setTxThreshold(size_t count)
                     << context
                     << "Block verification failed, dropping connection: "
                     << result.message ();
+                ++context.m_stats.invalidObjects;
                 context.m_state = CryptoNoteConnectionContext::StateShutdown;
             }
         } else {
@@ -1084,6 +1344,7 @@ void CryptoNoteProtocolHandler::setTxThreshold(size_t count)
                 << req.blocks.size ()
                 << ", txs.size()="
                 << req.txs.size ();
+            context.m_objects_requested_at = std::chrono::steady_clock::now ();
             post_notify<NOTIFY_REQUEST_GET_OBJECTS> (*m_p2p, req, context);
         } else if (context.m_last_response_height
                    < context.m_remote_blockchain_height
@@ -1306,40 +1567,127 @@ void CryptoNoteProtocolHandler::setTxThreshold(size_t count)
         return 1;
     }
 
-    void CryptoNoteProtocolHandler::relayBlock(NOTIFY_NEW_BLOCK::request &arg)
+    int CryptoNoteProtocolHandler::handleNotifyNewCompactBlock(int command,
+                                                               NOTIFY_NEW_COMPACT_BLOCK::request &arg,
+                                                               CryptoNoteConnectionContext &context)
     {
+        logger (Logging::TRACE)
+            << context
+            << "NOTIFY_NEW_COMPACT_BLOCK (hop "
+            << arg.hop
+            << ")";
+        updateObservedHeight (arg.current_blockchain_height, context);
+        context.m_remote_blockchain_height = arg.current_blockchain_height;
+        if (context.m_state != CryptoNoteConnectionContext::StateNormal) {
+            return 1;
+        }
+
+        if (m_core.hasBlock (arg.blockHash)) {
+            logger (Logging::TRACE)
+                << context
+                << "Block already exists";
+            return 1;
+        }
+
+        Block newBlockTemplate;
+        if (!fromBinaryArray (newBlockTemplate, arg.blockTemplate) || !newBlockTemplate.transactionHashes.empty ()) {
+            logger (Logging::WARNING)
+                << context
+                << "Deserialization of compact Block Template failed, dropping connection";
+            ++context.m_stats.invalidObjects;
+            context.m_state = CryptoNoteConnectionContext::StateShutdown;
+            return 1;
+        }
+
+        const bool reconstructed = resolveShortTransactionIds (getCompactBlockKey (arg.blockHash, arg.nonce),
+                                                               m_core.getPoolTransactionHashes (),
+                                                               arg.shortTxIds,
+                                                               newBlockTemplate.transactionHashes);
+
+        if (reconstructed && CachedBlock (newBlockTemplate).getBlockHash () == arg.blockHash) {
+            NOTIFY_NEW_LITE_BLOCK::request liteArg;
+            liteArg.blockTemplate = toBinaryArray (newBlockTemplate);
+            liteArg.current_blockchain_height = arg.current_blockchain_height;
+            liteArg.hop = arg.hop;
+
+            return doPushLiteBlock (std::move (liteArg), context, {});
+        }
+
+        /*
+       * the pool doesn't hold the block's transactions (or a short id
+       * collided), fetch the whole block from the announcing peer
+       */
+        logger (Logging::DEBUGGING)
+            << context
+            << "Compact block "
+            << Common::podToHex (arg.blockHash)
+            << " couldn't be reconstructed from the pool, requesting the full block";
+
+        if (!context.m_requested_objects.empty () || context.m_pending_lite_block.has_value ()) {
+            return 1;
+        }
+
+        NOTIFY_REQUEST_GET_OBJECTS::request req;
+        req.blocks.push_back (arg.blockHash);
+        context.m_requested_objects.insert (arg.blockHash);
+        context.m_objects_requested_at = std::chrono::steady_clock::now ();
+        if (!post_notify<NOTIFY_REQUEST_GET_OBJECTS> (*m_p2p, req, context)) {
+            logger (Logging::DEBUGGING)
+                << context
+                << "Compact block can't be reconstructed but the publisher is not reachable, dropping connection.";
+            context.m_state = CryptoNoteConnectionContext::StateShutdown;
+        }
+
+        return 1;
+    }
 
+    void CryptoNoteProtocolHandler::relayBlock(NOTIFY_NEW_BLOCK::request &arg)
+    {
         // generate a lite block request from the received normal block.
         NOTIFY_NEW_LITE_BLOCK::request lite_arg;
         lite_arg.current_blockchain_height = arg.current_blockchain_height;
         lite_arg.blockTemplate = arg.block.blockTemplate;
         lite_arg.hop = arg.hop;
 
-        // encoding the request for sending the blocks to peers.
+        Block block;
+        if (!fromBinaryArray (block, arg.block.blockTemplate)) {
+            logger (Logging::ERROR)
+                << "Failed to parse block template of the block to relay";
+            return;
+        }
+
         auto buf = LevinProtocol::encode (arg);
-        auto lite_buf = LevinProtocol::encode (lite_arg);
 
         // logging the msg size to see the difference in payload size.
         logger (Logging::DEBUGGING)
             << "NOTIFY_NEW_BLOCK - MSG_SIZE = "
             << buf.size ();
-        logger (Logging::DEBUGGING)
-            << "NOTIFY_NEW_LITE_BLOCK - MSG_SIZE = "
-            << lite_buf.size ();
 
-        std::list<boost::uuids::uuid> liteBlockConnections, normalBlockConnections;
+        relayBlockToPeers (lite_arg, block, &buf, nullptr);
+    }
+
+    void CryptoNoteProtocolHandler::relayBlockToPeers(const NOTIFY_NEW_LITE_BLOCK::request &liteArg,
+                                                      const Block &block,
+                                                      const BinaryArray *fullBlockBuffer,
+                                                      const boost::uuids::uuid *excludeConnection)
+    {
+        std::vector<std::pair<uint64_t, boost::uuids::uuid>> compactBlockCandidates;
+        std::list<boost::uuids::uuid> compactBlockConnections, liteBlockConnections, normalBlockConnections;
 
         // sort the peers into their support categories.
         m_p2p
-            ->forEachConnection ([this,
-                                    &liteBlockConnections,
-                                    &normalBlockConnections](const CryptoNoteConnectionContext &ctx,
-                                                             uint64_t peerId)
+            ->forEachConnection ([&](const CryptoNoteConnectionContext &ctx, uint64_t peerId)
                                    {
-                                       if (ctx.version >= P2P_LITE_BLOCKS_PROPOGATION_VERSION) {
-                                           logger (Logging::DEBUGGING)
-                                               << ctx
-                                               << "Peer supports lite-blocks... adding peer to lite block list";
+                                       if (excludeConnection != nullptr
+                                           && ctx.m_connection_id == *excludeConnection) {
+                                           return;
+                                       }
+
+                                       if (ctx.version >= P2P_COMPACT_BLOCKS_PROPOGATION_VERSION) {
+                                           compactBlockCandidates.emplace_back (ctx.m_last_new_block_time,
+                                                                                ctx.m_connection_id);
+                                       } else if (ctx.version >= P2P_LITE_BLOCKS_PROPOGATION_VERSION
+                                                  || fullBlockBuffer == nullptr) {
                                            liteBlockConnections.push_back (ctx.m_connection_id);
                                        } else {
                                            logger (Logging::DEBUGGING)
@@ -1349,20 +1697,174 @@ void CryptoNoteProtocolHandler::setTxThreshold(size_t count)
                                        }
                                    });
 
-        // first send lite one's.. coz they are faster
+        // the peers which delivered new blocks to us most recently are the high bandwidth ones.
+        const size_t highBandwidthPeers = std::min (compactBlockCandidates.size (),
+                                                    COMPACT_BLOCK_HIGH_BANDWIDTH_PEERS);
+        std::partial_sort (compactBlockCandidates.begin (),
+                           compactBlockCandidates.begin () + highBandwidthPeers,
+                           compactBlockCandidates.end (),
+                           [](const std::pair<uint64_t, boost::uuids::uuid> &lhs,
+                              const std::pair<uint64_t, boost::uuids::uuid> &rhs)
+                           {
+                               return lhs.first > rhs.first;
+                           });
+        for (size_t i = 0; i < compactBlockCandidates.size (); ++i) {
+            if (i < highBandwidthPeers) {
+                compactBlockConnections.push_back (compactBlockCandidates[i].second);
+            } else {
+                liteBlockConnections.push_back (compactBlockCandidates[i].second);
+            }
+        }
+
+        // first send compact one's.. they are the smallest and get rebuilt from the pool
+        if (!compactBlockConnections.empty ()) {
+            NOTIFY_NEW_COMPACT_BLOCK::request compact_arg;
+            compact_arg.current_blockchain_height = liteArg.current_blockchain_height;
+            compact_arg.hop = liteArg.hop;
+            compact_arg.blockHash = CachedBlock (block).getBlockHash ();
+            compact_arg.nonce = Random::randomValue<uint64_t> ();
+
+            const Crypto::Hash key = getCompactBlockKey (compact_arg.blockHash, compact_arg.nonce);
+            compact_arg.shortTxIds.reserve (block.transactionHashes.size ());
+            for (const auto &transactionHash : block.transactionHashes) {
+                compact_arg.shortTxIds.push_back (getShortTransactionId (key, transactionHash));
+            }
+
+            Block strippedBlock = block;
+            strippedBlock.transactionHashes.clear ();
+            compact_arg.blockTemplate = toBinaryArray (strippedBlock);
+
+            auto compact_buf = LevinProtocol::encode (compact_arg);
+            logger (Logging::DEBUGGING)
+                << "NOTIFY_NEW_COMPACT_BLOCK - MSG_SIZE = "
+                << compact_buf.size ();
+
+            m_p2p->externalRelayNotifyToList (NOTIFY_NEW_COMPACT_BLOCK::ID, compact_buf, compactBlockConnections);
+        }
+
         if (!liteBlockConnections.empty ()) {
+            auto lite_buf = LevinProtocol::encode (liteArg);
+            logger (Logging::DEBUGGING)
+                << "NOTIFY_NEW_LITE_BLOCK - MSG_SIZE = "
+                << lite_buf.size ();
+
             m_p2p->externalRelayNotifyToList (NOTIFY_NEW_LITE_BLOCK::ID, lite_buf, liteBlockConnections);
         }
 
         if (!normalBlockConnections.empty ()) {
-            m_p2p->externalRelayNotifyToList (NOTIFY_NEW_BLOCK::ID, buf, normalBlockConnections);
+            m_p2p->externalRelayNotifyToList (NOTIFY_NEW_BLOCK::ID, *fullBlockBuffer, normalBlockConnections);
         }
     }
 
     void CryptoNoteProtocolHandler::relayTransactions(const std::vector<BinaryArray> &transactions)
     {
-        auto buf = LevinProtocol::encode (NOTIFY_NEW_TRANSACTIONS::request{transactions});
-        m_p2p->externalRelayNotifyToAll (NOTIFY_NEW_TRANSACTIONS::ID, buf, nullptr);
+        std::vector<std::pair<Crypto::Hash, BinaryArray>> relayed;
+        relayed.reserve (transactions.size ());
+        for (const auto &transaction : transactions) {
+            relayed.emplace_back (getBinaryArrayHash (transaction), transaction);
+        }
+
+        queueTransactionsForRelay (std::move (relayed));
+    }
+
+    void CryptoNoteProtocolHandler::queueTransactionsForRelay(
+        std::vector<std::pair<Crypto::Hash, BinaryArray>> &&transactions)
+    {
+        std::lock_guard<std::mutex> lock (m_transactionRelayMutex);
+
+        if (m_transactionRelayQueue.empty ()) {
+            m_transactionRelayQueue = std::move (transactions);
+        } else {
+            std::move (transactions.begin (), transactions.end (), std::back_inserter (m_transactionRelayQueue));
+        }
+    }
+
+    void CryptoNoteProtocolHandler::relayQueuedTransactions()
+    {
+        std::vector<std::pair<Crypto::Hash, BinaryArray>> queue;
+        {
+            std::lock_guard<std::mutex> lock (m_transactionRelayMutex);
+            queue.swap (m_transactionRelayQueue);
+        }
+
+        rerequestTransactions ();
+
+        if (queue.empty ()) {
+            return;
+        }
+
+        m_p2p->forEachConnection ([this, &queue](CryptoNoteConnectionContext &ctx, uint64_t peerId)
+                                  {
+                                      if (ctx.m_state != CryptoNoteConnectionContext::StateNormal
+                                          && ctx.m_state != CryptoNoteConnectionContext::StateSynchronizing) {
+                                          return;
+                                      }
+
+                                      // peers without inventory support still get the blobs pushed, in batches.
+                                      const bool announceHashes = ctx.version >= P2P_TRANSACTION_INVENTORY_VERSION;
+                                      NOTIFY_NEW_TRANSACTION_HASHES::request hashes;
+                                      NOTIFY_NEW_TRANSACTIONS::request blobs;
+
+                                      auto flush = [&]()
+                                      {
+                                          if (!hashes.txs.empty ()) {
+                                              post_notify<NOTIFY_NEW_TRANSACTION_HASHES> (*m_p2p, hashes, ctx);
+                                              hashes.txs.clear ();
+                                          }
+                                          if (!blobs.txs.empty ()) {
+                                              post_notify<NOTIFY_NEW_TRANSACTIONS> (*m_p2p, blobs, ctx);
+                                              blobs.txs.clear ();
+                                          }
+                                      };
+
+                                      for (const auto &transaction : queue) {
+                                          if (ctx.m_known_transactions.contains (transaction.first)) {
+                                              continue;
+                                          }
+                                          ctx.m_known_transactions.insert (transaction.first);
+
+                                          if (announceHashes) {
+                                              hashes.txs.push_back (transaction.first);
+                                          } else {
+                                              blobs.txs.push_back (transaction.second);
+                                          }
+
+                                          if (hashes.txs.size () + blobs.txs.size ()
+                                              == P2P_MAX_PENDING_TRANSACTIONS_PER_PEER) {
+                                              flush ();
+                                          }
+                                      }
+
+                                      flush ();
+                                  });
+    }
+
+    void CryptoNoteProtocolHandler::rerequestTransactions()
+    {
+        const time_t now = time (nullptr);
+        std::map<boost::uuids::uuid, NOTIFY_REQUEST_TRANSACTIONS::request> requests;
+        for (auto &rerequest : m_requestedTransactions.takeRerequests (now)) {
+            requests[rerequest.first].txs = std::move (rerequest.second);
+        }
+
+        if (requests.empty ()) {
+            return;
+        }
+
+        m_p2p->forEachConnection ([this, &requests](CryptoNoteConnectionContext &ctx, uint64_t peerId)
+                                  {
+                                      auto request = requests.find (ctx.m_connection_id);
+                                      if (request == requests.end ()
+                                          || ctx.m_state != CryptoNoteConnectionContext::StateNormal) {
+                                          return;
+                                      }
+
+                                      logger (Logging::TRACE)
+                                          << ctx
+                                          << "-->>NOTIFY_REQUEST_TRANSACTIONS: txs.size()="
+                                          << request->second.txs.size ();
+                                      post_notify<NOTIFY_REQUEST_TRANSACTIONS> (*m_p2p, request->second, ctx);
+                                  });
     }
 
     void CryptoNoteProtocolHandler::requestMissingPoolTransactions(const CryptoNoteConnectionContext &context)
@@ -22,6 +22,7 @@
 #pragma once
 
 #include <atomic>
+#include <deque>
 
 #include <Common/ObserverManager.h>
 
@@ -31,6 +32,7 @@
 #include <CryptoNoteProtocol/CryptoNoteProtocolHandlerCommon.h>
 #include <CryptoNoteProtocol/ICryptoNoteProtocolObserver.h>
 #include <CryptoNoteProtocol/ICryptoNoteProtocolQuery.h>
+#include <CryptoNoteProtocol/TransactionRequestTracker.h>
 
 #include <P2p/P2pProtocolDefinitions.h>
 #include <P2p/NetNodeCommon.h>
@@ -87,6 +89,14 @@ namespace CryptoNote {
         virtual uint32_t getBlockchainHeight() const override;
         void requestMissingPoolTransactions(const CryptoNoteConnectionContext &context);
 
+        /*!
+         * sends the transactions queued since the last call, peers with inventory support
+         * get their hashes and request the ones they lack, older peers get the blobs,
+         * nothing goes to a peer already known to have it. called once a second by the
+         * node's idle loop, so relays trickle out in batches instead of one push each
+         */
+        void relayQueuedTransactions();
+
     private:
         /*!
          * commands handlers
@@ -116,6 +126,18 @@ namespace CryptoNote {
                                      CryptoNoteConnectionContext &context);
         int
         handleNotifyMissingTxs(int command, NOTIFY_MISSING_TXS::request &arg, CryptoNoteConnectionContext &context);
+        int handleNotifyNewCompactBlock(int command,
+                                        NOTIFY_NEW_COMPACT_BLOCK::request &arg,
+                                        CryptoNoteConnectionContext &context);
+        int handleNotifyNewTransactionHashes(int command,
+                                             NOTIFY_NEW_TRANSACTION_HASHES::request &arg,
+                                             CryptoNoteConnectionContext &context);
+        int handleRequestTransactions(int command,
+                                      NOTIFY_REQUEST_TRANSACTIONS::request &arg,
+                                      CryptoNoteConnectionContext &context);
+        int handleResponseTransactions(int command,
+                                       NOTIFY_RESPONSE_TRANSACTIONS::request &arg,
+                                       CryptoNoteConnectionContext &context);
 
         /*!
          * i_cryptonote_protocol
@@ -131,6 +153,9 @@ namespace CryptoNote {
         int processObjects(CryptoNoteConnectionContext &context,
                            std::vector<RawBlock> &&rawBlocks,
                            const std::vector<CachedBlock> &cachedBlocks);
+        void processNewTransactions(std::vector<BinaryArray> &&transactions,
+                                    CryptoNoteConnectionContext &context);
+        void queueTransactionsForRelay(std::vector<std::pair<Crypto::Hash, BinaryArray>> &&transactions);
         Logging::LoggerRef logger;
 
         /*!
@@ -150,11 +175,27 @@ namespace CryptoNote {
         std::atomic_uint64_t m_transactionsPushedInterval{4 * 60};
         std::atomic_size_t m_transactionsPushedMaxInInterval{15};
 
+        std::mutex m_transactionRelayMutex;
+        std::vector<std::pair<Crypto::Hash, BinaryArray>> m_transactionRelayQueue;
+        TransactionRequestTracker m_requestedTransactions;
+
+        void rerequestTransactions();
+
     private:
         int doPushLiteBlock(NOTIFY_NEW_LITE_BLOCK::request block,
                             CryptoNoteConnectionContext &context,
                             std::vector<BinaryArray> missingTxs);
 
+        /*!
+         * announces a new block as a compact block to the few peers which delivered
+         * blocks to us most recently, as a lite block to the other peers and as a full
+         * block to peers without lite block support when the full block is at hand
+         */
+        void relayBlockToPeers(const NOTIFY_NEW_LITE_BLOCK::request &liteArg,
+                               const Block &block,
+                               const BinaryArray *fullBlockBuffer,
+                               const boost::uuids::uuid *excludeConnection);
+
     private:
 
         System::Dispatcher &m_dispatcher;
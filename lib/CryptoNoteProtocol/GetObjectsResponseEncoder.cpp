@@ -0,0 +1,93 @@
+// Copyright (c) 2018-2020, The Qwertycoin Project
+//
+// This file is part of Qwertycoin.
+//
+// Qwertycoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Qwertycoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Qwertycoin.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <Common/StreamTools.h>
+#include <Common/VectorOutputStream.h>
+
+#include <CryptoNoteProtocol/GetObjectsResponseEncoder.h>
+
+#include <Serialization/KVBinaryCommon.h>
+#include <Serialization/KVBinaryOutputStreamSerializer.h>
+
+namespace CryptoNote {
+
+    namespace {
+
+        void writeBlob(Common::IOutputStream &out, const void *data, size_t size)
+        {
+            writeKVBinaryArraySize (out, size);
+            Common::write (out, data, size);
+        }
+
+    } // namespace
+
+    BinaryArray encodeGetObjectsResponse(const std::vector<RawBlock> &rawBlocks,
+                                         const std::vector<Crypto::Hash> &missedIds,
+                                         uint32_t currentBlockchainHeight)
+    {
+        size_t reserveSize = 128 + missedIds.size () * sizeof (Crypto::Hash);
+        for (const auto &rawBlock : rawBlocks) {
+            reserveSize += 32 + rawBlock.block.size ();
+            for (const auto &transaction : rawBlock.transactions) {
+                reserveSize += 8 + transaction.size ();
+            }
+        }
+
+        BinaryArray result;
+        result.reserve (reserveSize);
+        Common::VectorOutputStream out (result);
+
+        /*!
+            empty arrays are left out, like the serializer does
+        */
+        writeKVBinaryHeader (out);
+        writeKVBinaryArraySize (out, 1 + (rawBlocks.empty () ? 0 : 1) + (missedIds.empty () ? 0 : 1));
+
+        if (!rawBlocks.empty ()) {
+            writeKVBinaryElementPrefix (out, "blocks", BIN_KV_SERIALIZE_FLAG_ARRAY | BIN_KV_SERIALIZE_TYPE_OBJECT);
+            writeKVBinaryArraySize (out, rawBlocks.size ());
+
+            for (const auto &rawBlock : rawBlocks) {
+                writeKVBinaryArraySize (out, rawBlock.transactions.empty () ? 1 : 2);
+
+                writeKVBinaryElementPrefix (out, "block", BIN_KV_SERIALIZE_TYPE_STRING);
+                writeBlob (out, rawBlock.block.data (), rawBlock.block.size ());
+
+                if (!rawBlock.transactions.empty ()) {
+                    writeKVBinaryElementPrefix (out, "txs", BIN_KV_SERIALIZE_FLAG_ARRAY | BIN_KV_SERIALIZE_TYPE_STRING);
+                    writeKVBinaryArraySize (out, rawBlock.transactions.size ());
+
+                    for (const auto &transaction : rawBlock.transactions) {
+                        writeBlob (out, transaction.data (), transaction.size ());
+                    }
+                }
+            }
+        }
+
+        if (!missedIds.empty ()) {
+            writeKVBinaryElementPrefix (out, "missed_ids", BIN_KV_SERIALIZE_TYPE_STRING);
+            writeBlob (out, missedIds.data (), missedIds.size () * sizeof (Crypto::Hash));
+        }
+
+        writeKVBinaryElementPrefix (out, "current_blockchain_height", BIN_KV_SERIALIZE_TYPE_UINT32);
+        Common::write (out, &currentBlockchainHeight, sizeof (currentBlockchainHeight));
+
+        return result;
+    }
+
+} // namespace CryptoNote
@@ -0,0 +1,38 @@
+// Copyright (c) 2018-2020, The Qwertycoin Project
+//
+// This file is part of Qwertycoin.
+//
+// Qwertycoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Qwertycoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Qwertycoin.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <CryptoNote.h>
+
+namespace CryptoNote {
+
+    /*!
+        Encodes NOTIFY_RESPONSE_GET_OBJECTS byte for byte like LevinProtocol::encode
+        does, but straight from the raw blocks into one buffer sized up front. The
+        generic serializer copies every blob into a string, into the stream of its
+        object, into the stream of the array's parent and into the result in turn.
+    */
+    BinaryArray encodeGetObjectsResponse(const std::vector<RawBlock> &rawBlocks,
+                                         const std::vector<Crypto::Hash> &missedIds,
+                                         uint32_t currentBlockchainHeight);
+
+} // namespace CryptoNote
@@ -0,0 +1,102 @@
+// Copyright (c) 2018-2020, The Qwertycoin Project
+//
+// This file is part of Qwertycoin.
+//
+// Qwertycoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Qwertycoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Qwertycoin.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <algorithm>
+
+#include <CryptoNoteProtocol/TransactionRequestTracker.h>
+
+namespace CryptoNote {
+
+    TransactionRequestTracker::TransactionRequestTracker(time_t requestTimeout, size_t announcersLimit)
+        : m_requestTimeout (requestTimeout),
+          m_announcersLimit (announcersLimit)
+    {
+    }
+
+    bool TransactionRequestTracker::onAnnounced(const Crypto::Hash &transactionHash,
+                                                const boost::uuids::uuid &peer)
+    {
+        auto requested = m_requested.find (transactionHash);
+        if (requested == m_requested.end ()) {
+            return true;
+        }
+
+        auto &announcers = requested->second.announcers;
+        if (requested->second.requestedFrom != peer
+            && announcers.size () < m_announcersLimit
+            && std::find (announcers.begin (), announcers.end (), peer) == announcers.end ()) {
+            announcers.push_back (peer);
+        }
+
+        return false;
+    }
+
+    void TransactionRequestTracker::onRequested(const Crypto::Hash &transactionHash,
+                                                const boost::uuids::uuid &peer,
+                                                time_t now)
+    {
+        m_requested[transactionHash] = RequestedTransaction{now, peer, {}};
+    }
+
+    void TransactionRequestTracker::onReceived(const Crypto::Hash &transactionHash)
+    {
+        m_requested.erase (transactionHash);
+    }
+
+    void TransactionRequestTracker::onPeerDisconnected(const boost::uuids::uuid &peer)
+    {
+        for (auto &requested : m_requested) {
+            auto &announcers = requested.second.announcers;
+            announcers.erase (std::remove (announcers.begin (), announcers.end (), peer), announcers.end ());
+            if (requested.second.requestedFrom == peer) {
+                requested.second.requestedAt = 0;
+            }
+        }
+    }
+
+    std::map<boost::uuids::uuid, std::vector<Crypto::Hash>> TransactionRequestTracker::takeRerequests(time_t now)
+    {
+        std::map<boost::uuids::uuid, std::vector<Crypto::Hash>> rerequests;
+        for (auto it = m_requested.begin (); it != m_requested.end ();) {
+            RequestedTransaction &requested = it->second;
+            if (now - requested.requestedAt <= m_requestTimeout) {
+                ++it;
+                continue;
+            }
+
+            if (requested.announcers.empty ()) {
+                it = m_requested.erase (it);
+                continue;
+            }
+
+            requested.requestedAt = now;
+            requested.requestedFrom = requested.announcers.front ();
+            requested.announcers.pop_front ();
+            rerequests[requested.requestedFrom].push_back (it->first);
+            ++it;
+        }
+
+        return rerequests;
+    }
+
+    size_t TransactionRequestTracker::size() const
+    {
+        return m_requested.size ();
+    }
+
+} // namespace CryptoNote
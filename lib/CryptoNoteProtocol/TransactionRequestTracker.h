@@ -0,0 +1,81 @@
+// Copyright (c) 2018-2020, The Qwertycoin Project
+//
+// This file is part of Qwertycoin.
+//
+// Qwertycoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Qwertycoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Qwertycoin.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include <ctime>
+#include <deque>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/uuid/uuid.hpp>
+
+#include <CryptoTypes.h>
+
+namespace CryptoNote {
+
+    /*!
+        Keeps track of announced transactions asked from one peer. Every other peer
+        announcing the same transaction meanwhile is remembered, and the transaction
+        is asked from the next of them when the first doesn't deliver it in time or
+        disconnects. Not thread safe, the protocol handler only uses it from the
+        dispatcher.
+    */
+    class TransactionRequestTracker
+    {
+    public:
+        TransactionRequestTracker(time_t requestTimeout, size_t announcersLimit);
+
+        /*!
+            returns true if the transaction isn't requested yet, so the caller may ask
+            the announcing peer for it. otherwise the peer is remembered as a further
+            announcer
+        */
+        bool onAnnounced(const Crypto::Hash &transactionHash, const boost::uuids::uuid &peer);
+        void onRequested(const Crypto::Hash &transactionHash, const boost::uuids::uuid &peer, time_t now);
+        void onReceived(const Crypto::Hash &transactionHash);
+
+        /*!
+            forgets the peer as an announcer, and lets the transactions asked from it
+            time out right away
+        */
+        void onPeerDisconnected(const boost::uuids::uuid &peer);
+
+        /*!
+            moves every timed out request over to its next announcer and returns the
+            new requests by peer. requests without further announcers are dropped
+        */
+        std::map<boost::uuids::uuid, std::vector<Crypto::Hash>> takeRerequests(time_t now);
+
+        size_t size() const;
+
+    private:
+        struct RequestedTransaction
+        {
+            time_t requestedAt;
+            boost::uuids::uuid requestedFrom;
+            std::deque<boost::uuids::uuid> announcers;
+        };
+
+        time_t m_requestTimeout;
+        size_t m_announcersLimit;
+        std::unordered_map<Crypto::Hash, RequestedTransaction> m_requested;
+    };
+
+} // namespace CryptoNote
@@ -273,6 +273,7 @@ namespace CryptoNote {
 	const size_t   BLOCKS_IDS_SYNCHRONIZING_DEFAULT_COUNT 				    = 10000;  //by default, blocks ids count in synchronizing
 	const uint64_t BLOCKS_SYNCHRONIZING_DEFAULT_COUNT 					    = 128;    //by default, blocks count in blocks downloading
 	const size_t   COMMAND_RPC_GET_BLOCKS_FAST_MAX_COUNT 				    = 1000;
+	const size_t   WALLET_SYNC_BLOCK_CACHE_SIZE 						    = 1000;   //recent main chain blocks kept ready for wallet sync
 
 	const int      P2P_DEFAULT_PORT                              		    =  8196;
 	const int      RPC_DEFAULT_PORT                              		    =  8197;
@@ -285,7 +286,7 @@ namespace CryptoNote {
 	 * P2P Network Configuration Section - This defines our current P2P network version
 	 * and the minimum version for communication between nodes
 	 */
-	const uint8_t  P2P_CURRENT_VERSION 									    = 5; //bump p2p version
+	const uint8_t  P2P_CURRENT_VERSION 									    = 6; //bump p2p version
 	const uint8_t  P2P_MINIMUM_VERSION 									    = 1; //bump min supported version
 	const std::unordered_map<
 		uint8_t,
@@ -305,6 +306,16 @@ namespace CryptoNote {
 	 */
 	const uint8_t  P2P_LITE_BLOCKS_PROPOGATION_VERSION                      = 1;
 
+	/*!
+	 * This defines the minimum P2P version required for compact blocks propogation
+	 */
+	const uint8_t  P2P_COMPACT_BLOCKS_PROPOGATION_VERSION                   = 6;
+
+	/*!
+	 * This defines the minimum P2P version required for announcing transactions by hash
+	 */
+	const uint8_t  P2P_TRANSACTION_INVENTORY_VERSION                        = 6;
+
     /*!
      * This defines the number of versions ahead we must see peers before we start displaying
      * warning messages that we need to upgrade our software.
@@ -312,6 +323,9 @@ namespace CryptoNote {
 	const uint8_t  P2P_UPGRADE_WINDOW 									    = 1;
 
 	const size_t   P2P_CONNECTION_MAX_WRITE_BUFFER_SIZE 				    = 64 * 1024 * 1024; // 64 MB
+	const size_t   P2P_MAX_PENDING_TRANSACTIONS_PER_PEER 				    = 512;           // relayed transactions validated at once for one peer
+	const size_t   P2P_MAX_SYNCHRONIZING_PEERS 						    = 3;             // peers blocks are downloaded from at once, the best scored ones
+	const size_t   P2P_CONNECTION_CANDIDATES 							    = 4;             // peerlist entries sampled per new connection, tried best scored first
 	const uint32_t P2P_DEFAULT_CONNECTIONS_COUNT 						    = 16;
 	const size_t   P2P_DEFAULT_WHITELIST_CONNECTIONS_PERCENT 			    = 70;
 	const uint32_t P2P_DEFAULT_HANDSHAKE_INTERVAL 						    = 60;            // seconds
@@ -29,6 +29,12 @@ namespace LMDB {
      */
     const size_t MAPSIZE_MIN_AVAIL = 64 * Constants::MEGABYTE;
 
+    /*!
+     * min. available room in the db when a bulk write transaction starts,
+     * the map can't grow while it is open
+     */
+    const size_t BULK_WRITE_MIN_AVAIL = 512 * Constants::MEGABYTE;
+
     /*!
      * Shift << n / MEGABYTE =
      * Shift 18446744071562067968   : 17592186042368 MiB.   31
@@ -87,10 +87,15 @@ namespace Logging {
                 body2.insert (insertPos, formatPattern (pattern, category, level, time));
             }
 
-            doLogString (body2);
+            doLogString (level, body2);
         }
     }
 
+    bool CommonLogger::isEnabled(Level level) const
+    {
+        return level <= logLevel;
+    }
+
     void CommonLogger::setPattern(const std::string &pattern)
     {
         this->pattern = pattern;
@@ -111,7 +116,7 @@ namespace Logging {
     {
     }
 
-    void CommonLogger::doLogString(const std::string &message)
+    void CommonLogger::doLogString(Level /*level*/, const std::string &/*message*/)
     {
     }
 
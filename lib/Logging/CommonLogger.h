@@ -18,6 +18,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <set>
 
 #include <Logging/ILogger.h>
@@ -36,6 +37,7 @@ namespace Logging {
                                 Level level,
                                 boost::posix_time::ptime time,
                                 const std::string &body) override;
+        virtual bool isEnabled(Level level) const override;
         virtual void disableCategory(const std::string &category);
         virtual void setMaxLevel(Level level);
 
@@ -43,11 +45,11 @@ namespace Logging {
 
     protected:
         std::set<std::string> disabledCategories;
-        Level logLevel;
+        std::atomic<Level> logLevel;
         std::string pattern;
 
         CommonLogger(Level level);
-        virtual void doLogString(const std::string &message);
+        virtual void doLogString(Level level, const std::string &message);
     };
 
 } // namespace Logging
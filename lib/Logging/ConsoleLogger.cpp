@@ -32,7 +32,7 @@ namespace Logging {
     {
     }
 
-    void ConsoleLogger::doLogString(const std::string &message)
+    void ConsoleLogger::doLogString(Level /*level*/, const std::string &message)
     {
         std::lock_guard<std::mutex> lock (mutex);
         bool readingText = true;
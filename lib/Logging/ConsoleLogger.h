@@ -30,7 +30,7 @@ namespace Logging {
         ConsoleLogger(Level level = DEBUGGING);
 
     protected:
-        virtual void doLogString(const std::string &message) override;
+        virtual void doLogString(Level level, const std::string &message) override;
 
     private:
         std::mutex mutex;
@@ -37,6 +37,11 @@ namespace Logging {
         {
             // do nothing
         }
+
+        virtual bool isEnabled(Level /*level*/) const override
+        {
+            return false;
+        }
     };
 
 } // namespace Logging
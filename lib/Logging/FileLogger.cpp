@@ -25,6 +25,14 @@ namespace Logging {
     {
     }
 
+    FileLogger::~FileLogger()
+    {
+        /*!
+            fileStream goes away before the base, stop writing to it first
+        */
+        stopWriter ();
+    }
+
     void FileLogger::init(const std::string &fileName)
     {
         fileStream.open (fileName, std::ios::app);
@@ -28,6 +28,7 @@ namespace Logging {
     {
     public:
         FileLogger(Level level = DEBUGGING);
+        ~FileLogger();
         void init(const std::string &filename);
 
     private:
@@ -67,6 +67,15 @@ namespace Logging {
 
         const static std::array<std::string, 6> LEVEL_NAMES;
 
+        /*!
+            checked before a message is built, a logger returning false here
+            would drop the message anyway
+        */
+        virtual bool isEnabled(Level /*level*/) const
+        {
+            return true;
+        }
+
         virtual void operator()(const std::string &category,
                                 Level level,
                                 boost::posix_time::ptime time,
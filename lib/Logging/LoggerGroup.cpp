@@ -23,13 +23,31 @@
 namespace Logging {
 
     LoggerGroup::LoggerGroup(Level level)
-        : CommonLogger (level)
+        : CommonLogger (level), enabledLevel (-1)
     {
     }
 
     void LoggerGroup::addLogger(ILogger &logger)
     {
         loggers.push_back (&logger);
+        refreshEnabledLevel ();
+    }
+
+    void LoggerGroup::refreshEnabledLevel()
+    {
+        int highest = -1;
+        for (int level = ALL; level >= FATAL && highest < 0; --level) {
+            const bool enabled = std::any_of (loggers.begin (), loggers.end (), [level](const ILogger *logger)
+            {
+                return logger->isEnabled (static_cast<Level>(level));
+            });
+
+            if (enabled) {
+                highest = level;
+            }
+        }
+
+        enabledLevel.store (highest, std::memory_order_relaxed);
     }
 
     void LoggerGroup::operator()(const std::string &category,
@@ -44,4 +62,10 @@ namespace Logging {
         }
     }
 
+    bool LoggerGroup::isEnabled(Level level) const
+    {
+        return level <= logLevel.load (std::memory_order_relaxed)
+               && static_cast<int>(level) <= enabledLevel.load (std::memory_order_relaxed);
+    }
+
 } // namespace Logging
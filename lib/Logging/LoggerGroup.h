@@ -18,12 +18,17 @@
 
 #pragma once
 
+#include <atomic>
 #include <vector>
 
 #include <Logging/CommonLogger.h>
 
 namespace Logging {
 
+    /*!
+        isEnabled is answered from a snapshot of the highest level any member
+        accepts, taken when a member is added, so it never touches the member list
+    */
     class LoggerGroup: public CommonLogger
     {
     public:
@@ -35,9 +40,15 @@ namespace Logging {
                                 Level level,
                                 boost::posix_time::ptime time,
                                 const std::string &body) override;
+        virtual bool isEnabled(Level level) const override;
 
     protected:
+        void refreshEnabledLevel();
+
         std::vector<ILogger *> loggers;
+
+    private:
+        std::atomic<int> enabledLevel;
     };
 
 } // namespace Logging
@@ -44,6 +44,7 @@ namespace Logging {
         std::unique_lock<std::mutex> lock (reconfigureLock);
         loggers.clear ();
         LoggerGroup::loggers.clear ();
+        refreshEnabledLevel ();
         Level globalLevel;
         if (val.contains ("globalLevel")) {
             auto levelVal = val ("globalLevel");
@@ -16,25 +16,102 @@
 // You should have received a copy of the GNU Lesser General Public License
 // along with Qwertycoin.  If not, see <http://www.gnu.org/licenses/>.
 
+#include <chrono>
+#include <vector>
+
 #include <Logging/LoggerMessage.h>
 
 namespace Logging {
 
+    namespace {
+
+        const size_t MAX_POOLED_BUFFERS = 4;
+        const size_t MAX_POOLED_BUFFER_CAPACITY = 64 * 1024;
+
+        /*!
+            message buffers are reused per thread, a message built while
+            formatting another one just takes the next buffer
+        */
+        std::vector<std::string> &bufferPool()
+        {
+            thread_local std::vector<std::string> pool;
+            return pool;
+        }
+
+        std::string takeBuffer(const std::string &color)
+        {
+            auto &pool = bufferPool ();
+            if (pool.empty ()) {
+                return color;
+            }
+
+            std::string buffer = std::move (pool.back ());
+            pool.pop_back ();
+            buffer.assign (color);
+
+            return buffer;
+        }
+
+        void returnBuffer(std::string &&buffer)
+        {
+            auto &pool = bufferPool ();
+            if (pool.size () < MAX_POOLED_BUFFERS && buffer.capacity () <= MAX_POOLED_BUFFER_CAPACITY) {
+                buffer.clear ();
+                pool.push_back (std::move (buffer));
+            }
+        }
+
+        /*!
+            local_time () converts through the time zone on every call, so the
+            last value is advanced with the steady clock and refreshed once a second
+        */
+        boost::posix_time::ptime coarseLocalTime()
+        {
+            thread_local std::chrono::steady_clock::time_point refreshedAt;
+            thread_local boost::posix_time::ptime refreshedTime;
+
+            const auto now = std::chrono::steady_clock::now ();
+            if (refreshedTime.is_not_a_date_time () || now - refreshedAt >= std::chrono::seconds (1)) {
+                refreshedAt = now;
+                refreshedTime = boost::posix_time::microsec_clock::local_time ();
+
+                return refreshedTime;
+            }
+
+            const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(now - refreshedAt);
+
+            return refreshedTime + boost::posix_time::microseconds (elapsed.count ());
+        }
+
+    } // namespace
+
     LoggerMessage::LoggerMessage(std::shared_ptr<ILogger> logger,
                                  const std::string &category,
                                  Level level,
                                  const std::string &color)
         : std::ostream (this), std::streambuf (), logger (logger), category (category), logLevel (level),
-          message (color), timestamp (boost::posix_time::microsec_clock::local_time ()), gotText (false)
+          message (takeBuffer (color)), timestamp (coarseLocalTime ()), gotText (false)
+    {
+    }
+
+    LoggerMessage::LoggerMessage(Level level)
+        : std::ostream (this), std::streambuf (), logLevel (level), gotText (false)
     {
+        setstate (std::ios_base::badbit);
     }
 
     LoggerMessage::~LoggerMessage()
     {
+        if (!logger) {
+            return;
+        }
+
         if (gotText) {
             (*this)
                 << std::endl;
         }
+
+        returnBuffer (std::move (message));
     }
 
 #ifndef __linux__
@@ -98,14 +175,22 @@ namespace Logging {
 
     int LoggerMessage::sync()
     {
+        if (!logger) {
+            return 0;
+        }
+
         (*logger) (category, logLevel, timestamp, message);
         gotText = false;
-        message = DEFAULT;
+        message.assign (DEFAULT);
         return 0;
     }
 
     std::streamsize LoggerMessage::xsputn(const char *s, std::streamsize n)
     {
+        if (!logger) {
+            return n;
+        }
+
         gotText = true;
         message.append (s, n);
         return n;
@@ -113,6 +198,10 @@ namespace Logging {
 
     int LoggerMessage::overflow(int c)
     {
+        if (!logger) {
+            return 0;
+        }
+
         gotText = true;
         message += static_cast<char>(c);
         return 0;
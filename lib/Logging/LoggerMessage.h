@@ -31,6 +31,11 @@ namespace Logging {
                       const std::string &category,
                       Level level,
                       const std::string &color);
+        /*!
+            a disabled message, the stream starts out failed so the << operators
+            skip formatting and nothing reaches a logger
+        */
+        explicit LoggerMessage(Level level);
         ~LoggerMessage();
         LoggerMessage(const LoggerMessage &) = delete;
         LoggerMessage &operator=(const LoggerMessage &) = delete;
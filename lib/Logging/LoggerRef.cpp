@@ -27,9 +27,18 @@ namespace Logging {
 
     LoggerMessage LoggerRef::operator()(Level level, const std::string &color) const
     {
+        if (!logger->isEnabled (level)) {
+            return LoggerMessage (level);
+        }
+
         return LoggerMessage (logger, category, level, color);
     }
 
+    bool LoggerRef::enabled(Level level) const
+    {
+        return logger->isEnabled (level);
+    }
+
     std::shared_ptr<ILogger> LoggerRef::getLogger() const
     {
         return logger;
@@ -28,6 +28,7 @@ namespace Logging {
     public:
         LoggerRef(std::shared_ptr<ILogger> logger, const std::string &category);
         LoggerMessage operator()(Level level = INFO, const std::string &color = DEFAULT) const;
+        bool enabled(Level level) const;
         std::shared_ptr<ILogger> getLogger() const;
 
     private:
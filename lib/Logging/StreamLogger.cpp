@@ -16,44 +16,210 @@
 // You should have received a copy of the GNU Lesser General Public License
 // along with Qwertycoin.  If not, see <http://www.gnu.org/licenses/>.
 
+#include <chrono>
 #include <iostream>
 #include <sstream>
 
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
 #include <Logging/StreamLogger.h>
 
 namespace Logging {
 
+    namespace {
+
+        const size_t QUEUE_CAPACITY = 8192;
+        const std::chrono::milliseconds WRITER_POLL_INTERVAL (50);
+        const std::chrono::seconds FLUSH_INTERVAL (1);
+
+        std::string stripColors(const std::string &message)
+        {
+            std::string text;
+            text.reserve (message.size ());
+
+            bool readingText = true;
+            size_t pos = 0;
+            for (;;) {
+                const size_t delimPos = message.find (ILogger::COLOR_DELIMETER, pos);
+                if (readingText) {
+                    text.append (message, pos, delimPos == std::string::npos ? std::string::npos : delimPos - pos);
+                }
+
+                if (delimPos == std::string::npos) {
+                    break;
+                }
+
+                readingText = !readingText;
+                pos = delimPos + 1;
+            }
+
+            return text;
+        }
+
+        int currentProcessId()
+        {
+#ifdef _WIN32
+            return _getpid ();
+#else
+            return static_cast<int>(getpid ());
+#endif
+        }
+
+    } // namespace
+
     StreamLogger::StreamLogger(Level level)
-        : CommonLogger (level), stream (nullptr)
+        : CommonLogger (level), stream (nullptr), queue (QUEUE_CAPACITY), droppedMessages (0), writerProcessId (0)
     {
     }
 
     StreamLogger::StreamLogger(std::ostream &stream, Level level)
-        : CommonLogger (level), stream (&stream)
+        : CommonLogger (level), stream (&stream), queue (QUEUE_CAPACITY), droppedMessages (0), writerProcessId (0)
     {
     }
 
+    StreamLogger::~StreamLogger()
+    {
+        stopWriter ();
+
+        /*!
+            a writer inherited over a fork still runs in the parent, destroying
+            its thread object here would terminate the child
+        */
+        if (writerProcessId.load (std::memory_order_acquire) != currentProcessId ()) {
+            static_cast<void>(writer.release ());
+        }
+    }
+
     void StreamLogger::attachToStream(std::ostream &stream)
     {
+        Writer &writer = currentWriter ();
+
+        std::lock_guard<std::mutex> lock (writer.mutex);
         this->stream = &stream;
     }
 
-    void StreamLogger::doLogString(const std::string &message)
+    void StreamLogger::doLogString(Level level, const std::string &message)
     {
-        if (stream != nullptr && stream->good ()) {
-            std::lock_guard<std::mutex> lock (mutex);
-            bool readingText = true;
-            for (size_t charPos = 0; charPos < message.size (); ++charPos) {
-                if (message[charPos] == ILogger::COLOR_DELIMETER) {
-                    readingText = !readingText;
-                } else if (readingText) {
-                    *stream
-                        << message[charPos];
+        Writer &writer = currentWriter ();
+
+        Entry entry;
+        entry.level = level;
+        entry.text = stripColors (message);
+
+        if (!queue.tryPush (std::move (entry))) {
+            droppedMessages.fetch_add (1, std::memory_order_relaxed);
+            return;
+        }
+
+        if (level <= ERROR || queue.size () >= queue.capacity () / 2) {
+            writer.wakeUp.notify_one ();
+        }
+    }
+
+    StreamLogger::Writer &StreamLogger::currentWriter()
+    {
+        const int processId = currentProcessId ();
+        if (writerProcessId.load (std::memory_order_acquire) == processId) {
+            return *writer;
+        }
+
+        std::lock_guard<std::mutex> lock (startMutex);
+        if (writerProcessId.load (std::memory_order_relaxed) != processId) {
+            /*!
+                a writer from before a fork belongs to the parent, its thread
+                can't be joined here and is left alone together with its locks.
+                what it hadn't written yet is the parent's to write
+            */
+            if (writer) {
+                static_cast<void>(writer.release ());
+
+                Entry entry;
+                while (queue.tryPop (entry)) {
                 }
+                droppedMessages = 0;
+            }
+
+            writer.reset (new Writer);
+            writer->thread = std::thread (&StreamLogger::writerLoop, this, std::ref (*writer));
+            writerProcessId.store (processId, std::memory_order_release);
+        }
+
+        return *writer;
+    }
+
+    void StreamLogger::stopWriter()
+    {
+        std::lock_guard<std::mutex> lock (startMutex);
+        if (writerProcessId.load (std::memory_order_acquire) != currentProcessId ()
+            || !writer->thread.joinable ()) {
+            return;
+        }
+
+        writer->stopping = true;
+        writer->wakeUp.notify_one ();
+        writer->thread.join ();
+    }
+
+    void StreamLogger::writerLoop(Writer &writer)
+    {
+        auto lastFlush = std::chrono::steady_clock::now ();
+
+        while (!writer.stopping) {
+            {
+                std::unique_lock<std::mutex> lock (writer.wakeMutex);
+                writer.wakeUp.wait_for (lock, WRITER_POLL_INTERVAL);
+            }
+
+            const bool urgent = writeQueued (writer);
+            const auto now = std::chrono::steady_clock::now ();
+            if (urgent || now - lastFlush >= FLUSH_INTERVAL) {
+                flushStream (writer);
+                lastFlush = now;
+            }
+        }
+
+        writeQueued (writer);
+        flushStream (writer);
+    }
+
+    bool StreamLogger::writeQueued(Writer &writer)
+    {
+        std::lock_guard<std::mutex> lock (writer.mutex);
+        const bool writable = stream != nullptr && stream->good ();
+        bool urgent = false;
+
+        /*!
+            bounded, so a flood of messages can't hold off the flush
+        */
+        Entry entry;
+        for (size_t i = 0; i < queue.capacity () && queue.tryPop (entry); ++i) {
+            if (writable) {
+                stream->write (entry.text.data (), entry.text.size ());
             }
 
+            urgent = urgent || entry.level <= ERROR;
+        }
+
+        const uint64_t dropped = droppedMessages.exchange (0, std::memory_order_relaxed);
+        if (dropped != 0 && writable) {
             *stream
-                << std::flush;
+                << dropped
+                << " log messages dropped, the log writer could not keep up"
+                << '\n';
+        }
+
+        return urgent;
+    }
+
+    void StreamLogger::flushStream(Writer &writer)
+    {
+        std::lock_guard<std::mutex> lock (writer.mutex);
+        if (stream != nullptr && stream->good ()) {
+            stream->flush ();
         }
     }
 
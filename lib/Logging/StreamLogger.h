@@ -18,27 +18,77 @@
 
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
+#include <memory>
 #include <mutex>
+#include <thread>
+
+#include <Common/MpscRingBuffer.h>
 
 #include <Logging/CommonLogger.h>
 
 namespace Logging {
 
+    /*!
+        messages are queued without locking and written out in batches by a
+        writer thread, which flushes once a second or right away after a
+        message of ERROR or worse, and is woken early when the queue fills up.
+        when the queue is full messages are dropped
+        and the writer reports how many.
+        the writer is started by the first message or attach in a process, so
+        a logger created before a fork gets its own writer in the child
+    */
     class StreamLogger: public CommonLogger
     {
     public:
         StreamLogger(Level level = DEBUGGING);
         StreamLogger(std::ostream &stream, Level level = DEBUGGING);
+        virtual ~StreamLogger();
         void attachToStream(std::ostream &stream);
 
     protected:
-        virtual void doLogString(const std::string &message) override;
+        virtual void doLogString(Level level, const std::string &message) override;
+
+        /*!
+            writes out what is queued and stops the writer thread, subclasses
+            owning the stream call this in their destructor
+        */
+        void stopWriter();
 
     protected:
         std::ostream *stream;
 
     private:
-        std::mutex mutex;
+        struct Entry
+        {
+            Level level = INFO;
+            std::string text;
+        };
+
+        /*!
+            everything the writer thread locks, replaced as a whole in a forked
+            child where the parent's thread doesn't exist and its locks may be held
+        */
+        struct Writer
+        {
+            std::mutex mutex;
+            std::mutex wakeMutex;
+            std::condition_variable wakeUp;
+            std::atomic<bool> stopping {false};
+            std::thread thread;
+        };
+
+        Writer &currentWriter();
+        void writerLoop(Writer &writer);
+        bool writeQueued(Writer &writer);
+        void flushStream(Writer &writer);
+
+        MpscRingBuffer<Entry> queue;
+        std::atomic<uint64_t> droppedMessages;
+        std::mutex startMutex;
+        std::atomic<int> writerProcessId;
+        std::unique_ptr<Writer> writer;
     };
 
 } // namespace Logging
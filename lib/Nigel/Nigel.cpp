@@ -16,10 +16,13 @@
 // You should have received a copy of the GNU Lesser General Public License
 // along with Qwertycoin.  If not, see <http://www.gnu.org/licenses/>.
 
+#include <map>
+
 #include <Common/CryptoNoteTools.h>
 
 #include <Utilities/ValidateParameters.h>
 
+#include <Global/Constants.h>
 #include <Global/CryptoNoteConfig.h>
 
 #include <Logging/Logger.h>
@@ -30,6 +33,24 @@
 
 using json = nlohmann::json;
 
+/*!
+ * How long the daemon may hold a /get_status_changes request before we refresh
+ * anyway. Matches the old polling interval, and bounds how long stop() waits
+ */
+const std::chrono::seconds STATUS_CHANGES_TIMEOUT (10);
+
+/*!
+ * How many decoy sets we keep ready per amount, so back to back sends don't
+ * have to wait on the daemon
+ */
+const size_t DECOY_CACHE_SETS_PER_AMOUNT = 4;
+
+/*!
+ * Cached decoys older than this many blocks are dropped, so the rings keep
+ * picking from the recent outputs the daemon would pick from
+ */
+const uint64_t DECOY_CACHE_MAX_AGE = 5;
+
 /*!
  * Inline helper methods
  */
@@ -92,6 +113,12 @@ void Nigel::swapNode(const std::string daemonHost, const uint16_t daemonPort, co
     m_nodeFeeAddress = "";
     m_nodeFeeAmount = 0;
 
+    {
+        std::scoped_lock lock (m_decoyMutex);
+        m_decoyCache.clear ();
+        m_decoyDemand.clear ();
+    }
+
     m_daemonHost = daemonHost;
     m_daemonPort = daemonPort;
     m_daemonSSL = daemonSSL;
@@ -304,11 +331,85 @@ bool Nigel::getFeeInfo()
 
 void Nigel::backgroundRefresh()
 {
+    /*!
+     * The long poll gets its own client, as it holds the request open for
+     * longer than our usual timeout
+     */
+    const auto statusClient = getClient (
+        m_daemonHost, m_daemonPort, m_daemonSSL, m_timeout + STATUS_CHANGES_TIMEOUT
+    );
+
+    Crypto::Hash topBlockHash = Constants::NULL_HASH;
+    uint64_t poolVersion = 0;
+    bool statusChangesSupported = true;
+
     while (!m_shouldStop) {
         getDaemonInfo ();
 
-        Utilities::sleepUnlessStopping (std::chrono::seconds (10), m_shouldStop);
+        refillDecoyCache ();
+
+        if (!waitForStatusChange (*statusClient, topBlockHash, poolVersion, statusChangesSupported)) {
+            Utilities::sleepUnlessStopping (std::chrono::seconds (10), m_shouldStop);
+        }
+    }
+}
+
+bool Nigel::waitForStatusChange(
+    httplib::Client &statusClient,
+    Crypto::Hash &topBlockHash,
+    uint64_t &poolVersion,
+    bool &statusChangesSupported) const
+{
+    if (!statusChangesSupported) {
+        return false;
+    }
+
+    json j = {
+        {"topBlockHash", topBlockHash},
+        {"poolVersion", poolVersion},
+        {"timeout", std::chrono::milliseconds (STATUS_CHANGES_TIMEOUT).count ()}
+    };
+
+    auto res = statusClient.Post (
+        "/get_status_changes", j.dump (), "application/json"
+    );
+
+    /*!
+     * Older daemons and the blockchain cache don't have this, stick to polling
+     */
+    if (res && res->status == 404) {
+        Logger::logger.log (
+            "Daemon doesn't support /get_status_changes, falling back to polling",
+            Logger::DEBUG,
+            {Logger::DAEMON}
+        );
+
+        statusChangesSupported = false;
+        return false;
     }
+
+    if (res && res->status == 200) {
+        try {
+            json j = json::parse (res->body);
+
+            if (j.at ("status").get<std::string> () != "OK") {
+                return false;
+            }
+
+            topBlockHash = j.at ("topBlockHash").get<Crypto::Hash> ();
+            poolVersion = j.at ("poolVersion").get<uint64_t> ();
+
+            return true;
+        } catch (const json::exception &e) {
+            Logger::logger.log (
+                std::string ("Failed to wait for daemon status changes: ") + e.what (),
+                Logger::INFO,
+                {Logger::DAEMON}
+            );
+        }
+    }
+
+    return false;
 }
 
 bool Nigel::isOnline() const
@@ -385,6 +486,160 @@ bool Nigel::getTransactionsStatus(
 std::tuple<bool, std::vector<CryptoNote::RandomOuts>> Nigel::getRandomOutsByAmounts(
     const std::vector<uint64_t> amounts,
     const uint64_t requestedOuts) const
+{
+    std::vector<std::optional<CryptoNote::RandomOuts>> result (amounts.size ());
+
+    std::vector<uint64_t> missingAmounts;
+
+    {
+        std::scoped_lock lock (m_decoyMutex);
+
+        const uint64_t oldestUsableHeight = m_localDaemonBlockCount > DECOY_CACHE_MAX_AGE
+                                            ? m_localDaemonBlockCount - DECOY_CACHE_MAX_AGE
+                                            : 0;
+
+        for (size_t i = 0; i < amounts.size (); i++) {
+            const uint64_t amount = amounts[i];
+
+            if (std::find (Constants::PRETTY_AMOUNTS.begin (), Constants::PRETTY_AMOUNTS.end (), amount)
+                != Constants::PRETTY_AMOUNTS.end ()) {
+                m_decoyDemand[amount] = requestedOuts;
+            }
+
+            const auto cached = m_decoyCache.find (amount);
+
+            /*!
+             * Sets are handed out oldest first, anything which has gone stale or
+             * was fetched for another ring size is thrown away. The daemon returns
+             * its picks sorted by global index, so cutting a bigger set down would
+             * keep only the oldest outputs and skew the ring
+             */
+            while (cached != m_decoyCache.end () && !cached->second.empty ()) {
+                CachedDecoys decoys = std::move (cached->second.front ());
+                cached->second.pop_front ();
+
+                if (decoys.height >= oldestUsableHeight && decoys.outs.outs.size () == requestedOuts) {
+                    result[i] = std::move (decoys.outs);
+                    break;
+                }
+            }
+
+            if (!result[i]) {
+                missingAmounts.push_back (amount);
+            }
+        }
+    }
+
+    if (!missingAmounts.empty ()) {
+        Logger::logger.log (
+            "Decoy cache missed for " + std::to_string (missingAmounts.size ()) + " amount(s), "
+            "fetching from the daemon",
+            Logger::DEBUG,
+            {Logger::TRANSACTIONS, Logger::DAEMON}
+        );
+
+        const auto[success, fetched] = fetchRandomOutsByAmounts (missingAmounts, requestedOuts);
+
+        if (!success || fetched.size () != missingAmounts.size ()) {
+            return {success, fetched};
+        }
+
+        /*!
+         * The daemon answers in request order, slot them back in where the
+         * cache had nothing
+         */
+        size_t j = 0;
+
+        for (auto &item : result) {
+            if (!item) {
+                item = fetched[j++];
+            }
+        }
+    }
+
+    std::vector<CryptoNote::RandomOuts> outs;
+
+    outs.reserve (result.size ());
+
+    for (auto &item : result) {
+        outs.push_back (std::move (*item));
+    }
+
+    return {true, outs};
+}
+
+void Nigel::refillDecoyCache()
+{
+    /*!
+     * Amounts to top up, grouped by how many outputs they were last asked for,
+     * so every set is fetched at exactly the size it will be handed out at
+     */
+    std::map<uint64_t, std::vector<uint64_t>> amountsByOuts;
+
+    {
+        std::scoped_lock lock (m_decoyMutex);
+
+        const uint64_t oldestUsableHeight = m_localDaemonBlockCount > DECOY_CACHE_MAX_AGE
+                                            ? m_localDaemonBlockCount - DECOY_CACHE_MAX_AGE
+                                            : 0;
+
+        for (const auto[amount, outs] : m_decoyDemand) {
+            auto &cached = m_decoyCache[amount];
+
+            cached.erase (
+                std::remove_if (cached.begin (), cached.end (), [oldestUsableHeight, outs = outs](const auto &decoys)
+                {
+                    return decoys.height < oldestUsableHeight || decoys.outs.outs.size () != outs;
+                }),
+                cached.end ()
+            );
+
+            /*!
+             * Ask for the same amount several times to get independent sets,
+             * rather than one big set we'd have to split up
+             */
+            for (size_t i = cached.size (); i < DECOY_CACHE_SETS_PER_AMOUNT; i++) {
+                amountsByOuts[outs].push_back (amount);
+            }
+        }
+    }
+
+    const uint64_t height = m_localDaemonBlockCount;
+
+    for (const auto &[requestedOuts, amounts] : amountsByOuts) {
+        const auto[success, fetched] = fetchRandomOutsByAmounts (amounts, requestedOuts);
+
+        if (!success) {
+            return;
+        }
+
+        std::scoped_lock lock (m_decoyMutex);
+
+        for (const auto &outs : fetched) {
+            /*!
+             * Only keep sets for amounts still asked for at this size, the
+             * demand may have changed while we were waiting on the daemon
+             */
+            const auto demand = m_decoyDemand.find (outs.amount);
+
+            if (demand == m_decoyDemand.end ()
+                || demand->second != requestedOuts
+                || outs.outs.size () != requestedOuts) {
+                continue;
+            }
+
+            auto &cached = m_decoyCache[outs.amount];
+
+            if (cached.size () < DECOY_CACHE_SETS_PER_AMOUNT) {
+                cached.push_back ({height, outs});
+            }
+        }
+    }
+}
+
+std::tuple<bool, std::vector<CryptoNote::RandomOuts>> Nigel::fetchRandomOutsByAmounts(
+    const std::vector<uint64_t> amounts,
+    const uint64_t requestedOuts) const
 {
     json j = {
         {"amounts", amounts},
@@ -19,8 +19,11 @@
 #pragma once
 
 #include <atomic>
+#include <deque>
+#include <mutex>
 #include <string>
 #include <thread>
+#include <unordered_map>
 #include <unordered_set>
 
 #include <httplib.h>
@@ -114,6 +117,29 @@ private:
     bool getDaemonInfo();
     bool getFeeInfo();
 
+    /*!
+     * Long polls /get_status_changes, returns false if we should fall back
+     * to sleeping between refreshes
+     */
+    bool waitForStatusChange(
+        httplib::Client &statusClient,
+        Crypto::Hash &topBlockHash,
+        uint64_t &poolVersion,
+        bool &statusChangesSupported) const;
+
+    /*!
+     * The uncached version of getRandomOutsByAmounts
+     */
+    std::tuple<bool, std::vector<CryptoNote::RandomOuts>> fetchRandomOutsByAmounts(
+        const std::vector<uint64_t> amounts,
+        const uint64_t requestedOuts) const;
+
+    /*!
+     * Tops up m_decoyCache for every amount we have sent from before, and
+     * drops the sets which are too old or were fetched for another ring size
+     */
+    void refillDecoyCache();
+
     /*!
      * Private member variables
      */
@@ -175,6 +201,34 @@ private:
      */
     uint64_t m_nodeFeeAmount = 0;
 
+    /*!
+     * A set of decoys as returned by the daemon for a single amount, and the
+     * daemon height when we fetched it
+     */
+    struct CachedDecoys
+    {
+        uint64_t height;
+        CryptoNote::RandomOuts outs;
+    };
+
+    /*!
+     * Guards m_decoyCache and m_decoyDemand, used by both the sending thread
+     * and the background thread
+     */
+    mutable std::mutex m_decoyMutex;
+
+    /*!
+     * Decoy sets fetched ahead of time, by amount. Each set is handed out
+     * once, and never reused for another transaction
+     */
+    mutable std::unordered_map<uint64_t, std::deque<CachedDecoys>> m_decoyCache;
+
+    /*!
+     * The pretty amounts we have been asked for decoys for, and how many outputs
+     * were requested last time. Only these get prefetched
+     */
+    mutable std::unordered_map<uint64_t, uint64_t> m_decoyDemand;
+
     /*!
      * The timeout on requests
      */
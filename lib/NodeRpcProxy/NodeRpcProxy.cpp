@@ -80,6 +80,7 @@ namespace CryptoNote {
         : m_logger (logger, "NodeRpcProxy"),
           m_rpcTimeout (10000),
           m_pullInterval (5000),
+          m_statusWaitTimeout (10000),
           m_nodeHost (nodeHost),
           m_nodePort (nodePort),
           m_initTimeout (initTimeout),
@@ -97,6 +98,7 @@ namespace CryptoNote {
         : m_logger (std::make_shared<Logging::DummyLogger> (), "NodeRpcProxy"),
           m_rpcTimeout (10000),
           m_pullInterval (5000),
+          m_statusWaitTimeout (10000),
           m_nodeHost (nodeHost),
           m_nodePort (nodePort),
           m_initTimeout (initTimeout),
@@ -133,6 +135,8 @@ namespace CryptoNote {
         lastLocalBlockHeaderInfo.difficulty = 0;
         lastLocalBlockHeaderInfo.reward = 0;
         m_knownTxs.clear ();
+        m_statusChangesSupported = true;
+        m_poolVersion = 0;
     }
 
     void NodeRpcProxy::init(const INode::Callback &callback)
@@ -210,9 +214,10 @@ namespace CryptoNote {
             contextGroup.spawn ([this]()
                                 {
                                     Timer pullTimer (*m_dispatcher);
+                                    HttpClient statusClient (*m_dispatcher, m_nodeHost, m_nodePort);
                                     while (!m_stop) {
                                         updateNodeStatus ();
-                                        if (!m_stop) {
+                                        if (!m_stop && !waitForStatusChange (statusClient)) {
                                             pullTimer.sleep (std::chrono::milliseconds (m_pullInterval));
                                         }
                                     }
@@ -243,6 +248,61 @@ namespace CryptoNote {
         }
     }
 
+    /*!
+     * long polls the daemon on its own connection so other requests aren't held up.
+     * returns false if the caller should fall back to sleeping for m_pullInterval
+     */
+    bool NodeRpcProxy::waitForStatusChange(HttpClient &statusClient)
+    {
+        if (!m_statusChangesSupported) {
+            return false;
+        }
+
+        CryptoNote::COMMAND_RPC_GET_STATUS_CHANGES::request req = AUTO_VAL_INIT(req);
+        CryptoNote::COMMAND_RPC_GET_STATUS_CHANGES::response rsp = AUTO_VAL_INIT(rsp);
+
+        std::unique_lock <std::mutex> lock (m_mutex);
+        req.topBlockHash = lastLocalBlockHeaderInfo.hash;
+        lock.unlock ();
+        req.poolVersion = m_poolVersion;
+        req.timeout = m_statusWaitTimeout;
+
+        try {
+            HttpRequest httpReq;
+            HttpResponse httpRes;
+
+            httpReq.addHeader ("Content-Type", "application/json");
+            httpReq.setUrl ("/get_status_changes");
+            httpReq.setBody (storeToJson (req));
+
+            statusClient.request (httpReq, httpRes);
+
+            if (httpRes.getStatus () == HttpResponse::STATUS_404) {
+                m_logger (DEBUGGING)
+                    << "Daemon doesn't support /get_status_changes, polling every "
+                    << m_pullInterval
+                    << " ms";
+                m_statusChangesSupported = false;
+                return false;
+            }
+
+            /*!
+             * the daemon refuses while it is synchronizing, poll until it is done
+             */
+            if (httpRes.getStatus () != HttpResponse::STATUS_200
+                || !loadFromJson (rsp, httpRes.getBody ())
+                || interpretResponseStatus (rsp.status)) {
+                return false;
+            }
+        } catch (const std::exception &) {
+            return false;
+        }
+
+        m_poolVersion = rsp.poolVersion;
+
+        return true;
+    }
+
     bool NodeRpcProxy::updatePoolStatus()
     {
         std::vector <Crypto::Hash> knownTxs = getKnownTxsVector ();
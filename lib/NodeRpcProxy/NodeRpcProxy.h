@@ -159,6 +159,7 @@ namespace CryptoNote {
         std::vector<Crypto::Hash> getKnownTxsVector() const;
         void pullNodeStatusAndScheduleTheNext();
         void updateNodeStatus();
+        bool waitForStatusChange(HttpClient &statusClient);
         void updateBlockchainStatus();
         bool updatePoolStatus();
         void updatePeerCount(size_t peerCount);
@@ -245,6 +246,7 @@ namespace CryptoNote {
         System::Event *m_httpEvent = nullptr;
 
         uint64_t m_pullInterval;
+        uint64_t m_statusWaitTimeout;
 
         /*!
          * Internal state
@@ -260,6 +262,12 @@ namespace CryptoNote {
          */
         std::unordered_set<Crypto::Hash> m_knownTxs;
 
+        /*!
+         * long poll state, cleared when the daemon doesn't know /get_status_changes
+         */
+        bool m_statusChangesSupported;
+        uint64_t m_poolVersion;
+
         bool m_connected;
         std::string m_fee_address;
         uint32_t m_fee_amount = 0;
@@ -18,6 +18,7 @@
 
 #pragma once
 
+#include <chrono>
 #include <deque>
 #include <list>
 #include <optional>
@@ -30,7 +31,9 @@
 
 #include <Crypto/Hash.h>
 
+#include <P2p/PeerStats.h>
 #include <P2p/PendingLiteBlock.h>
+#include <P2p/RollingInventoryFilter.h>
 
 namespace CryptoNote {
 
@@ -40,6 +43,7 @@ namespace CryptoNote {
         boost::uuids::uuid m_connection_id;
         uint32_t m_remote_ip = 0;
         uint32_t m_remote_port = 0;
+        uint32_t m_listen_port = 0; // port an incoming peer announced, 0 if hidden
         bool m_is_income = false;
         time_t m_started = 0;
 
@@ -61,6 +65,10 @@ namespace CryptoNote {
         std::unordered_set<Crypto::Hash> m_requested_objects;
         uint32_t m_remote_blockchain_height = 0;
         uint32_t m_last_response_height = 0;
+        uint64_t m_last_new_block_time = 0;
+        RollingInventoryFilter m_known_transactions;
+        PeerStats m_stats;
+        std::chrono::steady_clock::time_point m_objects_requested_at;
     };
 
     inline std::string getProtocolStateString(CryptoNoteConnectionContext::state s)
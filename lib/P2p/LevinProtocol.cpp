@@ -32,6 +32,13 @@ namespace {
     const uint32_t LEVIN_DEFAULT_MAX_PACKET_SIZE = 100000000;      //100MB by default
     const uint32_t LEVIN_PROTOCOL_VER_1 = 1;
 
+    /*!
+     * bodies up to this size are copied behind the header and written in one
+     * operation, larger ones (block responses while serving sync) are written
+     * in place right after the header instead of being copied once more
+     */
+    const size_t LEVIN_COALESCE_MAX_BODY_SIZE = 64 * 1024;
+
 #pragma pack(push)
 #pragma pack(1)
     struct BucketHead2
@@ -68,17 +75,7 @@ void LevinProtocol::sendMessage(uint32_t command, const BinaryArray &out, bool n
     head.m_protocol_version = LEVIN_PROTOCOL_VER_1;
     head.m_flags = LEVIN_PACKET_REQUEST;
 
-    /*!
-     * write header and body in one operation
-     */
-    BinaryArray writeBuffer;
-    writeBuffer.reserve (sizeof (head) + out.size ());
-
-    Common::VectorOutputStream stream (writeBuffer);
-    stream.writeSome (&head, sizeof (head));
-    stream.writeSome (out.data (), out.size ());
-
-    writeStrict (writeBuffer.data (), writeBuffer.size ());
+    writeMessage (&head, sizeof (head), out);
 }
 
 bool LevinProtocol::readCommand(Command &cmd)
@@ -125,11 +122,25 @@ void LevinProtocol::sendReply(uint32_t command, const BinaryArray &out, int32_t
     head.m_flags = LEVIN_PACKET_RESPONSE;
     head.m_return_code = returnCode;
 
+    writeMessage (&head, sizeof (head), out);
+}
+
+void LevinProtocol::writeMessage(const void *head, size_t headSize, const BinaryArray &out)
+{
+    if (out.size () > LEVIN_COALESCE_MAX_BODY_SIZE) {
+        writeStrict (static_cast<const uint8_t *>(head), headSize);
+        writeStrict (out.data (), out.size ());
+        return;
+    }
+
+    /*!
+     * write header and body in one operation
+     */
     BinaryArray writeBuffer;
-    writeBuffer.reserve (sizeof (head) + out.size ());
+    writeBuffer.reserve (headSize + out.size ());
 
     Common::VectorOutputStream stream (writeBuffer);
-    stream.writeSome (&head, sizeof (head));
+    stream.writeSome (head, headSize);
     stream.writeSome (out.data (), out.size ());
 
     writeStrict (writeBuffer.data (), writeBuffer.size ());
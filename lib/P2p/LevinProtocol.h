@@ -117,6 +117,7 @@ namespace CryptoNote {
 
         bool readStrict(uint8_t *ptr, size_t size);
         void writeStrict(const uint8_t *ptr, size_t size);
+        void writeMessage(const void *head, size_t headSize, const BinaryArray &out);
         System::TcpConnection &m_conn;
     };
 
@@ -20,7 +20,10 @@
 // along with Qwertycoin.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <fstream>
+#include <memory>
 
 #include <boost/foreach.hpp>
 #include <boost/uuid/random_generator.hpp>
@@ -30,6 +33,7 @@
 #include <miniupnpc/miniupnpc.h>
 #include <miniupnpc/upnpcommands.h>
 
+#include <Common/Metrics.h>
 #include <Common/StdInputStream.h>
 #include <Common/StdOutputStream.h>
 #include <Common/Util.h>
@@ -159,6 +163,79 @@ namespace CryptoNote {
             return ss.str ();
         }
 
+        struct LevinCommandMetrics
+        {
+            Metrics::Counter &messages;
+            Metrics::Counter &bytes;
+            Metrics::Histogram &duration;
+        };
+
+        LevinCommandMetrics *resolveLevinCommandMetrics(const std::string &command)
+        {
+            auto &registry = Metrics::Registry::instance ();
+
+            return new LevinCommandMetrics {
+                registry.counter ("p2p_levin_messages_total",
+                                  "Levin requests and notifications received from peers",
+                                  "command",
+                                  command),
+                registry.counter ("p2p_levin_received_bytes_total",
+                                  "Payload bytes of the Levin messages received from peers",
+                                  "command",
+                                  command),
+                registry.histogram ("p2p_levin_handle_duration_seconds",
+                                    "Time spent handling a Levin message",
+                                    "command",
+                                    command)
+            };
+        }
+
+        /*!
+            room for the commands of the p2p and the protocol command pools
+        */
+        const uint32_t LEVIN_COMMAND_POOL_SIZE = 64;
+
+        /*!
+            The metrics of a command are looked up in the registry the first time it
+            is handled and kept in a fixed slot after that, so counting a message takes
+            no lock. Commands nobody handled are counted as unknown, so peers can't
+            grow the label set
+        */
+        LevinCommandMetrics &levinCommandMetrics(uint32_t command, bool handled)
+        {
+            static std::array<std::atomic<LevinCommandMetrics *>, 2 * LEVIN_COMMAND_POOL_SIZE + 1> slots {};
+
+            size_t slot = slots.size () - 1;
+            if (handled && command >= P2P_COMMANDS_POOL_BASE && command < P2P_COMMANDS_POOL_BASE + LEVIN_COMMAND_POOL_SIZE) {
+                slot = command - P2P_COMMANDS_POOL_BASE;
+            } else if (handled && command >= BC_COMMANDS_POOL_BASE && command < BC_COMMANDS_POOL_BASE + LEVIN_COMMAND_POOL_SIZE) {
+                slot = LEVIN_COMMAND_POOL_SIZE + command - BC_COMMANDS_POOL_BASE;
+            }
+
+            LevinCommandMetrics *metrics = slots[slot].load (std::memory_order_acquire);
+            if (metrics == nullptr) {
+                std::unique_ptr<LevinCommandMetrics> resolved (
+                    resolveLevinCommandMetrics (slot == slots.size () - 1 ? "unknown" : std::to_string (command)));
+                if (slots[slot].compare_exchange_strong (metrics, resolved.get (), std::memory_order_acq_rel)) {
+                    metrics = resolved.release ();
+                }
+            }
+
+            return *metrics;
+        }
+
+        void recordLevinCommand(uint32_t command,
+                                bool handled,
+                                size_t bytes,
+                                std::chrono::steady_clock::duration duration)
+        {
+            auto &metrics = levinCommandMetrics (command, handled);
+
+            metrics.messages.inc ();
+            metrics.bytes.inc (bytes);
+            metrics.duration.observe (std::chrono::duration_cast<std::chrono::microseconds> (duration));
+        }
+
     } // namespace
 
 
@@ -312,6 +389,8 @@ namespace CryptoNote {
             return 0;
         }
 
+        const auto start = std::chrono::steady_clock::now ();
+
         switch (cmd.command) {
             INVOKE_HANDLER(COMMAND_HANDSHAKE, &NodeServer::handleHandshake)
             INVOKE_HANDLER(COMMAND_TIMED_SYNC, &NodeServer::handleTimedSync)
@@ -327,6 +406,11 @@ namespace CryptoNote {
             }
         }
 
+        recordLevinCommand (cmd.command,
+                            handled,
+                            cmd.buf.size (),
+                            std::chrono::steady_clock::now () - start);
+
         return ret;
     }
 
@@ -399,6 +483,21 @@ namespace CryptoNote {
         }
     }
 
+    PeerStats NodeServer::getPeerStats(const CryptoNoteConnectionContext &context) const
+    {
+        NetworkAddress adr;
+        adr.ip = context.m_remote_ip;
+        adr.port = context.m_is_income ? context.m_listen_port : context.m_remote_port;
+
+        /*!
+         * an incoming peer hiding its port can't be told apart from others on its ip
+         */
+        PeerStats stats = adr.port != 0 ? m_peerlist.getPeerStats (adr) : PeerStats ();
+        stats.merge (context.m_stats);
+
+        return stats;
+    }
+
     void NodeServer::externalRelayNotifyToAll(int command,
                                               const BinaryArray &data_buff,
                                               const boost::uuids::uuid *excludeConnection)
@@ -683,6 +782,7 @@ namespace CryptoNote {
         getLocalNodeData (arg.node_data);
         m_payload_handler.getPayloadSyncData (arg.payload_data);
 
+        const auto handshakeStart = std::chrono::steady_clock::now ();
         if (!proto.invoke (COMMAND_HANDSHAKE::ID, arg, rsp)) {
             logger (Logging::DEBUGGING)
                 << context
@@ -691,6 +791,8 @@ namespace CryptoNote {
             return false;
         }
 
+        context.m_stats.addRtt (std::chrono::duration_cast<std::chrono::milliseconds> (
+            std::chrono::steady_clock::now () - handshakeStart).count ());
         context.version = rsp.node_data.version;
 
         if (rsp.node_data.network_id != m_network_id) {
@@ -912,6 +1014,7 @@ namespace CryptoNote {
             } catch (System::InterruptedException &) {
                 logger (DEBUGGING)
                     << "Connection timed out";
+                m_peerlist.setPeerFailed (na);
                 return false;
             }
 
@@ -947,11 +1050,13 @@ namespace CryptoNote {
                     logger (DEBUGGING)
                         << "Failed to HANDSHAKE with peer "
                         << na;
+                    m_peerlist.setPeerFailed (na);
                     return false;
                 }
             } catch (System::InterruptedException &) {
                 logger (DEBUGGING)
                     << "Handshake timed out";
+                m_peerlist.setPeerFailed (na);
                 return false;
             }
 
@@ -992,6 +1097,7 @@ namespace CryptoNote {
                 << na
                 << " failed: "
                 << e.what ();
+            m_peerlist.setPeerFailed (na);
         }
 
         return false;
@@ -1008,10 +1114,19 @@ namespace CryptoNote {
         size_t max_random_index = std::min<uint64_t> (local_peers_count - 1, 20);
 
         std::set <size_t> tried_peers;
+        std::vector <PeerlistEntry> candidates;
 
+        /*!
+         * sample a few peers the usual random way, then try the best scored of
+         * them first, so measured fast and reliable peers are preferred without
+         * the selection becoming predictable
+         */
         size_t try_count = 0;
         size_t rand_count = 0;
-        while (rand_count < (max_random_index + 1) * 3 && try_count < 10 && !m_stop) {
+        while (rand_count < (max_random_index + 1) * 3
+               && try_count < 10
+               && candidates.size () < P2P_CONNECTION_CANDIDATES
+               && !m_stop) {
             ++rand_count;
             size_t random_index = getRandomIndexWithFixedProbability (max_random_index);
             if (!(random_index < local_peers_count)) {
@@ -1043,6 +1158,30 @@ namespace CryptoNote {
                 continue;
             }
 
+            candidates.push_back (pe);
+        }
+
+        std::vector <std::pair<int64_t, PeerlistEntry>> scoredCandidates;
+        scoredCandidates.reserve (candidates.size ());
+        for (const auto &pe : candidates) {
+            scoredCandidates.emplace_back (m_peerlist.getPeerStats (pe.adr).score (), pe);
+        }
+
+        std::stable_sort (scoredCandidates.begin (),
+                          scoredCandidates.end (),
+                          [](const std::pair<int64_t, PeerlistEntry> &lhs,
+                             const std::pair<int64_t, PeerlistEntry> &rhs)
+                          {
+                              return lhs.first > rhs.first;
+                          });
+
+        for (const auto &candidate : scoredCandidates) {
+            if (m_stop) {
+                break;
+            }
+
+            const PeerlistEntry &pe = candidate.second;
+
             logger (DEBUGGING)
                 << "Selected peer: "
                 << pe.id
@@ -1050,6 +1189,8 @@ namespace CryptoNote {
                 << pe.adr
                 << " [white="
                 << use_white_list
+                << "] [score="
+                << candidate.first
                 << "] last_seen: "
                 << (pe.last_seen ? Common::timeIntervalToString (time (NULL) - pe.last_seen) : "never");
 
@@ -1168,6 +1309,7 @@ namespace CryptoNote {
         try {
             m_connections_maker_interval.call (std::bind (&NodeServer::connectionsMaker, this));
             m_peerlist_store_interval.call (std::bind (&NodeServer::storeConfig, this));
+            m_payload_handler.relayQueuedTransactions ();
         } catch (std::exception &e) {
             logger (DEBUGGING)
                 << "exception in idleWorker: "
@@ -1366,7 +1508,7 @@ namespace CryptoNote {
     }
 
     bool NodeServer::invokeNotifyToPeer(int command,
-                                        const BinaryArray &buffer,
+                                        BinaryArray buffer,
                                         const CryptoNoteConnectionContext &context)
     {
         auto it = m_connections.find (context.m_connection_id);
@@ -1374,7 +1516,7 @@ namespace CryptoNote {
             return false;
         }
 
-        it->second.pushMessage (P2pMessage (P2pMessage::NOTIFY, command, buffer));
+        it->second.pushMessage (P2pMessage (P2pMessage::NOTIFY, command, std::move (buffer)));
 
         return true;
     }
@@ -1521,6 +1663,8 @@ namespace CryptoNote {
             return 1;
         }
 
+        context.m_listen_port = arg.node_data.my_port;
+
         if (!m_payload_handler.processPayloadSyncData (arg.payload_data, context, true)) {
             logger (Logging::ERROR)
                 << context
@@ -1642,6 +1786,17 @@ namespace CryptoNote {
         logger (TRACE)
             << context
             << "CLOSE CONNECTION";
+
+        /*!
+         * stats are kept for the address the peer listens on
+         */
+        NetworkAddress adr;
+        adr.ip = context.m_remote_ip;
+        adr.port = context.m_is_income ? context.m_listen_port : context.m_remote_port;
+        if (adr.port != 0) {
+            m_peerlist.updatePeerStats (adr, context.m_stats);
+        }
+
         m_payload_handler.onConnectionClosed (context);
     }
 
@@ -67,9 +67,9 @@ namespace CryptoNote {
             NOTIFY
         };
 
-        P2pMessage(Type type, uint32_t command, const BinaryArray &buffer, int32_t returnCode = 0)
+        P2pMessage(Type type, uint32_t command, BinaryArray buffer, int32_t returnCode = 0)
             :
-            type (type), command (command), buffer (buffer), returnCode (returnCode)
+            type (type), command (command), buffer (std::move (buffer)), returnCode (returnCode)
         {
         }
 
@@ -86,7 +86,7 @@ namespace CryptoNote {
 
         Type type;
         uint32_t command;
-        const BinaryArray buffer;
+        BinaryArray buffer;
         int32_t returnCode;
     };
 
@@ -231,9 +231,10 @@ namespace CryptoNote {
                                       const BinaryArray &data_buff,
                                       const boost::uuids::uuid *excludeConnection) override;
         virtual bool invokeNotifyToPeer(int command,
-                                        const BinaryArray &req_buff,
+                                        BinaryArray req_buff,
                                         const CryptoNoteConnectionContext &context) override;
         virtual void forEachConnection(std::function<void(CryptoNote::CryptoNoteConnectionContext &, uint64_t)> f) override;
+        virtual PeerStats getPeerStats(const CryptoNoteConnectionContext &context) const override;
         virtual void externalRelayNotifyToAll(int command,
                                               const BinaryArray &data_buff,
                                               const boost::uuids::uuid *excludeConnection) override;
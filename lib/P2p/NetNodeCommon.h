@@ -25,6 +25,7 @@
 #include <CryptoNote.h>
 
 #include <P2p/P2pProtocolTypes.h>
+#include <P2p/PeerStats.h>
 
 namespace CryptoNote {
 
@@ -36,10 +37,14 @@ namespace CryptoNote {
                             const BinaryArray &data_buff,
                             const boost::uuids::uuid *excludeConnection) = 0;
         virtual bool invokeNotifyToPeer(int command,
-                                           const BinaryArray &req_buff,
+                                           BinaryArray req_buff,
                                            const CryptoNote::CryptoNoteConnectionContext &context) = 0;
         virtual uint64_t getConnectionsCount() = 0;
         virtual void forEachConnection(std::function<void(CryptoNote::CryptoNoteConnectionContext &, uint64_t)> f) = 0;
+        /*!
+         * stats kept for the peer's address merged with those of the open connection
+         */
+        virtual PeerStats getPeerStats(const CryptoNote::CryptoNoteConnectionContext &context) const = 0;
         /*!
          * can be called from external threads
          */
@@ -59,7 +64,7 @@ namespace CryptoNote {
         {
         }
         virtual bool invokeNotifyToPeer(int command,
-                                           const BinaryArray &req_buff,
+                                           BinaryArray req_buff,
                                            const CryptoNote::CryptoNoteConnectionContext &context) override
         {
             return true;
@@ -72,6 +77,10 @@ namespace CryptoNote {
         {
             return 0;
         }
+        virtual PeerStats getPeerStats(const CryptoNote::CryptoNoteConnectionContext &context) const override
+        {
+            return PeerStats ();
+        }
         virtual void externalRelayNotifyToAll(int command,
                                               const BinaryArray &data_buff,
                                               const boost::uuids::uuid *excludeConnection) override
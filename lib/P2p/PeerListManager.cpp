@@ -26,19 +26,57 @@
 
 #include <System/Ipv4Address.h>
 
+namespace CryptoNote {
+    void serialize(PeerStats &stats, ISerializer &s)
+    {
+        s (stats.rtt, "rtt");
+        s (stats.bytesPerSecond, "bytes_per_second");
+        s (stats.invalidObjects, "invalid_objects");
+        s (stats.failures, "failures");
+    }
+} // namespace CryptoNote
+
 void PeerlistManager::serialize(CryptoNote::ISerializer &s)
 {
-    const uint8_t currentVersion = 1;
+    const uint8_t currentVersion = 2;
     uint8_t version = currentVersion;
 
     s (version, "version");
 
-    if (version != currentVersion) {
+    /*!
+     * version 1 has no peer stats, the lists are still good
+     */
+    if (version != currentVersion && version != 1) {
         return;
     }
 
     s (m_peers_white, "whitelist");
     s (m_peers_gray, "graylist");
+
+    if (version == 1) {
+        return;
+    }
+
+    /*!
+     * stats of peers which fell out of both lists aren't worth storing
+     */
+    if (s.type () == CryptoNote::ISerializer::OUTPUT) {
+        for (auto it = m_peer_stats.begin (); it != m_peer_stats.end ();) {
+            auto sameAddress = [&it](const PeerlistEntry &peer)
+            {
+                return peer.adr == it->first;
+            };
+
+            if (std::none_of (m_peers_white.begin (), m_peers_white.end (), sameAddress)
+                && std::none_of (m_peers_gray.begin (), m_peers_gray.end (), sameAddress)) {
+                it = m_peer_stats.erase (it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    s (m_peer_stats, "peer_stats");
 }
 
 void serialize(NetworkAddress &na, CryptoNote::ISerializer &s)
@@ -289,6 +327,26 @@ bool PeerlistManager::appendWithPeerGray(const PeerlistEntry &newPeer)
     return false;
 }
 
+CryptoNote::PeerStats PeerlistManager::getPeerStats(const NetworkAddress &adr) const
+{
+    auto it = m_peer_stats.find (adr);
+    if (it == m_peer_stats.end ()) {
+        return CryptoNote::PeerStats ();
+    }
+
+    return it->second;
+}
+
+void PeerlistManager::updatePeerStats(const NetworkAddress &adr, const CryptoNote::PeerStats &session)
+{
+    m_peer_stats[adr].merge (session);
+}
+
+void PeerlistManager::setPeerFailed(const NetworkAddress &adr)
+{
+    ++m_peer_stats[adr].failures;
+}
+
 Peerlist &PeerlistManager::getWhite()
 {
     return m_whitePeerlist;
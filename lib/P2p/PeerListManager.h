@@ -20,10 +20,12 @@
 #pragma once
 
 #include <list>
+#include <map>
 
 #include <Global/CryptoNoteConfig.h>
 
 #include <P2p/P2pProtocolTypes.h>
+#include <P2p/PeerStats.h>
 #include <P2p/Peerlist.h>
 
 #include <Serialization/ISerializer.h>
@@ -59,6 +61,10 @@ public:
     void trimWhitePeerlist();
     void trimGrayPeerlist();
 
+    CryptoNote::PeerStats getPeerStats(const NetworkAddress &adr) const;
+    void updatePeerStats(const NetworkAddress &adr, const CryptoNote::PeerStats &session);
+    void setPeerFailed(const NetworkAddress &adr);
+
     void serialize(CryptoNote::ISerializer &s);
 
     Peerlist &getWhite();
@@ -70,6 +76,7 @@ private:
     bool m_allow_local_ip;
     std::vector <PeerlistEntry> m_peers_gray;
     std::vector <PeerlistEntry> m_peers_white;
+    std::map <NetworkAddress, CryptoNote::PeerStats> m_peer_stats;
     Peerlist m_whitePeerlist;
     Peerlist m_grayPeerlist;
 };
@@ -0,0 +1,78 @@
+// Copyright (c) 2018-2019, The TurtleCoin Developers
+// Copyright (c) 2018-2020, The Qwertycoin Project
+//
+// This file is part of Qwertycoin.
+//
+// Qwertycoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Qwertycoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Qwertycoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+namespace CryptoNote {
+    /*!
+        Measured quality of a peer. A connection collects its own numbers while it
+        is open, on close they are folded into the ones the peerlist keeps for the
+        peer's address, so they outlive the connection and the node's restarts.
+    */
+    struct PeerStats
+    {
+        uint64_t rtt = 0;            // handshake round trip in milliseconds, 0 if never measured
+        uint64_t bytesPerSecond = 0; // NOTIFY_RESPONSE_GET_OBJECTS throughput, 0 if never measured
+        uint32_t invalidObjects = 0; // blocks that failed verification
+        uint32_t failures = 0;       // connection attempts failed in a row
+
+        void addRtt(uint64_t sample)
+        {
+            rtt = rtt == 0 ? sample : (rtt * 3 + sample) / 4;
+        }
+
+        void addThroughput(uint64_t sample)
+        {
+            bytesPerSecond = bytesPerSecond == 0 ? sample : (bytesPerSecond * 3 + sample) / 4;
+        }
+
+        /*!
+            folds the numbers of a finished connection in, the connection
+            was made so the failure streak is over
+        */
+        void merge(const PeerStats &session)
+        {
+            if (session.rtt != 0) {
+                addRtt (session.rtt);
+            }
+            if (session.bytesPerSecond != 0) {
+                addThroughput (session.bytesPerSecond);
+            }
+            invalidObjects += session.invalidObjects;
+            failures = 0;
+        }
+
+        /*!
+            higher is better, a peer nothing is known about scores 0 so it
+            still gets tried ahead of peers which proved to be slow or bad
+        */
+        int64_t score() const
+        {
+            int64_t result = 0;
+            result -= static_cast<int64_t>(std::min<uint64_t> (rtt, 10000) / 10);
+            result += static_cast<int64_t>(std::min<uint64_t> (bytesPerSecond / 1024, 1000));
+            result -= static_cast<int64_t>(invalidObjects) * 500;
+            result -= static_cast<int64_t>(failures) * 200;
+
+            return result;
+        }
+    };
+} // namespace CryptoNote
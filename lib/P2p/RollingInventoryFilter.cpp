@@ -0,0 +1,99 @@
+// Copyright (c) 2018-2019, The TurtleCoin Developers
+// Copyright (c) 2018-2020, The Qwertycoin Project
+//
+// This file is part of Qwertycoin.
+//
+// Qwertycoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Qwertycoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Qwertycoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <algorithm>
+#include <cstring>
+
+#include <Crypto/Random.h>
+
+#include <P2p/RollingInventoryFilter.h>
+
+namespace CryptoNote {
+
+    namespace {
+        /*!
+         * 32 bits and 16 probes per hash keep a single generation's
+         * false positive rate below one in a million
+         */
+        const size_t BITS_PER_HASH = 32;
+        const size_t PROBES_PER_HASH = 16;
+    } // namespace
+
+    RollingInventoryFilter::RollingInventoryFilter(size_t generationSize)
+        : m_generationSize (generationSize),
+          m_inserted (0),
+          m_salt (Random::randomValue<uint64_t> ()),
+          m_current ((generationSize * BITS_PER_HASH + 63) / 64, 0),
+          m_previous ((generationSize * BITS_PER_HASH + 63) / 64, 0)
+    {
+    }
+
+    bool RollingInventoryFilter::contains(const Crypto::Hash &hash) const
+    {
+        uint64_t h1, h2;
+        positions (hash, h1, h2);
+
+        return test (m_current, h1, h2) || test (m_previous, h1, h2);
+    }
+
+    void RollingInventoryFilter::insert(const Crypto::Hash &hash)
+    {
+        uint64_t h1, h2;
+        positions (hash, h1, h2);
+
+        if (test (m_current, h1, h2)) {
+            return;
+        }
+
+        if (m_inserted == m_generationSize) {
+            m_previous.swap (m_current);
+            std::fill (m_current.begin (), m_current.end (), 0);
+            m_inserted = 0;
+        }
+
+        const uint64_t size = m_current.size () * 64;
+        for (size_t i = 0; i < PROBES_PER_HASH; ++i) {
+            const uint64_t bit = (h1 + i * h2) % size;
+            m_current[bit / 64] |= uint64_t (1) << (bit % 64);
+        }
+
+        ++m_inserted;
+    }
+
+    void RollingInventoryFilter::positions(const Crypto::Hash &hash, uint64_t &h1, uint64_t &h2) const
+    {
+        uint64_t words[2];
+        std::memcpy (words, hash.data, sizeof (words));
+
+        h1 = words[0] ^ m_salt;
+        h2 = (words[1] ^ (m_salt << 32 | m_salt >> 32)) | 1;
+    }
+
+    bool RollingInventoryFilter::test(const std::vector<uint64_t> &bits, uint64_t h1, uint64_t h2)
+    {
+        const uint64_t size = bits.size () * 64;
+        for (size_t i = 0; i < PROBES_PER_HASH; ++i) {
+            const uint64_t bit = (h1 + i * h2) % size;
+            if ((bits[bit / 64] & (uint64_t (1) << (bit % 64))) == 0) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+} // namespace CryptoNote
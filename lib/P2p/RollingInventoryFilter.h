@@ -0,0 +1,57 @@
+// Copyright (c) 2018-2019, The TurtleCoin Developers
+// Copyright (c) 2018-2020, The Qwertycoin Project
+//
+// This file is part of Qwertycoin.
+//
+// Qwertycoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Qwertycoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Qwertycoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <CryptoTypes.h>
+
+namespace CryptoNote {
+    /*!
+        Remembers which inventory (transaction hashes) a peer is known to have, so it
+        isn't announced back to the peer it came from or sent twice to the same peer.
+        Two bloom filter generations roll over: once the current one took generationSize
+        hashes it replaces the previous one, so at least the last generationSize hashes
+        are always remembered in a fixed amount of memory. False positives only cost an
+        announce that is skipped. The positions are the hash bits XORed with a random
+        salt per filter, so hashes colliding in one node's filter generally don't
+        collide in another's. This is not a keyed hash and doesn't stop collisions
+        from being searched for.
+    */
+    class RollingInventoryFilter
+    {
+    public:
+        explicit RollingInventoryFilter(size_t generationSize = 4096);
+
+        bool contains(const Crypto::Hash &hash) const;
+        void insert(const Crypto::Hash &hash);
+
+    private:
+        void positions(const Crypto::Hash &hash, uint64_t &h1, uint64_t &h2) const;
+        static bool test(const std::vector<uint64_t> &bits, uint64_t h1, uint64_t h2);
+
+        size_t m_generationSize;
+        size_t m_inserted;
+        uint64_t m_salt;
+        std::vector<uint64_t> m_current;
+        std::vector<uint64_t> m_previous;
+    };
+} // namespace CryptoNote
@@ -249,6 +249,61 @@ namespace System {
         }
     }
 
+    void MemoryMappedFile::resize(uint64_t newSize, std::error_code &ec)
+    {
+        assert(isOpened ());
+
+        /*!
+            the file must cover the mapping whenever it is touched, so it is
+            grown before remapping and shrunk after
+        */
+        if (newSize > m_size && ::ftruncate (m_file, static_cast<off_t>(newSize)) == -1) {
+            ec = std::error_code (errno, std::system_category ());
+            return;
+        }
+
+#ifdef __linux__
+        void *data = ::mremap (m_data, static_cast<size_t>(m_size), static_cast<size_t>(newSize), MREMAP_MAYMOVE);
+#else
+        void *data = ::mmap (nullptr,
+                             static_cast<size_t>(newSize),
+                             PROT_READ | PROT_WRITE,
+                             MAP_SHARED,
+                             m_file,
+                             0);
+        if (data != MAP_FAILED) {
+            ::munmap (m_data, static_cast<size_t>(m_size));
+        }
+#endif
+        if (data == MAP_FAILED) {
+            ec = std::error_code (errno, std::system_category ());
+            if (newSize > m_size) {
+                (void) ::ftruncate (m_file, static_cast<off_t>(m_size));
+            }
+            return;
+        }
+
+        m_data = reinterpret_cast<uint8_t *>(data);
+
+        if (newSize < m_size && ::ftruncate (m_file, static_cast<off_t>(newSize)) == -1) {
+            ec = std::error_code (errno, std::system_category ());
+            m_size = newSize;
+            return;
+        }
+
+        m_size = newSize;
+        ec = std::error_code ();
+    }
+
+    void MemoryMappedFile::resize(uint64_t newSize)
+    {
+        std::error_code ec;
+        resize (newSize, ec);
+        if (ec) {
+            throw std::system_error (ec, "MemoryMappedFile::resize");
+        }
+    }
+
     void MemoryMappedFile::flush(uint8_t *data, uint64_t size, std::error_code &ec)
     {
         assert(isOpened ());
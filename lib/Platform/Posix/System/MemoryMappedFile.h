@@ -46,6 +46,13 @@ namespace System {
         void rename(const std::string &newPath, std::error_code &ec);
         void rename(const std::string &newPath);
 
+        /*!
+            grows or shrinks the file and its mapping in place, data() may
+            change
+        */
+        void resize(uint64_t newSize, std::error_code &ec);
+        void resize(uint64_t newSize);
+
         void flush(uint8_t *data, uint64_t size, std::error_code &ec);
         void flush(uint8_t *data, uint64_t size);
 
@@ -84,11 +84,17 @@ namespace System {
             }
         }
 
+        /*!
+            on failure the old size is mapped again, so the file stays usable like
+            on posix. it is only closed when even that fails
+        */
         Tools::ScopeExit failExitHandler ([this, &ec]
                                           {
                                               ec = std::error_code (::GetLastError (), std::system_category ());
-                                              std::error_code ignore;
-                                              close (ignore);
+                                              if (!remap (m_size)) {
+                                                  std::error_code ignore;
+                                                  close (ignore);
+                                              }
                                           });
 
         m_fileHandle = ::CreateFile (
@@ -155,11 +161,17 @@ namespace System {
             }
         }
 
+        /*!
+            on failure the old size is mapped again, so the file stays usable like
+            on posix. it is only closed when even that fails
+        */
         Tools::ScopeExit failExitHandler ([this, &ec]
                                           {
                                               ec = std::error_code (::GetLastError (), std::system_category ());
-                                              std::error_code ignore;
-                                              close (ignore);
+                                              if (!remap (m_size)) {
+                                                  std::error_code ignore;
+                                                  close (ignore);
+                                              }
                                           });
 
         m_fileHandle = ::CreateFile (
@@ -282,6 +294,116 @@ namespace System {
         }
     }
 
+    void MemoryMappedFile::resize(uint64_t newSize, std::error_code &ec)
+    {
+        assert(isOpened ());
+
+        /*!
+            a file can't be resized while mapped, so the view and mapping are
+            recreated around SetEndOfFile
+        */
+        BOOL result = ::UnmapViewOfFile (m_data);
+        if (!result) {
+            ec = std::error_code (::GetLastError (), std::system_category ());
+            return;
+        }
+
+        m_data = nullptr;
+
+        /*!
+            on failure the old size is mapped again, so the file stays usable like
+            on posix. it is only closed when even that fails
+        */
+        Tools::ScopeExit failExitHandler ([this, &ec]
+                                          {
+                                              ec = std::error_code (::GetLastError (), std::system_category ());
+                                              if (!remap (m_size)) {
+                                                  std::error_code ignore;
+                                                  close (ignore);
+                                              }
+                                          });
+
+        result = ::CloseHandle (m_mappingHandle);
+        if (!result) {
+            return;
+        }
+
+        m_mappingHandle = INVALID_HANDLE_VALUE;
+
+        LONG distanceToMoveHigh = static_cast<LONG>((
+                                                        newSize
+                                                            >> 32
+                                                    ) & UINT64_C(0xffffffff));
+        DWORD filePointer = ::SetFilePointer (m_fileHandle,
+                                              static_cast<LONG>(newSize & UINT64_C(0xffffffff)),
+                                              &distanceToMoveHigh,
+                                              FILE_BEGIN);
+        if (filePointer == INVALID_SET_FILE_POINTER) {
+            return;
+        }
+
+        result = ::SetEndOfFile (m_fileHandle);
+        if (!result) {
+            return;
+        }
+
+        m_mappingHandle = ::CreateFileMapping (m_fileHandle, NULL, PAGE_READWRITE, 0, 0, NULL);
+        if (m_mappingHandle == NULL) {
+            m_mappingHandle = INVALID_HANDLE_VALUE;
+            return;
+        }
+
+        m_data = reinterpret_cast<uint8_t *>(::MapViewOfFile (m_mappingHandle, FILE_MAP_ALL_ACCESS, 0, 0, 0));
+        if (m_data == NULL) {
+            return;
+        }
+
+        m_size = newSize;
+        ec = std::error_code ();
+
+        failExitHandler.cancel ();
+    }
+
+    bool MemoryMappedFile::remap(uint64_t size)
+    {
+        if (m_mappingHandle != INVALID_HANDLE_VALUE) {
+            ::CloseHandle (m_mappingHandle);
+            m_mappingHandle = INVALID_HANDLE_VALUE;
+        }
+
+        LONG distanceToMoveHigh = static_cast<LONG>((size >> 32) & UINT64_C(0xffffffff));
+        DWORD filePointer = ::SetFilePointer (m_fileHandle,
+                                              static_cast<LONG>(size & UINT64_C(0xffffffff)),
+                                              &distanceToMoveHigh,
+                                              FILE_BEGIN);
+        if (filePointer == INVALID_SET_FILE_POINTER || !::SetEndOfFile (m_fileHandle)) {
+            return false;
+        }
+
+        m_mappingHandle = ::CreateFileMapping (m_fileHandle, NULL, PAGE_READWRITE, 0, 0, NULL);
+        if (m_mappingHandle == NULL) {
+            m_mappingHandle = INVALID_HANDLE_VALUE;
+            return false;
+        }
+
+        m_data = reinterpret_cast<uint8_t *>(::MapViewOfFile (m_mappingHandle, FILE_MAP_ALL_ACCESS, 0, 0, 0));
+        if (m_data == NULL) {
+            m_data = nullptr;
+            return false;
+        }
+
+        return true;
+    }
+
+    void MemoryMappedFile::resize(uint64_t newSize)
+    {
+        std::error_code ec;
+        resize (newSize, ec);
+        if (ec) {
+            throw std::system_error (ec, "MemoryMappedFile::resize");
+        }
+    }
+
     void MemoryMappedFile::flush(uint8_t *data, uint64_t size, std::error_code &ec)
     {
         assert(isOpened ());
@@ -46,12 +46,24 @@ namespace System {
         void rename(const std::string &newPath, std::error_code &ec);
         void rename(const std::string &newPath);
 
+        /*!
+            grows or shrinks the file and its mapping in place, data() may
+            change. on failure the old size stays mapped
+        */
+        void resize(uint64_t newSize, std::error_code &ec);
+        void resize(uint64_t newSize);
+
         void flush(uint8_t *data, uint64_t size, std::error_code &ec);
         void flush(uint8_t *data, uint64_t size);
 
         void swap(MemoryMappedFile &other);
 
     private:
+        /*!
+            sets the file to size and maps all of it, expects the view to be unmapped
+        */
+        bool remap(uint64_t size);
+
         void *m_fileHandle;
         void *m_mappingHandle;
         std::string m_path;
@@ -192,6 +192,47 @@ namespace CryptoNote {
         };
     };
 
+    struct COMMAND_RPC_GET_STATUS_CHANGES
+    {
+        struct request
+        {
+            /*!
+             * the top block and pool version the client already knows about,
+             * the call returns as soon as either of them is outdated
+             */
+            Crypto::Hash topBlockHash;
+            uint64_t poolVersion;
+
+            /*!
+             * how long to wait for a change, in milliseconds
+             */
+            uint64_t timeout;
+
+            void serialize(ISerializer &s)
+            {
+                KV_MEMBER(topBlockHash)
+                KV_MEMBER(poolVersion)
+                KV_MEMBER(timeout)
+            }
+        };
+
+        struct response
+        {
+            uint64_t height;
+            Crypto::Hash topBlockHash;
+            uint64_t poolVersion;
+            std::string status;
+
+            void serialize(ISerializer &s)
+            {
+                KV_MEMBER(height)
+                KV_MEMBER(topBlockHash)
+                KV_MEMBER(poolVersion)
+                KV_MEMBER(status)
+            }
+        };
+    };
+
     struct COMMAND_RPC_GET_TX_GLOBAL_OUTPUTS_INDEXES
     {
 
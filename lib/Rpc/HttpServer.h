@@ -41,7 +41,7 @@ namespace CryptoNote {
         HttpServer(System::Dispatcher &dispatcher, std::shared_ptr<Logging::ILogger> log);
 
         void start(const std::string &address, uint16_t port);
-        void stop();
+        virtual void stop();
 
         virtual void processRequest(const HttpRequest &request, HttpResponse &response) = 0;
 
@@ -24,6 +24,7 @@
 #include <unordered_map>
 
 #include <Common/CryptoNoteTools.h>
+#include <Common/Metrics.h>
 #include <Common/StringTools.h>
 #include <CryptoNoteCore/Transactions/TransactionExtra.h>
 
@@ -40,6 +41,9 @@
 #include <Rpc/JsonRpc.h>
 #include <Rpc/RpcServer.h>
 
+#include <System/ContextGroupTimeout.h>
+#include <System/InterruptedException.h>
+
 #include <Utilities/FormatTools.h>
 
 #include <version.h>
@@ -124,6 +128,11 @@ namespace CryptoNote {
 
     namespace {
 
+        /*!
+         * upper bound for a single /get_status_changes wait
+         */
+        const uint64_t MAX_STATUS_CHANGES_TIMEOUT = 60000;
+
         template<typename Command>
         RpcServer::HandlerFunction
         jsonMethod(bool (RpcServer::*handler)(typename Command::request const &, typename Command::response &))
@@ -231,6 +240,10 @@ namespace CryptoNote {
             "/get_pool_changes_lite",
             {jsonMethod<COMMAND_RPC_GET_POOL_CHANGES_LITE> (&RpcServer::onGetPoolChangesLite), false}
         },
+        {
+            "/get_status_changes",
+            {jsonMethod<COMMAND_RPC_GET_STATUS_CHANGES> (&RpcServer::onGetStatusChanges), false}
+        },
         {
             "/get_block_details_by_height",
             {jsonMethod<COMMAND_RPC_GET_BLOCK_DETAILS_BY_HEIGHT> (&RpcServer::onGetBlockDetailsByHeight), false}
@@ -270,6 +283,14 @@ namespace CryptoNote {
         {
             "/json_rpc",
             {std::bind (&RpcServer::processJsonRpcRequest,
+                        std::placeholders::_1,
+                        std::placeholders::_2,
+                        std::placeholders::_3), true}},
+
+        // prometheus text format
+        {
+            "/metrics",
+            {std::bind (&RpcServer::onGetMetrics,
                         std::placeholders::_1,
                         std::placeholders::_2,
                         std::placeholders::_3), true}}
@@ -284,8 +305,57 @@ namespace CryptoNote {
           logger (log, "RpcServer"),
           m_core (c),
           m_p2p (p2p),
-          m_protocol (protocol)
+          m_protocol (protocol),
+          m_blockchainMessages (dispatcher),
+          m_statusChanged (dispatcher),
+          m_statusContextGroup (dispatcher),
+          m_poolVersion (0),
+          m_statusStopped (false)
     {
+        m_core.addMessageQueue (m_blockchainMessages);
+        m_statusContextGroup.spawn (std::bind (&RpcServer::watchBlockchainMessages, this));
+    }
+
+    RpcServer::~RpcServer()
+    {
+        m_blockchainMessages.stop ();
+        m_statusContextGroup.interrupt ();
+        m_statusContextGroup.wait ();
+        m_core.removeMessageQueue (m_blockchainMessages);
+    }
+
+    void RpcServer::stop()
+    {
+        /*!
+         * release the pending long polls first, HttpServer::stop () waits for every connection
+         */
+        m_statusStopped = true;
+        m_statusChanged.set ();
+        m_statusChanged.clear ();
+
+        HttpServer::stop ();
+    }
+
+    void RpcServer::watchBlockchainMessages()
+    {
+        try {
+            for (;;) {
+                const auto type = m_blockchainMessages.front ().getType ();
+                m_blockchainMessages.pop ();
+
+                if (type == BlockchainMessage::Type::AddTransaction
+                    || type == BlockchainMessage::Type::DeleteTransaction) {
+                    ++m_poolVersion;
+                }
+
+                /*!
+                 * wake every waiter, each of them re-checks its own state
+                 */
+                m_statusChanged.set ();
+                m_statusChanged.clear ();
+            }
+        } catch (System::InterruptedException &) {
+        }
     }
 
     void RpcServer::processRequest(const HttpRequest &request, HttpResponse &response)
@@ -303,18 +373,51 @@ namespace CryptoNote {
                 << std::endl;
         }
 
+        /*!
+            the metrics are looked up in the registry once, a request only touches
+            their atomics. Only urls with a handler become label values, so the
+            label set stays bounded
+        */
+        static auto &notFound = Metrics::Registry::instance ().counter (
+            "rpc_requests_rejected_total",
+            "RPC requests answered without running a handler",
+            "reason",
+            "not_found");
+        static auto &coreBusy = Metrics::Registry::instance ().counter (
+            "rpc_requests_rejected_total",
+            "RPC requests answered without running a handler",
+            "reason",
+            "core_busy");
+        static const auto durations = []
+        {
+            std::unordered_map<std::string, Metrics::Histogram *> result;
+            for (const auto &handler : s_handlers) {
+                result.emplace (handler.first,
+                                &Metrics::Registry::instance ().histogram (
+                                    "rpc_request_duration_seconds",
+                                    "Time spent in the handler of an RPC endpoint",
+                                    "endpoint",
+                                    handler.first));
+            }
+            return result;
+        } ();
+
         auto it = s_handlers.find (url);
         if (it == s_handlers.end ()) {
+            notFound.inc ();
             response.setStatus (HttpResponse::STATUS_404);
             return;
         }
 
         if (!it->second.allowBusyCore && !isCoreReady ()) {
+            coreBusy.inc ();
             response.setStatus (HttpResponse::STATUS_500);
             response.setBody ("Core is busy");
             return;
         }
 
+        Metrics::ScopedTimer timer (*durations.at (url));
+
         it->second.handler (this, request, response);
     }
 
@@ -377,6 +480,38 @@ namespace CryptoNote {
         return true;
     }
 
+    bool RpcServer::onGetMetrics(const HttpRequest &request, HttpResponse &response)
+    {
+        auto &registry = Metrics::Registry::instance ();
+
+        /*!
+            chain and network state is sampled at scrape time, the hot path
+            metrics are updated where the work happens
+        */
+        const uint64_t connections = m_p2p.getConnectionsCount ();
+        const uint64_t outgoingConnections = m_p2p.getOutgoingConnectionsCount ();
+
+        registry.gauge ("core_height", "Number of blocks in the main chain").set (m_core.getTopBlockIndex () + 1);
+        registry.gauge ("core_alternative_blocks", "Number of alternative blocks")
+            .set (m_core.getAlternativeBlockCount ());
+        registry.gauge ("core_pool_transactions", "Number of transactions in the pool")
+            .set (m_core.getPoolTransactionCount ());
+        registry.gauge ("p2p_network_height", "Highest block height reported by peers")
+            .set (std::max (static_cast<uint32_t>(1), m_protocol.getBlockchainHeight ()));
+        registry.gauge ("p2p_connections", "Number of peer connections", "direction", "outgoing")
+            .set (outgoingConnections);
+        registry.gauge ("p2p_connections", "Number of peer connections", "direction", "incoming")
+            .set (connections - outgoingConnections);
+
+        for (const auto &cors_domain: m_cors_domains) {
+            response.addHeader ("Access-Control-Allow-Origin", cors_domain);
+        }
+        response.addHeader ("Content-Type", "text/plain; version=0.0.4");
+        response.setBody (registry.toPrometheus ());
+
+        return true;
+    }
+
     bool RpcServer::setFeeAddress(const std::string fee_address)
     {
         m_fee_address = fee_address;
@@ -656,6 +791,43 @@ namespace CryptoNote {
         return true;
     }
 
+    bool RpcServer::onGetStatusChanges(const COMMAND_RPC_GET_STATUS_CHANGES::request &req,
+                                       COMMAND_RPC_GET_STATUS_CHANGES::response &rsp)
+    {
+        auto isKnown = [this, &req]()
+        {
+            return !m_statusStopped
+                   && m_poolVersion == req.poolVersion
+                   && m_core.getTopBlockHash () == req.topBlockHash;
+        };
+
+        const uint64_t timeout = std::min (req.timeout, MAX_STATUS_CHANGES_TIMEOUT);
+
+        if (timeout != 0 && isKnown ()) {
+            System::ContextGroup waitGroup (m_dispatcher);
+            System::ContextGroupTimeout waitTimeout (m_dispatcher, waitGroup, std::chrono::milliseconds (timeout));
+
+            waitGroup.spawn ([this, &isKnown]()
+                             {
+                                 try {
+                                     while (isKnown ()) {
+                                         m_statusChanged.wait ();
+                                     }
+                                 } catch (System::InterruptedException &) {
+                                 }
+                             });
+
+            waitGroup.wait ();
+        }
+
+        rsp.height = m_core.getTopBlockIndex () + 1;
+        rsp.topBlockHash = m_core.getTopBlockHash ();
+        rsp.poolVersion = m_poolVersion;
+        rsp.status = CORE_RPC_STATUS_OK;
+
+        return true;
+    }
+
     bool RpcServer::onGetBlocksDetailsByHeights(const COMMAND_RPC_GET_BLOCKS_DETAILS_BY_HEIGHTS::request &req,
                                                 COMMAND_RPC_GET_BLOCKS_DETAILS_BY_HEIGHTS::response &rsp)
     {
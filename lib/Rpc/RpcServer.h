@@ -26,6 +26,9 @@
 
 #include <Common/Math.h>
 
+#include <CryptoNoteCore/Blockchain/BlockchainMessages.h>
+#include <CryptoNoteCore/MessageQueue.h>
+
 #include <Logging/LoggerRef.h>
 
 #include <Rpc/CoreRpcServerCommandsDefinitions.h>
@@ -47,6 +50,10 @@ namespace CryptoNote {
                   NodeServer &p2p,
                   ICryptoNoteProtocolHandler &protocol);
 
+        virtual ~RpcServer();
+
+        virtual void stop() override;
+
         typedef std::function<bool(RpcServer *, const HttpRequest &request, HttpResponse &response)> HandlerFunction;
         bool enableCors(const std::vector <std::string> domains);
         bool setFeeAddress(const std::string fee_address);
@@ -72,7 +79,9 @@ namespace CryptoNote {
 
         virtual void processRequest(const HttpRequest &request, HttpResponse &response) override;
         bool processJsonRpcRequest(const HttpRequest &request, HttpResponse &response);
+        bool onGetMetrics(const HttpRequest &request, HttpResponse &response);
         bool isCoreReady();
+        void watchBlockchainMessages();
 
         /*!
          * json handlers
@@ -100,6 +109,8 @@ namespace CryptoNote {
                               COMMAND_RPC_GET_POOL_CHANGES::response &rsp);
         bool onGetPoolChangesLite(const COMMAND_RPC_GET_POOL_CHANGES_LITE::request &req,
                                   COMMAND_RPC_GET_POOL_CHANGES_LITE::response &rsp);
+        bool onGetStatusChanges(const COMMAND_RPC_GET_STATUS_CHANGES::request &req,
+                                COMMAND_RPC_GET_STATUS_CHANGES::response &rsp);
         bool onGetBlocksDetailsByHeights(const COMMAND_RPC_GET_BLOCKS_DETAILS_BY_HEIGHTS::request &req,
                                          COMMAND_RPC_GET_BLOCKS_DETAILS_BY_HEIGHTS::response &rsp);
         bool onGetBlocksDetailsByHashes(const COMMAND_RPC_GET_BLOCKS_DETAILS_BY_HASHES::request &req,
@@ -158,6 +169,16 @@ namespace CryptoNote {
         std::vector <std::string> m_cors_domains;
         std::string m_fee_address;
         uint32_t m_fee_amount;
+
+        /*!
+         * wakes up /get_status_changes callers whenever the core reports a new block
+         * or a pool change; m_poolVersion is bumped on every pool change
+         */
+        MessageQueue<BlockchainMessage> m_blockchainMessages;
+        System::Event m_statusChanged;
+        System::ContextGroup m_statusContextGroup;
+        uint64_t m_poolVersion;
+        bool m_statusStopped;
     };
 
 } // namespace CryptoNote
@@ -17,6 +17,7 @@
 // along with Qwertycoin.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <cassert>
+#include <limits>
 #include <stdexcept>
 
 #include <Common/StreamTools.h>
@@ -76,6 +77,27 @@ namespace {
 
 namespace CryptoNote {
 
+    void writeKVBinaryHeader(IOutputStream &target)
+    {
+        KVBinaryStorageBlockHeader hdr;
+        hdr.m_signature_a = PORTABLE_STORAGE_SIGNATUREA;
+        hdr.m_signature_b = PORTABLE_STORAGE_SIGNATUREB;
+        hdr.m_ver = PORTABLE_STORAGE_FORMAT_VER;
+
+        Common::write (target, &hdr, sizeof (hdr));
+    }
+
+    void writeKVBinaryArraySize(IOutputStream &target, uint64_t size)
+    {
+        writeArraySize (target, size);
+    }
+
+    void writeKVBinaryElementPrefix(IOutputStream &target, Common::StringView name, uint8_t type)
+    {
+        writeElementName (target, name);
+        write (target, &type, 1);
+    }
+
     KVBinaryOutputStreamSerializer::KVBinaryOutputStreamSerializer()
     {
         beginObject (std::string ());
@@ -86,12 +108,7 @@ namespace CryptoNote {
         assert (m_objectsStack.size () == 1);
         assert (m_stack.size () == 1);
 
-        KVBinaryStorageBlockHeader hdr;
-        hdr.m_signature_a = PORTABLE_STORAGE_SIGNATUREA;
-        hdr.m_signature_b = PORTABLE_STORAGE_SIGNATUREB;
-        hdr.m_ver = PORTABLE_STORAGE_FORMAT_VER;
-
-        Common::write (target, &hdr, sizeof (hdr));
+        writeKVBinaryHeader (target);
         writeArraySize (target, m_stack.front ().count);
         write (target, stream ().data (), stream ().size ());
     }
@@ -109,4 +109,12 @@ namespace CryptoNote {
         std::vector<Level> m_stack;
     };
 
+    /*!
+        the encoding primitives of the serializer, for encoders of a fixed layout
+        that write straight into one buffer
+    */
+    void writeKVBinaryHeader(Common::IOutputStream &target);
+    void writeKVBinaryArraySize(Common::IOutputStream &target, uint64_t size);
+    void writeKVBinaryElementPrefix(Common::IOutputStream &target, Common::StringView name, uint8_t type);
+
 } // namespace CryptoNote
@@ -0,0 +1,134 @@
+// Copyright (c) 2018-2020, The Qwertycoin Project
+//
+// This file is part of Qwertycoin.
+//
+// Qwertycoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Qwertycoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Qwertycoin.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+#include <Utilities/ThreadPool.h>
+
+namespace Utilities {
+
+    /*!
+     * Runs function for every index in [0, count) on the calling thread and the
+     * shared worker pool. Indexes are handed out in order but may complete in any
+     * order, so function should only write to a slot owned by its index. The
+     * caller always takes part, helpers that don't fit into the pool queue or
+     * start after the caller ran out of indexes simply do nothing, so a busy pool
+     * slows the loop down instead of blocking it. The first exception thrown by
+     * function is rethrown once every running helper has finished.
+     */
+    template<typename Function>
+    void parallelFor(size_t count, Function function)
+    {
+        auto &pool = ThreadPool::shared ();
+
+        /*!
+         * Not worth a helper for a single item
+         */
+        const size_t helpers = std::min (pool.threadCount (), count) - (count == 0 ? 0 : 1);
+        if (helpers == 0) {
+            for (size_t index = 0; index < count; ++index) {
+                function (index);
+            }
+            return;
+        }
+
+        struct State
+        {
+            std::atomic<size_t> nextIndex {0};
+            std::mutex mutex;
+            std::condition_variable finished;
+            size_t active = 0;
+            bool closed = false;
+            std::exception_ptr error;
+        };
+
+        auto state = std::make_shared<State> ();
+        const std::function<void(size_t)> work = std::ref (function);
+
+        auto run = [count](State &state, const std::function<void(size_t)> &work)
+        {
+            try {
+                for (size_t index = state.nextIndex++; index < count; index = state.nextIndex++) {
+                    work (index);
+                }
+            } catch (...) {
+                std::unique_lock<std::mutex> lock (state.mutex);
+                if (!state.error) {
+                    state.error = std::current_exception ();
+                }
+
+                /*!
+                 * stop handing out indexes
+                 */
+                state.nextIndex = count;
+            }
+        };
+
+        for (size_t i = 0; i < helpers; ++i) {
+            const bool queued = pool.tryPush ([state, &work, run]()
+            {
+                {
+                    std::unique_lock<std::mutex> lock (state->mutex);
+
+                    /*!
+                     * the caller may already have returned, work is gone then
+                     */
+                    if (state->closed) {
+                        return;
+                    }
+
+                    ++state->active;
+                }
+
+                run (*state, work);
+
+                {
+                    std::unique_lock<std::mutex> lock (state->mutex);
+                    --state->active;
+                }
+
+                state->finished.notify_all ();
+            });
+
+            if (!queued) {
+                break;
+            }
+        }
+
+        run (*state, work);
+
+        std::unique_lock<std::mutex> lock (state->mutex);
+        state->closed = true;
+        state->finished.wait (lock, [&state]
+        {
+            return state->active == 0;
+        });
+
+        if (state->error) {
+            std::rethrow_exception (state->error);
+        }
+    }
+
+} // namespace Utilities
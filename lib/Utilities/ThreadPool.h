@@ -0,0 +1,145 @@
+// Copyright (c) 2018-2020, The Qwertycoin Project
+//
+// This file is part of Qwertycoin.
+//
+// Qwertycoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Qwertycoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Qwertycoin.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Utilities {
+
+    /*!
+     * Fixed set of worker threads fed from a bounded task queue. Pushing into a
+     * full queue fails instead of growing it, so callers decide between doing
+     * the work themselves, waiting or dropping it. The threads live as long as
+     * the pool, the destructor runs the queued tasks before joining them.
+     */
+    class ThreadPool
+    {
+    public:
+        ThreadPool(size_t threadCount, size_t maxQueuedTasks)
+            : m_maxQueuedTasks (std::max<size_t> (maxQueuedTasks, 1)),
+              m_stopping (false)
+        {
+            threadCount = std::max<size_t> (threadCount, 1);
+            m_threads.reserve (threadCount);
+
+            for (size_t i = 0; i < threadCount; ++i) {
+                m_threads.emplace_back (&ThreadPool::worker, this);
+            }
+        }
+
+        ~ThreadPool()
+        {
+            {
+                std::unique_lock<std::mutex> lock (m_mutex);
+                m_stopping = true;
+            }
+
+            m_haveTask.notify_all ();
+
+            for (auto &thread : m_threads) {
+                thread.join ();
+            }
+        }
+
+        ThreadPool(const ThreadPool &) = delete;
+        ThreadPool &operator=(const ThreadPool &) = delete;
+
+        /*!
+         * Queues task unless the queue is full or the pool is stopping,
+         * task must not throw
+         */
+        bool tryPush(std::function<void()> &&task)
+        {
+            {
+                std::unique_lock<std::mutex> lock (m_mutex);
+
+                if (m_stopping || m_tasks.size () >= m_maxQueuedTasks) {
+                    return false;
+                }
+
+                m_tasks.push_back (std::move (task));
+            }
+
+            m_haveTask.notify_one ();
+
+            return true;
+        }
+
+        size_t threadCount() const
+        {
+            return m_threads.size ();
+        }
+
+        /*!
+         * Process wide pool with a thread per core, created on first use. Tasks
+         * run on it must not block waiting for other tasks of the pool.
+         */
+        static ThreadPool &shared()
+        {
+            static ThreadPool pool (hardwareThreads (), hardwareThreads () * 4);
+            return pool;
+        }
+
+        static size_t hardwareThreads()
+        {
+            const size_t threads = std::thread::hardware_concurrency ();
+            return threads == 0 ? 2 : threads;
+        }
+
+    private:
+        void worker()
+        {
+            for (;;) {
+                std::function<void()> task;
+
+                {
+                    std::unique_lock<std::mutex> lock (m_mutex);
+
+                    m_haveTask.wait (lock, [this]
+                    {
+                        return m_stopping || !m_tasks.empty ();
+                    });
+
+                    if (m_tasks.empty ()) {
+                        return;
+                    }
+
+                    task = std::move (m_tasks.front ());
+                    m_tasks.pop_front ();
+                }
+
+                task ();
+            }
+        }
+
+        const size_t m_maxQueuedTasks;
+        bool m_stopping;
+        std::mutex m_mutex;
+        std::condition_variable m_haveTask;
+        std::deque<std::function<void()>> m_tasks;
+        std::vector<std::thread> m_threads;
+    };
+
+} // namespace Utilities
@@ -18,10 +18,13 @@
 
 #pragma once
 
+#include <algorithm>
 #include <condition_variable>
 #include <deque>
+#include <functional>
 #include <iostream>
 #include <mutex>
+#include <numeric>
 
 template<typename T>
 class ThreadSafeDeque
@@ -39,6 +42,17 @@ public:
     {
     }
 
+    /*!
+     * memUsage gives the size of one item. It is called once when the item
+     * is pushed and once when it is removed, which keeps memoryUsage() O(1)
+     */
+    ThreadSafeDeque(std::function<size_t(const T &)> memUsage, bool startStopped)
+        :
+        m_memUsage (std::move (memUsage)),
+        m_shouldStop (startStopped)
+    {
+    }
+
     /*!
      * Move constructor
      */
@@ -55,6 +69,9 @@ public:
         stop ();
 
         m_deque = std::move (old.m_deque);
+        m_memUsage = std::move (old.m_memUsage);
+        m_memoryUsage = old.m_memoryUsage;
+        old.m_memoryUsage = 0;
 
         return *this;
     }
@@ -81,6 +98,7 @@ public:
 
         for (auto it = begin; it < end; it++) {
             m_deque.push_back (*it);
+            m_memoryUsage += itemMemoryUsage (m_deque.back ());
         }
 
         /*!
@@ -117,7 +135,8 @@ public:
         /*!
          * Add the item to the front of the queue
          */
-        m_deque.push_back (item);
+        m_memoryUsage += itemMemoryUsage (item);
+        m_deque.push_back (std::move (item));
 
         /*!
          * Unlock the mutex before notifying, so it doesn't block after
@@ -158,6 +177,7 @@ public:
         /*!
          * Remove the first item from the queue
          */
+        m_memoryUsage -= itemMemoryUsage (m_deque.front ());
         m_deque.pop_front ();
 
         /*!
@@ -201,6 +221,7 @@ public:
             /*!
              * Remove first item from queue
              */
+            m_memoryUsage -= itemMemoryUsage (m_deque.front ());
             m_deque.pop_front ();
             numElements--;
         }
@@ -243,16 +264,17 @@ public:
             return results;
         }
 
-        if (m_deque.size () <= numElements) {
-            results.resize (m_deque.size ());
-            std::copy (m_deque.begin (), m_deque.end (), results.begin ());
-            m_deque.clear ();
-        } else {
-            results.resize (numElements);
-            std::copy (m_deque.begin (), m_deque.begin () + numElements, results.begin ());
-            m_deque.erase (m_deque.begin (), m_deque.begin () + numElements);
+        const size_t count = std::min (m_deque.size (), numElements);
+
+        results.reserve (count);
+
+        for (auto it = m_deque.begin (); it != m_deque.begin () + count; it++) {
+            m_memoryUsage -= itemMemoryUsage (*it);
+            results.push_back (std::move (*it));
         }
 
+        m_deque.erase (m_deque.begin (), m_deque.begin () + count);
+
         return results;
     }
 
@@ -352,12 +374,13 @@ public:
         std::unique_lock<std::mutex> lock (m_mutex);
 
         m_deque.clear ();
+        m_memoryUsage = 0;
     }
 
     /*!
-     * Recommended to implement a memoryUsage() method for your type, if not using
-     * a simple type, and pass to the below function instead.
-     * Otherwise, sizeof() is unlikely to be accurate.
+     * Recommended to construct the queue with a memUsage function for your
+     * type, if not using a simple type. Otherwise, sizeof() is unlikely to be
+     * accurate. Kept as a running total, so this is O(1).
      */
     size_t memoryUsage() const
     {
@@ -366,10 +389,13 @@ public:
          */
         std::unique_lock<std::mutex> lock (m_mutex);
 
-        return m_deque.size () * sizeof (T) + sizeof (m_deque);
+        return m_memoryUsage + sizeof (m_deque);
     }
 
-    size_t memoryUsage(std::function<size_t(T)> memUsage) const
+    /*!
+     * Walks the whole queue, prefer passing memUsage to the constructor
+     */
+    size_t memoryUsage(const std::function<size_t(const T &)> &memUsage) const
     {
         /*!
          * Aquire the lock
@@ -380,7 +406,7 @@ public:
             m_deque.begin (),
             m_deque.end (),
             sizeof (m_deque),
-            [&memUsage](const auto acc, const auto item)
+            [&memUsage](const size_t acc, const T &item)
             {
 
                 return acc + memUsage (item);
@@ -428,15 +454,14 @@ private:
         }
 
         /*!
-         * Get the first item in the queue
-         */
-        item = m_deque.front ();
-
-        /*!
-         * Remove the first item from the queue
+         * Get the first item in the queue, and remove it if asked
          */
         if (removeFromQueue) {
+            m_memoryUsage -= itemMemoryUsage (m_deque.front ());
+            item = std::move (m_deque.front ());
             m_deque.pop_front ();
+        } else {
+            item = m_deque.front ();
         }
 
         /*!
@@ -453,12 +478,30 @@ private:
         return item;
     }
 
+    /*!
+     * Must be called with the lock held
+     */
+    size_t itemMemoryUsage(const T &item) const
+    {
+        return m_memUsage ? m_memUsage (item) : sizeof (T);
+    }
+
 private:
     /*!
      * The deque data structure
      */
     std::deque<T> m_deque;
 
+    /*!
+     * Gives the memory usage of one item, sizeof (T) is used if not set
+     */
+    std::function<size_t(const T &)> m_memUsage;
+
+    /*!
+     * Running total of itemMemoryUsage over the queue
+     */
+    size_t m_memoryUsage = 0;
+
     /*!
      * The mutex, to ensure we have atomic access to the queue
      */
@@ -23,11 +23,13 @@
 
 #include <algorithm>
 #include <cassert>
+#include <cstring>
 #include <ctime>
 #include <fstream>
 #include <numeric>
 #include <random>
 #include <set>
+#include <sstream>
 #include <tuple>
 #include <utility>
 
@@ -486,8 +488,9 @@ namespace CryptoNote
 
         stopBlockchainSynchronizer();
 
+        std::unique_ptr<ContainerSnapshot> snapshot;
         try {
-            saveWalletCache(m_containerStorage, m_key, saveLevel, extra);
+            snapshot = captureContainerSnapshot(saveLevel, extra);
         }
         catch (const std::exception &e) {
             m_logger(ERROR, BRIGHT_RED)
@@ -498,6 +501,54 @@ namespace CryptoNote
         }
 
         startBlockchainSynchronizer();
+
+        /*!
+         * Serialization and encryption of the snapshot run in a separate thread,
+         * the dispatcher keeps serving other contexts until the new file is written.
+         */
+        const std::string snapshotPath = boost::filesystem::unique_path(m_path + ".%%%%-%%%%.tmp").string();
+        try {
+            System::RemoteContext<void> writeContext(
+                m_dispatcher, [&snapshot, &snapshotPath]()
+                {
+                    writeContainerSnapshot(*snapshot, snapshotPath);
+                }
+            );
+            writeContext.get();
+
+            if (!commitContainerSnapshot(*snapshot, snapshotPath)) {
+                boost::system::error_code ignore;
+                boost::filesystem::remove(snapshotPath, ignore);
+
+                m_logger(DEBUGGING)
+                    << "Container was modified while saving, saving in place";
+
+                throwIfNotInitialized();
+                throwIfStopped();
+
+                stopBlockchainSynchronizer();
+                Tools::ScopeExit startSynchronizer(
+                    [this]
+                    {
+                        startBlockchainSynchronizer();
+                    }
+                );
+
+                saveWalletCache(m_containerStorage, m_key, saveLevel, extra);
+            }
+        }
+        catch (const std::exception &e) {
+            boost::system::error_code ignore;
+            boost::filesystem::remove(snapshotPath, ignore);
+
+            m_logger(ERROR, BRIGHT_RED)
+                << "Failed to save container: "
+                << e.what();
+            throw;
+        }
+
+        m_extra = extra;
+
         m_logger(INFO, BRIGHT_WHITE)
             << "Container saved";
     }
@@ -788,7 +839,42 @@ namespace CryptoNote
 
         WalletTransactions transactions;
         WalletTransfers transfers;
+        filterTransactionsForSave(saveLevel, transactions, transfers);
+
+        std::string containerData;
+        Common::StringOutputStream containerStream(containerData);
+
+        WalletSerializerV2 s(
+            *this,
+            m_viewPublicKey,
+            m_viewSecretKey,
+            m_actualBalance,
+            m_pendingBalance,
+            m_walletsContainer,
+            m_synchronizer,
+            m_unlockTransactionsJob,
+            transactions,
+            transfers,
+            m_uncommitedTransactions,
+            const_cast<std::string &>(extra),
+            m_transactionSoftLockTime
+        );
+
+        s.save(containerStream, saveLevel);
+
+        encryptAndSaveContainerData(storage, key, containerData.data(), containerData.size());
+        storage.flush();
 
+        m_extra = extra;
+
+        m_logger(DEBUGGING)
+            << "Container saving finished";
+    }
+
+    void WalletGreen::filterTransactionsForSave(WalletSaveLevel saveLevel,
+                                                WalletTransactions &transactions,
+                                                WalletTransfers &transfers) const
+    {
         if (saveLevel == WalletSaveLevel::SAVE_KEYS_AND_TRANSACTIONS) {
             filterOutTransactions(
                 transactions, transfers, [](const WalletTransaction &tx)
@@ -815,35 +901,119 @@ namespace CryptoNote
                 }
             );
         }
+    }
+
+    std::unique_ptr<WalletGreen::ContainerSnapshot> WalletGreen::captureContainerSnapshot(WalletSaveLevel saveLevel,
+                                                                                          const std::string &extra)
+    {
+        std::unique_ptr<ContainerSnapshot> snapshot(new ContainerSnapshot());
+
+        snapshot->saveLevel = saveLevel;
+        snapshot->key = m_key;
+        snapshot->prefix = *reinterpret_cast<const ContainerStoragePrefix *>(m_containerStorage.prefix());
+        snapshot->encryptedKeys.assign(m_containerStorage.begin(), m_containerStorage.end());
+        snapshot->viewPublicKey = m_viewPublicKey;
+        snapshot->viewSecretKey = m_viewSecretKey;
+        snapshot->actualBalance = m_actualBalance;
+        snapshot->pendingBalance = m_pendingBalance;
+        snapshot->walletsContainer = m_walletsContainer;
+        snapshot->extra = extra;
+        snapshot->transactionSoftLockTime = m_transactionSoftLockTime;
+
+        filterTransactionsForSave(saveLevel, snapshot->transactions, snapshot->transfers);
+
+        if (saveLevel == WalletSaveLevel::SAVE_ALL) {
+            std::stringstream stream;
+            m_synchronizer.save(stream);
+            snapshot->transfersSynchronizerData = stream.str();
+
+            snapshot->unlockTransactionsJob = m_unlockTransactionsJob;
+            snapshot->uncommitedTransactions = m_uncommitedTransactions;
+        }
+
+        /*!
+         * The snapshot encrypts its data with the current IV, so the live
+         * container must never hand it out again.
+         */
+        incNextIv();
+
+        snapshot->storageNextIv = getNextIv();
+        snapshot->storageSize = m_containerStorage.size();
+
+        m_logger(DEBUGGING)
+            << "Container snapshot captured";
+
+        return snapshot;
+    }
+
+    void WalletGreen::writeContainerSnapshot(ContainerSnapshot &snapshot, const std::string &path)
+    {
+        ContainerStorage storage(path, FileMappedVectorOpenMode::CREATE, sizeof(ContainerStoragePrefix));
+        *reinterpret_cast<ContainerStoragePrefix *>(storage.prefix()) = snapshot.prefix;
+
+        storage.setAutoFlush(false);
+        storage.reserve(snapshot.encryptedKeys.size());
+        for (const auto &encryptedSpendKeys : snapshot.encryptedKeys) {
+            storage.push_back(encryptedSpendKeys);
+        }
 
         std::string containerData;
         Common::StringOutputStream containerStream(containerData);
 
         WalletSerializerV2 s(
-            *this,
-            m_viewPublicKey,
-            m_viewSecretKey,
-            m_actualBalance,
-            m_pendingBalance,
-            m_walletsContainer,
-            m_synchronizer,
-            m_unlockTransactionsJob,
-            transactions,
-            transfers,
-            m_uncommitedTransactions,
-            const_cast<std::string &>(extra),
-            m_transactionSoftLockTime
+            snapshot.viewPublicKey,
+            snapshot.viewSecretKey,
+            snapshot.actualBalance,
+            snapshot.pendingBalance,
+            snapshot.walletsContainer,
+            snapshot.transfersSynchronizerData,
+            snapshot.unlockTransactionsJob,
+            snapshot.transactions,
+            snapshot.transfers,
+            snapshot.uncommitedTransactions,
+            snapshot.extra,
+            snapshot.transactionSoftLockTime
         );
 
-        s.save(containerStream, saveLevel);
+        s.save(containerStream, snapshot.saveLevel);
 
-        encryptAndSaveContainerData(storage, key, containerData.data(), containerData.size());
+        encryptAndSaveContainerData(storage, snapshot.key, containerData.data(), containerData.size());
         storage.flush();
+    }
 
-        m_extra = extra;
+    bool WalletGreen::commitContainerSnapshot(const ContainerSnapshot &snapshot, const std::string &path)
+    {
+        if (m_state != WalletState::INITIALIZED || !m_containerStorage.isOpened()) {
+            return false;
+        }
+
+        Crypto::chacha8IV nextIv = getNextIv();
+        if (m_containerStorage.size() != snapshot.storageSize
+            || std::memcmp(&nextIv, &snapshot.storageNextIv, sizeof(Crypto::chacha8IV)) != 0
+            || std::memcmp(&m_key, &snapshot.key, sizeof(Crypto::chacha8Key)) != 0) {
+            return false;
+        }
+
+        /*!
+         * rename() replaces the container atomically, the old mapping has to be
+         * dropped first and the new file mapped afterwards.
+         */
+        boost::system::error_code ec;
+        m_containerStorage.close();
+        boost::filesystem::rename(path, m_path, ec);
+        m_containerStorage.open(m_path, FileMappedVectorOpenMode::OPEN, sizeof(ContainerStoragePrefix));
+
+        if (ec) {
+            m_logger(ERROR, BRIGHT_RED)
+                << "Failed to replace container with snapshot: "
+                << ec.message();
+            throw std::system_error(make_error_code(error::INTERNAL_WALLET_ERROR), ec.message());
+        }
 
         m_logger(DEBUGGING)
-            << "Container saving finished";
+            << "Container snapshot committed";
+
+        return true;
     }
 
     void WalletGreen::copyContainerStorageKeys(ContainerStorage &src,
@@ -1318,17 +1488,20 @@ namespace CryptoNote
         try {
 
             {
+                /*!
+                 * One resize up front and one sync at the end, instead of
+                 * growing and syncing the container for every address
+                 */
                 if (addressDataList.size() > 1) {
-                    m_containerStorage.setAutoFlush(false);
+                    m_containerStorage.reserve(m_containerStorage.size() + addressDataList.size());
                 }
 
+                m_containerStorage.beginGroup();
+
                 Tools::ScopeExit exitHandler(
                     [this]
                     {
-                        if (!m_containerStorage.getAutoFlush()) {
-                            m_containerStorage.setAutoFlush(true);
-                            m_containerStorage.flush();
-                        }
+                        m_containerStorage.commitGroup();
                     }
                 );
 
@@ -1343,8 +1516,6 @@ namespace CryptoNote
                 }
             }
 
-            m_containerStorage.setAutoFlush(true);
-
             if (resetRequired) {
                 m_logger(DEBUGGING)
                     << "A reset is required to scan from this new lower "
@@ -247,6 +247,37 @@ namespace CryptoNote {
         };
 #pragma pack(pop)
 
+        /*!
+            Immutable copy of everything needed to write the container, captured on the
+            dispatcher so that serialization and encryption can run in another thread.
+        */
+        struct ContainerSnapshot
+        {
+            WalletSaveLevel saveLevel;
+            Crypto::chacha8Key key;
+            ContainerStoragePrefix prefix;
+            std::vector<EncryptedWalletRecord> encryptedKeys;
+            Crypto::PublicKey viewPublicKey;
+            Crypto::SecretKey viewSecretKey;
+            uint64_t actualBalance;
+            uint64_t pendingBalance;
+            WalletsContainer walletsContainer;
+            UnlockTransactionJobs unlockTransactionsJob;
+            WalletTransactions transactions;
+            WalletTransfers transfers;
+            UncommitedTransactions uncommitedTransactions;
+            std::string transfersSynchronizerData;
+            std::string extra;
+            uint32_t transactionSoftLockTime;
+
+            /*!
+                State of the live container right after the capture. If it differs when
+                the snapshot is written, the container was modified meanwhile.
+            */
+            Crypto::chacha8IV storageNextIv;
+            uint64_t storageSize;
+        };
+
         typedef std::unordered_map<std::string, AddressAmounts> TransfersMap;
 
         virtual void onError(ITransfersSubscription *object, uint32_t height, std::error_code ec) override;
@@ -448,6 +479,13 @@ namespace CryptoNote {
                              const Crypto::chacha8Key &key,
                              WalletSaveLevel saveLevel,
                              const std::string &extra);
+        void filterTransactionsForSave(WalletSaveLevel saveLevel,
+                                       WalletTransactions &transactions,
+                                       WalletTransfers &transfers) const;
+        std::unique_ptr<ContainerSnapshot> captureContainerSnapshot(WalletSaveLevel saveLevel,
+                                                                    const std::string &extra);
+        static void writeContainerSnapshot(ContainerSnapshot &snapshot, const std::string &path);
+        bool commitContainerSnapshot(const ContainerSnapshot &snapshot, const std::string &path);
         void subscribeWallets();
 
         std::vector<OutputToTransfer> pickRandomFusionInputs(const std::vector<std::string> &addresses,
@@ -147,7 +147,33 @@ namespace CryptoNote {
         : m_actualBalance (actualBalance),
           m_pendingBalance (pendingBalance),
           m_walletsContainer (walletsContainer),
-          m_synchronizer (synchronizer),
+          m_synchronizer (&synchronizer),
+          m_unlockTransactions (unlockTransactions),
+          m_transactions (transactions),
+          m_transfers (transfers),
+          m_uncommitedTransactions (uncommitedTransactions),
+          m_extra (extra)
+    {
+    }
+
+    WalletSerializerV2::WalletSerializerV2(Crypto::PublicKey &viewPublicKey,
+                                           Crypto::SecretKey &viewSecretKey,
+                                           uint64_t &actualBalance,
+                                           uint64_t &pendingBalance,
+                                           WalletsContainer &walletsContainer,
+                                           const std::string &transfersSynchronizerData,
+                                           UnlockTransactionJobs &unlockTransactions,
+                                           WalletTransactions &transactions,
+                                           WalletTransfers &transfers,
+                                           UncommitedTransactions &uncommitedTransactions,
+                                           std::string &extra,
+                                           uint32_t transactionSoftLockTime
+    )
+        : m_actualBalance (actualBalance),
+          m_pendingBalance (pendingBalance),
+          m_walletsContainer (walletsContainer),
+          m_synchronizer (nullptr),
+          m_transfersSynchronizerData (transfersSynchronizerData),
           m_unlockTransactions (unlockTransactions),
           m_transactions (transactions),
           m_transfers (transfers),
@@ -158,6 +184,8 @@ namespace CryptoNote {
 
     void WalletSerializerV2::load(Common::IInputStream &source, uint8_t version)
     {
+        assert (m_synchronizer != nullptr);
+
         CryptoNote::BinaryInputStreamSerializer s (source);
 
         uint8_t saveLevelValue;
@@ -357,13 +385,18 @@ namespace CryptoNote {
         serializer (transfersSynchronizerData, "transfersSynchronizer");
 
         std::stringstream stream (transfersSynchronizerData);
-        m_synchronizer.load (stream);
+        m_synchronizer->load (stream);
     }
 
     void WalletSerializerV2::saveTransfersSynchronizer(CryptoNote::ISerializer &serializer)
     {
+        if (m_synchronizer == nullptr) {
+            serializer (m_transfersSynchronizerData, "transfersSynchronizer");
+            return;
+        }
+
         std::stringstream stream;
-        m_synchronizer.save (stream);
+        m_synchronizer->save (stream);
         stream.flush ();
 
         std::string transfersSynchronizerData = stream.str ();
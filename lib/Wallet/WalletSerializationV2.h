@@ -47,6 +47,24 @@ namespace CryptoNote {
                            uint32_t transactionSoftLockTime
         );
 
+        /*!
+            Save-only serializer for container snapshots. Transfers synchronizer state is
+            passed already serialized, so the live synchronizer is never touched.
+        */
+        WalletSerializerV2(Crypto::PublicKey &viewPublicKey,
+                           Crypto::SecretKey &viewSecretKey,
+                           uint64_t &actualBalance,
+                           uint64_t &pendingBalance,
+                           WalletsContainer &walletsContainer,
+                           const std::string &transfersSynchronizerData,
+                           UnlockTransactionJobs &unlockTransactions,
+                           WalletTransactions &transactions,
+                           WalletTransfers &transfers,
+                           UncommitedTransactions &uncommitedTransactions,
+                           std::string &extra,
+                           uint32_t transactionSoftLockTime
+        );
+
         void load(Common::IInputStream &source, uint8_t version);
         void save(Common::IOutputStream &destination, WalletSaveLevel saveLevel);
 
@@ -75,7 +93,8 @@ namespace CryptoNote {
         uint64_t &m_actualBalance;
         uint64_t &m_pendingBalance;
         WalletsContainer &m_walletsContainer;
-        TransfersSyncronizer &m_synchronizer;
+        TransfersSyncronizer *m_synchronizer;
+        std::string m_transfersSynchronizerData;
         UnlockTransactionJobs &m_unlockTransactions;
         WalletTransactions &m_transactions;
         WalletTransfers &m_transfers;
@@ -145,10 +145,7 @@ void BlockDownloader::downloader()
 
 bool BlockDownloader::shouldFetchMoreBlocks() const
 {
-    size_t ramUsage = m_storedBlocks.memoryUsage ([](const auto block)
-                                                  {
-                                                      return std::get<0> (block).memoryUsage ();
-                                                  });
+    const size_t ramUsage = m_storedBlocks.memoryUsage ();
 
     if (ramUsage + WalletConfig::maxBodyResponseSize < WalletConfig::blockStoreMemoryLimit) {
         std::stringstream stream;
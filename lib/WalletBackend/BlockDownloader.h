@@ -127,9 +127,15 @@ private:
     bool downloadBlocks();
 
     /*!
-     * Cached blocks
-     */
-    ThreadSafeDeque <std::tuple<WalletTypes::WalletBlockInfo, uint32_t>> m_storedBlocks;
+     * Cached blocks, keeping a running total of their memory usage
+     */
+    ThreadSafeDeque <std::tuple<WalletTypes::WalletBlockInfo, uint32_t>> m_storedBlocks {
+        [](const std::tuple<WalletTypes::WalletBlockInfo, uint32_t> &block)
+        {
+            return std::get<0> (block).memoryUsage ();
+        },
+        false
+    };
 
     /*!
      * The daemon connection
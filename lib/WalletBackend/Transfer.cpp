@@ -24,6 +24,7 @@
 #include <Utilities/Addresses.h>
 #include <Utilities/FormatTools.h>
 #include <Utilities/Mixins.h>
+#include <Utilities/ParallelFor.h>
 #include <Utilities/Utilities.h>
 
 #include <WalletBackend/Transfer.h>
@@ -933,20 +934,33 @@ namespace SendTransaction {
     setupInputs(const std::vector <WalletTypes::ObscuredInput> inputsAndFakes,
                 const Crypto::SecretKey privateViewKey)
     {
-        std::vector <CryptoNote::KeyInput> inputs;
+        std::vector <CryptoNote::KeyInput> inputs (inputsAndFakes.size ());
 
-        std::vector <Crypto::SecretKey> tmpSecretKeys;
+        std::vector <Crypto::SecretKey> tmpSecretKeys (inputsAndFakes.size ());
+
+        /*!
+         * Not a vector<bool> - each worker writes its own element
+         */
+        std::vector <uint8_t> validKeyImages (inputsAndFakes.size (), false);
+
+        /*!
+         * Deriving the keys dominates for fusions and sweeps, and every input
+         * is independent, so spread them over our cores. Each input writes
+         * only to its own slot, so the result is the same as doing it in order
+         */
+        Utilities::parallelFor (inputsAndFakes.size (), [&](const size_t i)
+        {
+            const auto &input = inputsAndFakes[i];
 
-        for (const auto input : inputsAndFakes) {
             const auto[tmpKeyPair, keyImage] = genKeyImage (input, privateViewKey);
 
             if (tmpKeyPair.publicKey != input.outputs[input.realOutput].key) {
-                return {INVALID_GENERATED_KEYIMAGE, inputs, tmpSecretKeys};
+                return;
             }
 
-            tmpSecretKeys.push_back (tmpKeyPair.secretKey);
+            tmpSecretKeys[i] = tmpKeyPair.secretKey;
 
-            CryptoNote::KeyInput keyInput;
+            CryptoNote::KeyInput &keyInput = inputs[i];
 
             keyInput.amount = input.amount;
             keyInput.keyImage = keyImage;
@@ -970,17 +984,20 @@ namespace SendTransaction {
                  * [5, 5, 10, 1, 1]. Due to this, the indexes MUST be sorted - they
                  * are serialized as a uint32_t, so negative values will overflow!
                  */
-                for (size_t i = 1; i < copy.size (); i++) {
-                    copy[i] = keyInput.outputIndexes[i] - keyInput.outputIndexes[i - 1];
+                for (size_t j = 1; j < copy.size (); j++) {
+                    copy[j] = keyInput.outputIndexes[j] - keyInput.outputIndexes[j - 1];
                 }
 
                 keyInput.outputIndexes = copy;
             }
 
-            /*!
-             * Store the key input
-             */
-            inputs.push_back (keyInput);
+            validKeyImages[i] = true;
+        });
+
+        for (const auto valid : validKeyImages) {
+            if (!valid) {
+                return {INVALID_GENERATED_KEYIMAGE, {}, {}};
+            }
         }
 
         return {SUCCESS, inputs, tmpSecretKeys};
@@ -1052,18 +1069,29 @@ namespace SendTransaction {
          */
         Crypto::Hash txPrefixHash = getTransactionHash (static_cast<CryptoNote::TransactionPrefix>(tx));
 
-        size_t i = 0;
+        tx.signatures.resize (inputsAndFakes.size ());
+
+        std::vector <uint8_t> validSignatures (inputsAndFakes.size (), false);
 
         /*!
-         * Add the transaction signatures
+         * Sign and verify each input on its own worker. Every input only touches
+         * its own signature slot, so the order of tx.signatures matches
+         * tx.inputs regardless of which worker finishes first
          */
-        for (const auto input : inputsAndFakes) {
+        Utilities::parallelFor (inputsAndFakes.size (), [&](const size_t i)
+        {
+            const auto &input = inputsAndFakes[i];
+
+            const Crypto::KeyImage keyImage = boost::get<CryptoNote::KeyInput> (tx.inputs[i]).keyImage;
+
             std::vector <Crypto::PublicKey> publicKeys;
 
+            publicKeys.reserve (input.outputs.size ());
+
             /*!
              * Add all the fake outs public keys to a vector
              */
-            for (const auto output : input.outputs) {
+            for (const auto &output : input.outputs) {
                 publicKeys.push_back (output.key);
             }
 
@@ -1072,42 +1100,28 @@ namespace SendTransaction {
              * post signature generation will invalidate the signatures.
              */
             const auto[success, signatures] = Crypto::CryptoOps::generateRingSignatures (txPrefixHash,
-                                                                                         boost::get<CryptoNote::KeyInput> (
-                                                                                             tx.inputs[i]).keyImage,
+                                                                                         keyImage,
                                                                                          publicKeys,
                                                                                          tmpSecretKeys[i],
                                                                                          input.realOutput);
 
-            if (!success) {
-                return {FAILED_TO_CREATE_RING_SIGNATURE, tx};
+            if (!success
+                || !Crypto::CryptoOps::checkRingSignature (txPrefixHash, keyImage, publicKeys, signatures)) {
+                return;
             }
 
             /*!
              * Add the signatures to the transaction
              */
-            tx.signatures.push_back (signatures);
-
-            i++;
-        }
-
-        i = 0;
+            tx.signatures[i] = signatures;
 
-        for (const auto input: inputsAndFakes) {
-            std::vector <Crypto::PublicKey> publicKeys;
-
-            for (const auto output : input.outputs) {
-                publicKeys.push_back (output.key);
-            }
+            validSignatures[i] = true;
+        });
 
-            if (!Crypto::CryptoOps::checkRingSignature (
-                txPrefixHash,
-                boost::get<CryptoNote::KeyInput> (tx.inputs[i]).keyImage,
-                publicKeys,
-                tx.signatures[i])) {
+        for (const auto valid : validSignatures) {
+            if (!valid) {
                 return {FAILED_TO_CREATE_RING_SIGNATURE, tx};
             }
-
-            i++;
         }
 
         return {SUCCESS, tx};
@@ -19,6 +19,7 @@
 
 #include <iostream>
 #include <chrono>
+#include <vector>
 #include <assert.h>
 
 #include <cxxopts.hpp>
@@ -28,6 +29,7 @@
 #include <CryptoTypes.h>
 #include <Common/StringTools.h>
 #include <Crypto/Crypto.h>
+#include <Utilities/ParallelFor.h>
 
 #define PERFORMANCE_ITERATIONS  1000
 #define PERFORMANCE_ITERATIONS_LONG_MULTIPLIER 10
@@ -216,6 +218,81 @@ void benchmarkGenerateKeyDerivation()
         << std::endl;
 }
 
+/* Signs a transaction with the given number of inputs the way the wallet
+   does, once input by input and once spread over all cores */
+void benchmarkRingSignatures(const size_t inputCount)
+{
+    /* Mixin 3 */
+    const size_t ringSize = 4;
+
+    const uint64_t loopIterations = 10;
+
+    Crypto::Hash prefixHash;
+    Crypto::CnFastHash (INPUT_DATA.data (), INPUT_DATA.size (), prefixHash);
+
+    std::vector<std::vector<Crypto::PublicKey>> rings (inputCount);
+    std::vector<Crypto::SecretKey> secretKeys (inputCount);
+    std::vector<Crypto::KeyImage> keyImages (inputCount);
+    std::vector<uint64_t> realOutputs (inputCount);
+
+    for (size_t i = 0; i < inputCount; i++) {
+        realOutputs[i] = i % ringSize;
+
+        for (size_t j = 0; j < ringSize; j++) {
+            Crypto::PublicKey publicKey;
+            Crypto::SecretKey secretKey;
+            Crypto::generateKeys (publicKey, secretKey);
+
+            if (j == realOutputs[i]) {
+                secretKeys[i] = secretKey;
+                Crypto::generateKeyImage (publicKey, secretKey, keyImages[i]);
+            }
+
+            rings[i].push_back (publicKey);
+        }
+    }
+
+    std::vector<std::vector<Crypto::Signature>> signatures (inputCount);
+
+    auto signInput = [&](const size_t i)
+    {
+        signatures[i] = std::get<1> (Crypto::CryptoOps::generateRingSignatures (
+            prefixHash, keyImages[i], rings[i], secretKeys[i], realOutputs[i]
+        ));
+    };
+
+    auto startTimer = std::chrono::high_resolution_clock::now ();
+
+    for (uint64_t i = 0; i < loopIterations; i++) {
+        for (size_t j = 0; j < inputCount; j++) {
+            signInput (j);
+        }
+    }
+
+    const auto sequentialTime = std::chrono::high_resolution_clock::now () - startTimer;
+
+    startTimer = std::chrono::high_resolution_clock::now ();
+
+    for (uint64_t i = 0; i < loopIterations; i++) {
+        Utilities::parallelFor (inputCount, signInput);
+    }
+
+    const auto parallelTime = std::chrono::high_resolution_clock::now () - startTimer;
+
+    /* Make sure the parallel run produced usable signatures */
+    for (size_t i = 0; i < inputCount; i++) {
+        assert (Crypto::CryptoOps::checkRingSignature (prefixHash, keyImages[i], rings[i], signatures[i]));
+    }
+
+    std::cout
+        << "Time to sign " << inputCount << " input(s): "
+        << std::chrono::duration_cast<std::chrono::microseconds> (sequentialTime).count () / loopIterations / 1000.0
+        << " ms sequential, "
+        << std::chrono::duration_cast<std::chrono::microseconds> (parallelTime).count () / loopIterations / 1000.0
+        << " ms parallel"
+        << std::endl;
+}
+
 int main(int argc, char **argv)
 {
     bool o_help, o_version, o_benchmark;
@@ -299,6 +376,10 @@ int main(int argc, char **argv)
             benchmarkUnderivePublicKey ();
             benchmarkGenerateKeyDerivation ();
 
+            for (const size_t inputCount : {1, 10, 100}) {
+                benchmarkRingSignatures (inputCount);
+            }
+
             BENCHMARK(CnSlowHashV0, o_iterations);
         }
     } catch (std::exception &e) {
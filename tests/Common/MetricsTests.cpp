@@ -0,0 +1,128 @@
+// Copyright (c) 2018-2020, The Qwertycoin Project
+//
+// This file is part of Qwertycoin.
+//
+// Qwertycoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Qwertycoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Qwertycoin.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include <Common/Metrics.h>
+
+using namespace Metrics;
+
+namespace {
+
+    /*!
+        the registry is process wide, so every test uses metric names of its own
+    */
+    bool contains(const std::string &text, const std::string &line)
+    {
+        return text.find (line + "\n") != std::string::npos;
+    }
+
+} // namespace
+
+TEST(MetricsTest, countersAndGaugesAreExportedWithHelpTypeAndLabels)
+{
+    auto &registry = Registry::instance ();
+
+    registry.counter ("test_messages_total", "Messages seen", "kind", "ping").inc ();
+    registry.counter ("test_messages_total", "Messages seen", "kind", "ping").inc (2);
+    registry.counter ("test_messages_total", "Messages seen", "kind", "pong").inc ();
+    registry.gauge ("test_queue_length", "Queued items").set (7);
+    registry.gauge ("test_queue_length", "Queued items").add (-2);
+
+    const std::string text = registry.toPrometheus ();
+
+    EXPECT_TRUE(contains (text, "# HELP test_messages_total Messages seen"));
+    EXPECT_TRUE(contains (text, "# TYPE test_messages_total counter"));
+    EXPECT_TRUE(contains (text, "test_messages_total{kind=\"ping\"} 3"));
+    EXPECT_TRUE(contains (text, "test_messages_total{kind=\"pong\"} 1"));
+    EXPECT_TRUE(contains (text, "# TYPE test_queue_length gauge"));
+    EXPECT_TRUE(contains (text, "test_queue_length 5"));
+}
+
+TEST(MetricsTest, labelValuesAreEscaped)
+{
+    auto &registry = Registry::instance ();
+
+    registry.counter ("test_escaped_total", "Escaping", "path", "a\"b\\c\nd").inc ();
+
+    EXPECT_TRUE(contains (registry.toPrometheus (), "test_escaped_total{path=\"a\\\"b\\\\c\\nd\"} 1"));
+}
+
+TEST(MetricsTest, reregisteringWithAnotherTypeOrLabelThrows)
+{
+    auto &registry = Registry::instance ();
+
+    registry.counter ("test_conflict", "Conflict", "kind", "a");
+
+    EXPECT_THROW(registry.gauge ("test_conflict", "Conflict", "kind", "a"), std::invalid_argument);
+    EXPECT_THROW(registry.counter ("test_conflict", "Conflict", "other", "a"), std::invalid_argument);
+    EXPECT_NO_THROW(registry.counter ("test_conflict", "Conflict", "kind", "b"));
+}
+
+TEST(MetricsTest, bucketsSplitEveryPowerOfTwoInFour)
+{
+    EXPECT_EQ(1, Histogram::bucketUpperBound (0));
+    EXPECT_EQ(4, Histogram::bucketUpperBound (3));
+    EXPECT_EQ(5, Histogram::bucketUpperBound (4));
+    EXPECT_EQ(8, Histogram::bucketUpperBound (7));
+    EXPECT_EQ(10, Histogram::bucketUpperBound (8));
+    EXPECT_EQ(uint64_t (1) << Histogram::MAX_EXPONENT, Histogram::bucketUpperBound (Histogram::BUCKET_COUNT - 2));
+
+    for (size_t i = 1; i < Histogram::BUCKET_COUNT - 1; ++i) {
+        const uint64_t lower = Histogram::bucketUpperBound (i - 1);
+        const uint64_t upper = Histogram::bucketUpperBound (i);
+
+        ASSERT_LT(lower, upper);
+        EXPECT_LE((upper - lower) * 4, std::max<uint64_t> (lower, 4));
+        EXPECT_EQ(i, Histogram::bucketIndex (upper));
+        EXPECT_EQ(i, Histogram::bucketIndex (lower + 1));
+    }
+
+    EXPECT_EQ(0, Histogram::bucketIndex (0));
+    EXPECT_EQ(Histogram::BUCKET_COUNT - 1, Histogram::bucketIndex ((uint64_t (1) << Histogram::MAX_EXPONENT) + 1));
+    EXPECT_EQ(Histogram::BUCKET_COUNT - 1, Histogram::bucketIndex (UINT64_MAX));
+}
+
+TEST(MetricsTest, histogramsAreExportedCumulativeInSeconds)
+{
+    auto &registry = Registry::instance ();
+    auto &histogram = registry.histogram ("test_duration_seconds", "Durations", "step", "a");
+
+    histogram.observe (std::chrono::microseconds (3));
+    histogram.observe (std::chrono::microseconds (9));
+    histogram.observe (std::chrono::microseconds (10));
+    histogram.observe (std::chrono::seconds (60));
+
+    const std::string text = registry.toPrometheus ();
+
+    EXPECT_TRUE(contains (text, "# TYPE test_duration_seconds histogram"));
+    EXPECT_TRUE(contains (text, "test_duration_seconds_bucket{step=\"a\",le=\"2e-06\"} 0"));
+    EXPECT_TRUE(contains (text, "test_duration_seconds_bucket{step=\"a\",le=\"3e-06\"} 1"));
+    EXPECT_TRUE(contains (text, "test_duration_seconds_bucket{step=\"a\",le=\"8e-06\"} 1"));
+    EXPECT_TRUE(contains (text, "test_duration_seconds_bucket{step=\"a\",le=\"1e-05\"} 3"));
+    EXPECT_TRUE(contains (text, "test_duration_seconds_bucket{step=\"a\",le=\"33.554432\"} 3"));
+    EXPECT_TRUE(contains (text, "test_duration_seconds_bucket{step=\"a\",le=\"+Inf\"} 4"));
+    EXPECT_TRUE(contains (text, "test_duration_seconds_sum{step=\"a\"} 60.000022"));
+    EXPECT_TRUE(contains (text, "test_duration_seconds_count{step=\"a\"} 4"));
+}
@@ -0,0 +1,378 @@
+// Copyright (c) 2018-2020, The Qwertycoin Project
+//
+// This file is part of Qwertycoin.
+//
+// Qwertycoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Qwertycoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Qwertycoin.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <Common/FileSystemShim.h>
+
+#include <CryptoNoteCore/Blockchain/BlockchainReadBatch.h>
+#include <CryptoNoteCore/Blockchain/BlockchainWriteBatch.h>
+#include <CryptoNoteCore/Database/DatabaseConfig.h>
+#include <CryptoNoteCore/Database/LmDBWrapper.h>
+
+#include <Logging/DummyLogger.h>
+
+using namespace CryptoNote;
+
+namespace {
+
+    const IBlockchainCache::Amount AMOUNT = 1000000;
+    const IBlockchainCache::Amount OTHER_AMOUNT = 2000000;
+
+    class BlockchainBatchTest: public ::testing::Test
+    {
+    protected:
+        void SetUp() override
+        {
+            directory = fs::path (testing::TempDir ()) / fs::unique_path ();
+            fs::create_directories (directory);
+            config.init (directory.string (), 0, 0, 0, 0);
+            open ();
+        }
+
+        void TearDown() override
+        {
+            database->shutdown ();
+            database.reset ();
+            fs::remove_all (directory);
+        }
+
+        void open()
+        {
+            database = std::make_unique<LmDBWrapper> (std::make_shared<Logging::DummyLogger> ());
+            database->init (config);
+        }
+
+        void reopen()
+        {
+            database->shutdown ();
+            database.reset ();
+            open ();
+        }
+
+        void write(BlockchainWriteBatch &batch)
+        {
+            ASSERT_FALSE(database->write (batch));
+        }
+
+        BlockchainReadResult read(BlockchainReadBatch &batch)
+        {
+            EXPECT_FALSE(database->read (batch));
+            return batch.extractResult ();
+        }
+
+        std::pair<uint32_t, bool> readNonEmptyBlocksCount()
+        {
+            BlockchainReadBatch batch;
+            batch.requestNonEmptyBlocksCount ();
+            return read (batch).getNonEmptyBlocksCount ();
+        }
+
+        /*!
+            reads from a thread which doesn't own the bulk write transaction
+        */
+        std::pair<uint32_t, bool> readNonEmptyBlocksCountElsewhere()
+        {
+            std::pair<uint32_t, bool> count;
+            std::thread reader ([this, &count]()
+                                {
+                                    count = readNonEmptyBlocksCount ();
+                                });
+            reader.join ();
+
+            return count;
+        }
+
+        fs::path directory;
+        DataBaseConfig config;
+        std::unique_ptr<LmDBWrapper> database;
+    };
+
+} // namespace
+
+TEST_F(BlockchainBatchTest, keyOutputBlockCountsAreAppendedPerAmount)
+{
+    BlockchainWriteBatch first;
+    first.insertKeyOutputBlockCounts (AMOUNT, {{10, 2}, {11, 5}, {15, 6}}, 3);
+    first.insertKeyOutputBlockCounts (OTHER_AMOUNT, {{11, 1}}, 1);
+    write (first);
+
+    BlockchainWriteBatch second;
+    second.insertKeyOutputBlockCounts (AMOUNT, {{20, 9}, {21, 12}}, 5);
+    write (second);
+
+    BlockchainReadBatch batch;
+    batch.requestKeyOutputBlockCountsCountForAmount (AMOUNT);
+    batch.requestKeyOutputBlockCountsCountForAmount (OTHER_AMOUNT);
+    for (uint32_t i = 0; i < 5; ++i) {
+        batch.requestKeyOutputBlockCountForAmount (AMOUNT, i);
+    }
+    batch.requestKeyOutputBlockCountForAmount (OTHER_AMOUNT, 0);
+
+    const BlockchainReadResult result = read (batch);
+
+    EXPECT_EQ(5, result.getKeyOutputBlockCountsCountForAmounts ().at (AMOUNT));
+    EXPECT_EQ(1, result.getKeyOutputBlockCountsCountForAmounts ().at (OTHER_AMOUNT));
+
+    const auto &blockCounts = result.getKeyOutputBlockCountsForAmounts ();
+    const std::vector<KeyOutputBlockCount> expected = {{10, 2}, {11, 5}, {15, 6}, {20, 9}, {21, 12}};
+    for (uint32_t i = 0; i < expected.size (); ++i) {
+        const KeyOutputBlockCount &blockCount = blockCounts.at ({AMOUNT, i});
+        EXPECT_EQ(expected[i].blockIndex, blockCount.blockIndex);
+        EXPECT_EQ(expected[i].outputsCount, blockCount.outputsCount);
+    }
+
+    EXPECT_EQ(11, (blockCounts.at ({OTHER_AMOUNT, 0}).blockIndex));
+    EXPECT_EQ(1, (blockCounts.at ({OTHER_AMOUNT, 0}).outputsCount));
+}
+
+TEST_F(BlockchainBatchTest, removingKeyOutputBlockCountsTrimsTheTail)
+{
+    BlockchainWriteBatch insert;
+    insert.insertKeyOutputBlockCounts (AMOUNT, {{10, 2}, {11, 5}, {15, 6}, {20, 9}}, 4);
+    insert.insertKeyOutputBlockCounts (OTHER_AMOUNT, {{11, 1}, {20, 3}}, 2);
+    write (insert);
+
+    BlockchainWriteBatch remove;
+    remove.removeKeyOutputBlockCounts (AMOUNT, 2, 2);
+    write (remove);
+
+    reopen ();
+
+    BlockchainReadBatch batch;
+    batch.requestKeyOutputBlockCountsCountForAmount (AMOUNT);
+    batch.requestKeyOutputBlockCountsCountForAmount (OTHER_AMOUNT);
+    for (uint32_t i = 0; i < 4; ++i) {
+        batch.requestKeyOutputBlockCountForAmount (AMOUNT, i);
+    }
+    batch.requestKeyOutputBlockCountForAmount (OTHER_AMOUNT, 1);
+
+    const BlockchainReadResult result = read (batch);
+
+    EXPECT_EQ(2, result.getKeyOutputBlockCountsCountForAmounts ().at (AMOUNT));
+    EXPECT_EQ(2, result.getKeyOutputBlockCountsCountForAmounts ().at (OTHER_AMOUNT));
+
+    const auto &blockCounts = result.getKeyOutputBlockCountsForAmounts ();
+    EXPECT_EQ(5, (blockCounts.at ({AMOUNT, 1}).outputsCount));
+    EXPECT_EQ(0, (blockCounts.count ({AMOUNT, 2})));
+    EXPECT_EQ(0, (blockCounts.count ({AMOUNT, 3})));
+    EXPECT_EQ(3, (blockCounts.at ({OTHER_AMOUNT, 1}).outputsCount));
+}
+
+TEST_F(BlockchainBatchTest, lockedKeyOutputsRoundTripAndTrim)
+{
+    BlockchainWriteBatch insert;
+    insert.insertLockedKeyOutputs (AMOUNT, {{3, 500}, {7, 1700000000}}, 2);
+    write (insert);
+
+    BlockchainWriteBatch append;
+    append.insertLockedKeyOutputs (AMOUNT, {{12, UINT64_MAX}}, 3);
+    write (append);
+
+    {
+        BlockchainReadBatch batch;
+        batch.requestLockedKeyOutputsCountForAmount (AMOUNT);
+        batch.requestLockedKeyOutputsCountForAmount (OTHER_AMOUNT);
+        for (uint32_t i = 0; i < 3; ++i) {
+            batch.requestLockedKeyOutputForAmount (AMOUNT, i);
+        }
+
+        const BlockchainReadResult result = read (batch);
+
+        EXPECT_EQ(3, result.getLockedKeyOutputsCountForAmounts ().at (AMOUNT));
+        EXPECT_EQ(0, result.getLockedKeyOutputsCountForAmounts ().count (OTHER_AMOUNT));
+
+        const auto &lockedOutputs = result.getLockedKeyOutputsForAmounts ();
+        EXPECT_EQ(3, (lockedOutputs.at ({AMOUNT, 0}).globalIndex));
+        EXPECT_EQ(500, (lockedOutputs.at ({AMOUNT, 0}).unlockTime));
+        EXPECT_EQ(7, (lockedOutputs.at ({AMOUNT, 1}).globalIndex));
+        EXPECT_EQ(1700000000, (lockedOutputs.at ({AMOUNT, 1}).unlockTime));
+        EXPECT_EQ(12, (lockedOutputs.at ({AMOUNT, 2}).globalIndex));
+        EXPECT_EQ(UINT64_MAX, (lockedOutputs.at ({AMOUNT, 2}).unlockTime));
+    }
+
+    BlockchainWriteBatch remove;
+    remove.removeLockedKeyOutputs (AMOUNT, 1, 2);
+    write (remove);
+
+    BlockchainReadBatch batch;
+    batch.requestLockedKeyOutputsCountForAmount (AMOUNT);
+    batch.requestLockedKeyOutputForAmount (AMOUNT, 1);
+    batch.requestLockedKeyOutputForAmount (AMOUNT, 2);
+
+    const BlockchainReadResult result = read (batch);
+
+    EXPECT_EQ(2, result.getLockedKeyOutputsCountForAmounts ().at (AMOUNT));
+    EXPECT_EQ(7, (result.getLockedKeyOutputsForAmounts ().at ({AMOUNT, 1}).globalIndex));
+    EXPECT_EQ(0, (result.getLockedKeyOutputsForAmounts ().count ({AMOUNT, 2})));
+}
+
+TEST_F(BlockchainBatchTest, nonEmptyBlockIndexesAreAppendedAndTrimmed)
+{
+    BlockchainWriteBatch first;
+    first.insertNonEmptyBlockIndexes ({0, 4, 5}, 3);
+    write (first);
+
+    BlockchainWriteBatch second;
+    second.insertNonEmptyBlockIndexes ({9, 300}, 5);
+    write (second);
+
+    {
+        BlockchainReadBatch batch;
+        batch.requestNonEmptyBlocksCount ();
+        for (uint32_t i = 0; i < 5; ++i) {
+            batch.requestNonEmptyBlockIndex (i);
+        }
+
+        const BlockchainReadResult result = read (batch);
+
+        ASSERT_TRUE(result.getNonEmptyBlocksCount ().second);
+        EXPECT_EQ(5, result.getNonEmptyBlocksCount ().first);
+
+        const std::vector<uint32_t> expected = {0, 4, 5, 9, 300};
+        for (uint32_t i = 0; i < expected.size (); ++i) {
+            EXPECT_EQ(expected[i], result.getNonEmptyBlockIndexes ().at (i));
+        }
+    }
+
+    BlockchainWriteBatch remove;
+    remove.removeNonEmptyBlockIndexes (2, 3);
+    write (remove);
+
+    reopen ();
+
+    BlockchainReadBatch batch;
+    batch.requestNonEmptyBlocksCount ();
+    batch.requestNonEmptyBlockIndex (2);
+    batch.requestNonEmptyBlockIndex (3);
+    batch.requestNonEmptyBlockIndex (4);
+
+    const BlockchainReadResult result = read (batch);
+
+    EXPECT_EQ(3, result.getNonEmptyBlocksCount ().first);
+    EXPECT_EQ(5, result.getNonEmptyBlockIndexes ().at (2));
+    EXPECT_EQ(0, result.getNonEmptyBlockIndexes ().count (3));
+    EXPECT_EQ(0, result.getNonEmptyBlockIndexes ().count (4));
+}
+
+TEST_F(BlockchainBatchTest, missingNonEmptyBlockIndexIsReportedAsAbsent)
+{
+    /*!
+        loading the index at init reads a missing count as an empty index
+    */
+    BlockchainReadBatch batch;
+    batch.requestNonEmptyBlocksCount ();
+    batch.requestNonEmptyBlockIndex (0);
+
+    const BlockchainReadResult result = read (batch);
+
+    EXPECT_FALSE(result.getNonEmptyBlocksCount ().second);
+    EXPECT_TRUE(result.getNonEmptyBlockIndexes ().empty ());
+}
+
+TEST_F(BlockchainBatchTest, bulkWritesAreVisibleToTheirOwnerBeforeTheCommit)
+{
+    database->beginBulkWrite ();
+
+    BlockchainWriteBatch batch;
+    batch.insertNonEmptyBlockIndexes ({1, 2}, 2);
+    write (batch);
+
+    EXPECT_GT(database->getBulkWriteSize (), 0);
+    EXPECT_EQ(2, readNonEmptyBlocksCount ().first);
+    EXPECT_FALSE(readNonEmptyBlocksCountElsewhere ().second);
+
+    database->commitBulkWrite ();
+
+    EXPECT_EQ(0, database->getBulkWriteSize ());
+    EXPECT_EQ(2, readNonEmptyBlocksCountElsewhere ().first);
+
+    /*!
+        the commit started the next bulk transaction right away
+    */
+    BlockchainWriteBatch next;
+    next.insertNonEmptyBlockIndexes ({3}, 3);
+    write (next);
+
+    EXPECT_EQ(2, readNonEmptyBlocksCountElsewhere ().first);
+
+    database->endBulkWrite ();
+
+    EXPECT_EQ(3, readNonEmptyBlocksCountElsewhere ().first);
+}
+
+TEST_F(BlockchainBatchTest, writesFromOtherThreadsWaitForTheBulkCommit)
+{
+    database->beginBulkWrite ();
+
+    BlockchainWriteBatch own;
+    own.insertNonEmptyBlockIndexes ({1}, 1);
+    write (own);
+
+    const size_t bulkSize = database->getBulkWriteSize ();
+
+    std::thread writer ([this]()
+                        {
+                            BlockchainWriteBatch batch;
+                            batch.insertNonEmptyBlockIndexes ({7}, 2);
+                            write (batch);
+                        });
+
+    /*!
+        the other writer may not join the bulk transaction
+    */
+    std::this_thread::sleep_for (std::chrono::milliseconds (50));
+    EXPECT_EQ(bulkSize, database->getBulkWriteSize ());
+    EXPECT_EQ(1, readNonEmptyBlocksCount ().first);
+
+    database->endBulkWrite ();
+    writer.join ();
+
+    BlockchainReadBatch batch;
+    batch.requestNonEmptyBlocksCount ();
+    batch.requestNonEmptyBlockIndex (0);
+    batch.requestNonEmptyBlockIndex (1);
+
+    const BlockchainReadResult result = read (batch);
+
+    EXPECT_EQ(2, result.getNonEmptyBlocksCount ().first);
+    EXPECT_EQ(1, result.getNonEmptyBlockIndexes ().at (0));
+    EXPECT_EQ(7, result.getNonEmptyBlockIndexes ().at (1));
+}
+
+TEST_F(BlockchainBatchTest, shutdownDiscardsAnUnfinishedBulkWrite)
+{
+    BlockchainWriteBatch committed;
+    committed.insertNonEmptyBlockIndexes ({1}, 1);
+    write (committed);
+
+    database->beginBulkWrite ();
+
+    BlockchainWriteBatch pending;
+    pending.insertNonEmptyBlockIndexes ({2}, 2);
+    write (pending);
+
+    reopen ();
+
+    EXPECT_EQ(1, readNonEmptyBlocksCount ().first);
+}
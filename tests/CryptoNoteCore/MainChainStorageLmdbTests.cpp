@@ -0,0 +1,245 @@
+// Copyright (c) 2018-2020, The Qwertycoin Project
+//
+// This file is part of Qwertycoin.
+//
+// Qwertycoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Qwertycoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Qwertycoin.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <lmdb/lmdbpp.h>
+
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+
+#include <gtest/gtest.h>
+
+#include <Common/CryptoNoteTools.h>
+#include <Common/FileSystemShim.h>
+
+#include <CryptoNoteCore/Blockchain/MainChainStorageLmdb.h>
+
+#include <Global/LMDBConfig.h>
+
+using namespace CryptoNote;
+
+namespace {
+
+    RawBlock makeBlock(uint32_t index)
+    {
+        RawBlock rawBlock;
+        rawBlock.block.assign (32 + index % 7, static_cast<uint8_t>(index));
+        for (uint32_t i = 0; i < index % 3; ++i) {
+            rawBlock.transactions.emplace_back (16 + i, static_cast<uint8_t>(index + i));
+        }
+
+        return rawBlock;
+    }
+
+    void expectSameBlock(const RawBlock &expected, const RawBlock &actual)
+    {
+        EXPECT_EQ(expected.block, actual.block);
+        EXPECT_EQ(expected.transactions, actual.transactions);
+    }
+
+    std::string legacyValue(const RawBlock &rawBlock)
+    {
+        rapidjson::StringBuffer buffer;
+        rapidjson::Writer<rapidjson::StringBuffer> writer (buffer);
+        rawBlock.toJSON (writer);
+
+        return buffer.GetString ();
+    }
+
+    /*!
+        writes blocks the way storages from before the binary format did, the
+        first migratedCount of them already moved over by an interrupted migration
+    */
+    void writeLegacyStorage(const std::string &path, uint32_t blockCount, uint32_t migratedCount)
+    {
+        auto env = lmdb::env::create ();
+        env.set_mapsize (LMDB::MAPSIZE_MIN_AVAIL);
+        env.set_max_dbs (1);
+        env.open (path.c_str (), MDB_NOSUBDIR, 0664);
+
+        auto txn = lmdb::txn::begin (env);
+        auto legacy = lmdb::dbi::open (txn, nullptr);
+
+        for (uint32_t index = 0; index < blockCount; ++index) {
+            if (index < migratedCount) {
+                auto blocks = lmdb::dbi::open (txn, "blocks", MDB_CREATE);
+                std::string key (4, '\0');
+                for (size_t i = 0; i < 4; ++i) {
+                    key[i] = static_cast<char>((index >> (8 * (3 - i))) & 0xff);
+                }
+
+                const BinaryArray value = toBinaryArray (makeBlock (index));
+                blocks.put (txn, key, std::string (value.begin (), value.end ()));
+            } else {
+                legacy.put (txn, std::to_string (index), legacyValue (makeBlock (index)));
+            }
+        }
+
+        txn.commit ();
+    }
+
+    bool hasLegacyEntries(const std::string &path)
+    {
+        auto env = lmdb::env::create ();
+        env.set_max_dbs (1);
+        env.open (path.c_str (), MDB_NOSUBDIR | MDB_RDONLY, 0664);
+
+        auto txn = lmdb::txn::begin (env, nullptr, MDB_RDONLY);
+        auto legacy = lmdb::dbi::open (txn, nullptr);
+
+        /*!
+            the named database itself is the one entry left in the unnamed one
+        */
+        return legacy.size (txn) > 1;
+    }
+
+    class MainChainStorageLmdbTest: public ::testing::Test
+    {
+    protected:
+        void SetUp() override
+        {
+            directory = fs::path (testing::TempDir ()) / fs::unique_path ();
+            fs::create_directories (directory);
+            path = (directory / "blocks.db").string ();
+        }
+
+        void TearDown() override
+        {
+            fs::remove_all (directory);
+        }
+
+        std::unique_ptr<MainChainStorageLmdb> open()
+        {
+            return std::make_unique<MainChainStorageLmdb> (path, (directory / "indexes.db").string ());
+        }
+
+        fs::path directory;
+        std::string path;
+    };
+
+} // namespace
+
+TEST_F(MainChainStorageLmdbTest, pushedBlocksAreReadBackAfterReopening)
+{
+    const uint32_t blockCount = 2500;
+
+    {
+        auto storage = open ();
+        for (uint32_t index = 0; index < blockCount; ++index) {
+            storage->pushBlock (makeBlock (index));
+        }
+
+        ASSERT_EQ(blockCount, storage->getBlockCount ());
+        expectSameBlock (makeBlock (1234), storage->getBlockByIndex (1234));
+        expectSameBlock (makeBlock (blockCount - 1), storage->getBlockByIndex (blockCount - 1));
+    }
+
+    auto storage = open ();
+    ASSERT_EQ(blockCount, storage->getBlockCount ());
+    for (uint32_t index : {0u, 1u, 999u, 1000u, 1001u, blockCount - 1}) {
+        expectSameBlock (makeBlock (index), storage->getBlockByIndex (index));
+    }
+    EXPECT_ANY_THROW(storage->getBlockByIndex (blockCount));
+}
+
+TEST_F(MainChainStorageLmdbTest, popBlockRemovesTheTopBlock)
+{
+    auto storage = open ();
+    for (uint32_t index = 0; index < 10; ++index) {
+        storage->pushBlock (makeBlock (index));
+    }
+
+    storage->popBlock ();
+    storage->popBlock ();
+
+    ASSERT_EQ(8, storage->getBlockCount ());
+    EXPECT_ANY_THROW(storage->getBlockByIndex (8));
+
+    storage->pushBlock (makeBlock (100));
+    expectSameBlock (makeBlock (100), storage->getBlockByIndex (8));
+
+    storage.reset ();
+    EXPECT_EQ(9, open ()->getBlockCount ());
+}
+
+TEST_F(MainChainStorageLmdbTest, forEachBlockScansInHeightOrderFromTheStartIndex)
+{
+    auto storage = open ();
+
+    /*!
+        past 255 and 65535 a little endian or decimal key would sort out of height order
+    */
+    const uint32_t blockCount = 70000;
+    for (uint32_t index = 0; index < blockCount; ++index) {
+        storage->pushBlock (makeBlock (index));
+    }
+
+    uint32_t expectedIndex = 250;
+    storage->forEachBlock (250, [&expectedIndex](uint32_t index, RawBlock &&rawBlock)
+    {
+        ASSERT_EQ(expectedIndex, index);
+        expectSameBlock (makeBlock (index), rawBlock);
+        ++expectedIndex;
+    });
+
+    EXPECT_EQ(blockCount, expectedIndex);
+}
+
+TEST_F(MainChainStorageLmdbTest, legacyStorageIsMigratedOnOpen)
+{
+    const uint32_t blockCount = 2345;
+    writeLegacyStorage (path, blockCount, 0);
+
+    {
+        auto storage = open ();
+        ASSERT_EQ(blockCount, storage->getBlockCount ());
+        for (uint32_t index : {0u, 999u, 1000u, blockCount - 1}) {
+            expectSameBlock (makeBlock (index), storage->getBlockByIndex (index));
+        }
+
+        storage->pushBlock (makeBlock (blockCount));
+        expectSameBlock (makeBlock (blockCount), storage->getBlockByIndex (blockCount));
+    }
+
+    EXPECT_FALSE(hasLegacyEntries (path));
+    EXPECT_EQ(blockCount + 1, open ()->getBlockCount ());
+}
+
+TEST_F(MainChainStorageLmdbTest, interruptedMigrationResumes)
+{
+    const uint32_t blockCount = 1500;
+    writeLegacyStorage (path, blockCount, 1000);
+
+    auto storage = open ();
+    ASSERT_EQ(blockCount, storage->getBlockCount ());
+
+    uint32_t expectedIndex = 0;
+    storage->forEachBlock (0, [&expectedIndex](uint32_t index, RawBlock &&rawBlock)
+    {
+        ASSERT_EQ(expectedIndex, index);
+        expectSameBlock (makeBlock (index), rawBlock);
+        ++expectedIndex;
+    });
+    EXPECT_EQ(blockCount, expectedIndex);
+
+    storage.reset ();
+    EXPECT_FALSE(hasLegacyEntries (path));
+}
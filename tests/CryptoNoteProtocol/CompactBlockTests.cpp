@@ -0,0 +1,155 @@
+// Copyright (c) 2018-2020, The Qwertycoin Project
+//
+// This file is part of Qwertycoin.
+//
+// Qwertycoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Qwertycoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Qwertycoin.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <Crypto/Hash.h>
+
+#include <CryptoNoteProtocol/CompactBlock.h>
+
+using namespace CryptoNote;
+
+namespace {
+
+    Crypto::Hash makeHash(uint64_t seed)
+    {
+        return Crypto::CnFastHash (&seed, sizeof (seed));
+    }
+
+    std::vector<Crypto::Hash> makeHashes(uint64_t firstSeed, size_t count)
+    {
+        std::vector<Crypto::Hash> hashes;
+        for (size_t i = 0; i < count; ++i) {
+            hashes.push_back (makeHash (firstSeed + i));
+        }
+
+        return hashes;
+    }
+
+    std::vector<uint64_t> getShortTransactionIds(const Crypto::Hash &key,
+                                                 const std::vector<Crypto::Hash> &transactionHashes)
+    {
+        std::vector<uint64_t> shortTxIds;
+        for (const auto &transactionHash : transactionHashes) {
+            shortTxIds.push_back (getShortTransactionId (key, transactionHash));
+        }
+
+        return shortTxIds;
+    }
+
+} // namespace
+
+TEST(CompactBlockTest, shortIdsFitTheirWireSizeAndDependOnTheNonce)
+{
+    const Crypto::Hash blockHash = makeHash (1);
+    const Crypto::Hash key = getCompactBlockKey (blockHash, 7);
+    const std::vector<Crypto::Hash> transactionHashes = makeHashes (100, 64);
+
+    const std::vector<uint64_t> shortTxIds = getShortTransactionIds (key, transactionHashes);
+    for (const auto shortId : shortTxIds) {
+        EXPECT_LT(shortId, uint64_t (1) << (8 * COMPACT_BLOCK_SHORT_ID_SIZE));
+    }
+
+    EXPECT_EQ(shortTxIds, getShortTransactionIds (getCompactBlockKey (blockHash, 7), transactionHashes));
+    EXPECT_NE(shortTxIds, getShortTransactionIds (getCompactBlockKey (blockHash, 8), transactionHashes));
+    EXPECT_NE(shortTxIds, getShortTransactionIds (getCompactBlockKey (makeHash (2), 7), transactionHashes));
+}
+
+TEST(CompactBlockTest, packedShortIdsRoundTrip)
+{
+    const std::vector<uint64_t> shortTxIds = {0, 1, 0xffffffffffff, 0x0102030405, 0xa1b2c3d4e5f6};
+
+    const std::string packed = packShortTransactionIds (shortTxIds);
+    ASSERT_EQ(shortTxIds.size () * COMPACT_BLOCK_SHORT_ID_SIZE, packed.size ());
+
+    /*!
+        little endian
+    */
+    EXPECT_EQ('\x05', packed[3 * COMPACT_BLOCK_SHORT_ID_SIZE]);
+    EXPECT_EQ('\x00', packed[4 * COMPACT_BLOCK_SHORT_ID_SIZE - 1]);
+
+    std::vector<uint64_t> unpacked;
+    ASSERT_TRUE(unpackShortTransactionIds (packed, unpacked));
+    EXPECT_EQ(shortTxIds, unpacked);
+
+    ASSERT_TRUE(unpackShortTransactionIds (std::string (), unpacked));
+    EXPECT_TRUE(unpacked.empty ());
+}
+
+TEST(CompactBlockTest, packedShortIdsOfAnOddLengthAreRejected)
+{
+    std::vector<uint64_t> unpacked;
+    EXPECT_FALSE(unpackShortTransactionIds (std::string (COMPACT_BLOCK_SHORT_ID_SIZE + 1, '\x01'), unpacked));
+    EXPECT_FALSE(unpackShortTransactionIds (std::string (COMPACT_BLOCK_SHORT_ID_SIZE - 1, '\x01'), unpacked));
+}
+
+TEST(CompactBlockTest, blockTransactionsAreResolvedFromThePoolInBlockOrder)
+{
+    const std::vector<Crypto::Hash> pool = makeHashes (1000, 200);
+    const std::vector<Crypto::Hash> blockTransactions = {pool[150], pool[3], pool[77], pool[199], pool[0]};
+
+    const Crypto::Hash key = getCompactBlockKey (makeHash (5), 42);
+
+    std::vector<Crypto::Hash> resolved;
+    ASSERT_TRUE(resolveShortTransactionIds (key, pool, getShortTransactionIds (key, blockTransactions), resolved));
+    EXPECT_EQ(blockTransactions, resolved);
+
+    resolved.clear ();
+    ASSERT_TRUE(resolveShortTransactionIds (key, pool, {}, resolved));
+    EXPECT_TRUE(resolved.empty ());
+}
+
+TEST(CompactBlockTest, transactionMissingFromThePoolFailsTheResolution)
+{
+    const std::vector<Crypto::Hash> pool = makeHashes (1000, 50);
+    std::vector<Crypto::Hash> blockTransactions = {pool[1], makeHash (5000), pool[2]};
+
+    const Crypto::Hash key = getCompactBlockKey (makeHash (5), 42);
+
+    std::vector<Crypto::Hash> resolved;
+    EXPECT_FALSE(resolveShortTransactionIds (key, pool, getShortTransactionIds (key, blockTransactions), resolved));
+
+    /*!
+        short ids made with another nonce match nothing
+    */
+    blockTransactions = {pool[1], pool[2]};
+    EXPECT_FALSE(resolveShortTransactionIds (key,
+                                             pool,
+                                             getShortTransactionIds (getCompactBlockKey (makeHash (5), 43),
+                                                                     blockTransactions),
+                                             resolved));
+}
+
+TEST(CompactBlockTest, shortIdSharedByTwoPoolTransactionsIsNotResolved)
+{
+    std::vector<Crypto::Hash> pool = makeHashes (1000, 20);
+    const Crypto::Hash key = getCompactBlockKey (makeHash (5), 42);
+
+    /*!
+        a 48 bit collision is out of reach here, a repeated pool entry maps to the same id
+    */
+    pool.push_back (pool[4]);
+
+    std::vector<Crypto::Hash> resolved;
+    EXPECT_FALSE(resolveShortTransactionIds (key, pool, getShortTransactionIds (key, {pool[4]}), resolved));
+    EXPECT_TRUE(resolveShortTransactionIds (key, pool, getShortTransactionIds (key, {pool[5]}), resolved));
+}
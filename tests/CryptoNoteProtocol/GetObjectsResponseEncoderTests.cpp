@@ -0,0 +1,133 @@
+// Copyright (c) 2018-2020, The Qwertycoin Project
+//
+// This file is part of Qwertycoin.
+//
+// Qwertycoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Qwertycoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Qwertycoin.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <CryptoNoteProtocol/CryptoNoteProtocolDefinitions.h>
+#include <CryptoNoteProtocol/GetObjectsResponseEncoder.h>
+
+#include <Serialization/SerializationOverloads.h>
+#include <Serialization/SerializationTools.h>
+
+using namespace CryptoNote;
+
+namespace CryptoNote {
+
+    /*!
+        the layout CryptoNoteProtocolHandler serializes the response with
+    */
+    void serialize(RawBlockLegacy &rawBlock, ISerializer &s)
+    {
+        std::string block (rawBlock.blockTemplate.begin (), rawBlock.blockTemplate.end ());
+        std::vector<std::string> transactions;
+        for (const auto &transaction : rawBlock.transactions) {
+            transactions.emplace_back (transaction.begin (), transaction.end ());
+        }
+
+        s (block, "block");
+        s (transactions, "txs");
+    }
+
+    void serialize(NOTIFY_RESPONSE_GET_OBJECTS_request &request, ISerializer &s)
+    {
+        s (request.txs, "txs");
+        s (request.blocks, "blocks");
+        serializeAsBinary (request.missed_ids, "missed_ids", s);
+        s (request.current_blockchain_height, "current_blockchain_height");
+    }
+
+} // namespace CryptoNote
+
+namespace {
+
+    BinaryArray randomBlob(std::mt19937 &generator, size_t maxSize)
+    {
+        BinaryArray blob (generator () % maxSize + 1);
+        for (auto &byte : blob) {
+            byte = static_cast<uint8_t>(generator ());
+        }
+
+        return blob;
+    }
+
+    void expectSameAsSerializer(const std::vector<RawBlock> &rawBlocks,
+                                const std::vector<Crypto::Hash> &missedIds,
+                                uint32_t height)
+    {
+        NOTIFY_RESPONSE_GET_OBJECTS_request request;
+        for (const auto &rawBlock : rawBlocks) {
+            request.blocks.push_back ({rawBlock.block, rawBlock.transactions});
+        }
+        request.missed_ids = missedIds;
+        request.current_blockchain_height = height;
+
+        const BinaryArray encoded = encodeGetObjectsResponse (rawBlocks, missedIds, height);
+
+        ASSERT_EQ(storeToBinaryKeyValue (request), std::string (encoded.begin (), encoded.end ()));
+    }
+
+} // namespace
+
+TEST(GetObjectsResponseEncoderTest, emptyResponseMatchesSerializer)
+{
+    expectSameAsSerializer ({}, {}, 0);
+}
+
+TEST(GetObjectsResponseEncoderTest, blocksWithoutTransactionsMatchSerializer)
+{
+    std::mt19937 generator (1);
+
+    std::vector<RawBlock> rawBlocks (3);
+    for (auto &rawBlock : rawBlocks) {
+        rawBlock.block = randomBlob (generator, 200);
+    }
+
+    expectSameAsSerializer (rawBlocks, {}, 12345);
+}
+
+/*!
+    sizes cross every varint width of the portable storage format but the 8 byte one
+*/
+TEST(GetObjectsResponseEncoderTest, randomResponsesMatchSerializer)
+{
+    std::mt19937 generator (2);
+
+    for (int round = 0; round < 100; ++round) {
+        std::vector<RawBlock> rawBlocks (generator () % 70);
+        for (auto &rawBlock : rawBlocks) {
+            rawBlock.block = randomBlob (generator, round % 10 == 0 ? 20000 : 300);
+            rawBlock.transactions.resize (generator () % 4);
+            for (auto &transaction : rawBlock.transactions) {
+                transaction = randomBlob (generator, 2000);
+            }
+        }
+
+        std::vector<Crypto::Hash> missedIds (generator () % 3);
+        for (auto &hash : missedIds) {
+            for (auto &byte : hash.data) {
+                byte = static_cast<uint8_t>(generator ());
+            }
+        }
+
+        expectSameAsSerializer (rawBlocks, missedIds, static_cast<uint32_t>(generator ()));
+    }
+}
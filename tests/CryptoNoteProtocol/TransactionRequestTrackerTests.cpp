@@ -0,0 +1,189 @@
+// Copyright (c) 2018-2020, The Qwertycoin Project
+//
+// This file is part of Qwertycoin.
+//
+// Qwertycoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Qwertycoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Qwertycoin.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <cstdint>
+#include <vector>
+
+#include <boost/uuid/uuid.hpp>
+
+#include <gtest/gtest.h>
+
+#include <Crypto/Hash.h>
+
+#include <CryptoNoteProtocol/TransactionRequestTracker.h>
+
+using namespace CryptoNote;
+
+namespace {
+
+    const time_t REQUEST_TIMEOUT = 30;
+    const size_t ANNOUNCERS_LIMIT = 3;
+
+    Crypto::Hash makeHash(uint64_t seed)
+    {
+        return Crypto::CnFastHash (&seed, sizeof (seed));
+    }
+
+    boost::uuids::uuid makePeer(uint8_t id)
+    {
+        boost::uuids::uuid peer{};
+        peer.data[0] = id;
+        return peer;
+    }
+
+    class TransactionRequestTrackerTest : public testing::Test
+    {
+    protected:
+        TransactionRequestTrackerTest()
+            : tracker (REQUEST_TIMEOUT, ANNOUNCERS_LIMIT),
+              hash (makeHash (1))
+        {
+        }
+
+        /*!
+            announces the hash from the peer and requests it when it isn't tracked
+            yet, the way the protocol handler does
+        */
+        void announce(const boost::uuids::uuid &peer, time_t now)
+        {
+            if (tracker.onAnnounced (hash, peer)) {
+                tracker.onRequested (hash, peer, now);
+            }
+        }
+
+        TransactionRequestTracker tracker;
+        Crypto::Hash hash;
+    };
+
+} // namespace
+
+TEST_F(TransactionRequestTrackerTest, unknownTransactionIsRequestedFromItsFirstAnnouncer)
+{
+    EXPECT_TRUE(tracker.onAnnounced (hash, makePeer (1)));
+    tracker.onRequested (hash, makePeer (1), 100);
+
+    EXPECT_FALSE(tracker.onAnnounced (hash, makePeer (2)));
+    EXPECT_EQ(1, tracker.size ());
+}
+
+TEST_F(TransactionRequestTrackerTest, nothingIsRerequestedBeforeTheTimeout)
+{
+    announce (makePeer (1), 100);
+    announce (makePeer (2), 101);
+
+    EXPECT_TRUE(tracker.takeRerequests (100 + REQUEST_TIMEOUT).empty ());
+    EXPECT_EQ(1, tracker.size ());
+}
+
+TEST_F(TransactionRequestTrackerTest, timedOutRequestMovesToTheNextAnnouncer)
+{
+    announce (makePeer (1), 100);
+    announce (makePeer (2), 101);
+    announce (makePeer (3), 102);
+
+    auto rerequests = tracker.takeRerequests (100 + REQUEST_TIMEOUT + 1);
+    ASSERT_EQ(1, rerequests.size ());
+    EXPECT_EQ(makePeer (2), rerequests.begin ()->first);
+    EXPECT_EQ(std::vector<Crypto::Hash>{hash}, rerequests.begin ()->second);
+
+    EXPECT_TRUE(tracker.takeRerequests (100 + 2 * REQUEST_TIMEOUT + 1).empty ());
+
+    rerequests = tracker.takeRerequests (100 + 2 * REQUEST_TIMEOUT + 2);
+    ASSERT_EQ(1, rerequests.size ());
+    EXPECT_EQ(makePeer (3), rerequests.begin ()->first);
+}
+
+TEST_F(TransactionRequestTrackerTest, requestWithoutFurtherAnnouncersIsDropped)
+{
+    announce (makePeer (1), 100);
+
+    EXPECT_TRUE(tracker.takeRerequests (100 + REQUEST_TIMEOUT + 1).empty ());
+    EXPECT_EQ(0, tracker.size ());
+    EXPECT_TRUE(tracker.onAnnounced (hash, makePeer (2)));
+}
+
+TEST_F(TransactionRequestTrackerTest, receivedTransactionIsNoLongerTracked)
+{
+    announce (makePeer (1), 100);
+    announce (makePeer (2), 101);
+
+    tracker.onReceived (hash);
+
+    EXPECT_EQ(0, tracker.size ());
+    EXPECT_TRUE(tracker.takeRerequests (100 + REQUEST_TIMEOUT + 1).empty ());
+}
+
+TEST_F(TransactionRequestTrackerTest, disconnectedPeerIsReplacedOnTheNextTick)
+{
+    announce (makePeer (1), 100);
+    announce (makePeer (2), 101);
+
+    tracker.onPeerDisconnected (makePeer (1));
+
+    auto rerequests = tracker.takeRerequests (102);
+    ASSERT_EQ(1, rerequests.size ());
+    EXPECT_EQ(makePeer (2), rerequests.begin ()->first);
+}
+
+TEST_F(TransactionRequestTrackerTest, disconnectedAnnouncerIsNotAskedNext)
+{
+    announce (makePeer (1), 100);
+    announce (makePeer (2), 101);
+    announce (makePeer (3), 102);
+
+    tracker.onPeerDisconnected (makePeer (2));
+
+    auto rerequests = tracker.takeRerequests (100 + REQUEST_TIMEOUT + 1);
+    ASSERT_EQ(1, rerequests.size ());
+    EXPECT_EQ(makePeer (3), rerequests.begin ()->first);
+}
+
+TEST_F(TransactionRequestTrackerTest, announcersAreDeduplicatedAndLimited)
+{
+    announce (makePeer (1), 100);
+    announce (makePeer (1), 100);
+    announce (makePeer (2), 100);
+    announce (makePeer (2), 100);
+    for (uint8_t peer = 3; peer < 10; ++peer) {
+        announce (makePeer (peer), 100);
+    }
+
+    std::vector<boost::uuids::uuid> askedPeers;
+    for (time_t now = 100 + REQUEST_TIMEOUT + 1; tracker.size () != 0; now += REQUEST_TIMEOUT + 1) {
+        for (const auto &rerequest : tracker.takeRerequests (now)) {
+            askedPeers.push_back (rerequest.first);
+        }
+    }
+
+    std::vector<boost::uuids::uuid> expected{makePeer (2), makePeer (3), makePeer (4)};
+    EXPECT_EQ(expected, askedPeers);
+}
+
+TEST_F(TransactionRequestTrackerTest, rerequestsAreGroupedByPeer)
+{
+    const Crypto::Hash otherHash = makeHash (2);
+    for (const auto &transactionHash : {hash, otherHash}) {
+        ASSERT_TRUE(tracker.onAnnounced (transactionHash, makePeer (1)));
+        tracker.onRequested (transactionHash, makePeer (1), 100);
+        ASSERT_FALSE(tracker.onAnnounced (transactionHash, makePeer (2)));
+    }
+
+    auto rerequests = tracker.takeRerequests (100 + REQUEST_TIMEOUT + 1);
+    ASSERT_EQ(1, rerequests.size ());
+    EXPECT_EQ(2, rerequests[makePeer (2)].size ());
+}
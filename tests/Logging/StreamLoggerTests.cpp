@@ -0,0 +1,264 @@
+// Copyright (c) 2018-2020, The Qwertycoin Project
+//
+// This file is part of Qwertycoin.
+//
+// Qwertycoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Qwertycoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Qwertycoin.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <future>
+#include <iterator>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include <gtest/gtest.h>
+
+#include <Logging/StreamLogger.h>
+
+using namespace Logging;
+
+namespace {
+
+    void log(StreamLogger &logger, Level level, const std::string &text)
+    {
+        logger ("test", level, boost::posix_time::microsec_clock::local_time (), text + "\n");
+    }
+
+    std::vector<std::string> lines(const std::string &text)
+    {
+        std::vector<std::string> result;
+        std::istringstream stream (text);
+        for (std::string line; std::getline (stream, line);) {
+            result.push_back (line);
+        }
+
+        return result;
+    }
+
+    template<typename Predicate>
+    bool waitFor(Predicate predicate, std::chrono::milliseconds timeout)
+    {
+        const auto deadline = std::chrono::steady_clock::now () + timeout;
+        while (!predicate ()) {
+            if (std::chrono::steady_clock::now () >= deadline) {
+                return false;
+            }
+            std::this_thread::sleep_for (std::chrono::milliseconds (5));
+        }
+
+        return true;
+    }
+
+    /*!
+        counts flushes of the stream
+    */
+    class SyncCountingBuffer: public std::stringbuf
+    {
+    public:
+        std::atomic<int> syncs {0};
+
+    protected:
+        int sync() override
+        {
+            ++syncs;
+            return std::stringbuf::sync ();
+        }
+    };
+
+    /*!
+        holds the writer thread in its first write until opened
+    */
+    class GateBuffer: public std::stringbuf
+    {
+    public:
+        GateBuffer()
+            : opened (gate.get_future ().share ())
+        {
+        }
+
+        std::promise<void> entered;
+        std::promise<void> gate;
+
+    protected:
+        std::streamsize xsputn(const char *s, std::streamsize n) override
+        {
+            if (first) {
+                first = false;
+                entered.set_value ();
+                opened.wait ();
+            }
+
+            return std::stringbuf::xsputn (s, n);
+        }
+
+    private:
+        std::shared_future<void> opened;
+        bool first = true;
+    };
+
+} // namespace
+
+TEST(StreamLoggerTest, destructorWritesOutEverythingQueued)
+{
+    std::ostringstream stream;
+    std::vector<std::string> expected;
+
+    {
+        StreamLogger logger (stream);
+        logger.setPattern ("");
+
+        for (int i = 0; i < 1000; ++i) {
+            expected.push_back ("message " + std::to_string (i));
+            log (logger, INFO, expected.back ());
+        }
+    }
+
+    EXPECT_EQ(expected, lines (stream.str ()));
+}
+
+TEST(StreamLoggerTest, loggerWithoutMessagesStopsCleanly)
+{
+    std::ostringstream stream;
+
+    {
+        StreamLogger logger (stream);
+    }
+
+    EXPECT_TRUE(stream.str ().empty ());
+}
+
+TEST(StreamLoggerTest, errorsAreFlushedBeforeTheFlushInterval)
+{
+    SyncCountingBuffer buffer;
+    std::ostream stream (&buffer);
+
+    StreamLogger logger (stream);
+    logger.setPattern ("");
+
+    log (logger, INFO, "warming up");
+    ASSERT_TRUE(waitFor ([&buffer] { return !buffer.str ().empty (); }, std::chrono::milliseconds (2000)));
+    const int syncs = buffer.syncs;
+
+    log (logger, ERROR, "failure");
+
+    EXPECT_TRUE(waitFor ([&buffer, syncs]
+                         {
+                             return buffer.syncs > syncs && buffer.str ().find ("failure") != std::string::npos;
+                         },
+                         std::chrono::milliseconds (500)));
+}
+
+TEST(StreamLoggerTest, messagesDroppedOnAFullQueueAreReported)
+{
+    const int messageCount = 20000;
+
+    GateBuffer buffer;
+    std::ostream stream (&buffer);
+
+    {
+        StreamLogger logger (stream);
+        logger.setPattern ("");
+
+        log (logger, ERROR, "first");
+        ASSERT_EQ(std::future_status::ready, buffer.entered.get_future ().wait_for (std::chrono::seconds (5)));
+
+        for (int i = 1; i < messageCount; ++i) {
+            log (logger, INFO, "message");
+        }
+
+        buffer.gate.set_value ();
+    }
+
+    const auto written = lines (buffer.str ());
+    ASSERT_FALSE(written.empty ());
+
+    uint64_t dropped = 0;
+    size_t messages = 0;
+    for (const auto &line : written) {
+        if (line.find (" log messages dropped") != std::string::npos) {
+            dropped += std::stoull (line);
+        } else {
+            ++messages;
+        }
+    }
+
+    EXPECT_GT(dropped, 0);
+    EXPECT_EQ(static_cast<uint64_t>(messageCount), messages + dropped);
+}
+
+#ifndef _WIN32
+
+TEST(StreamLoggerTest, forkedChildWritesItsOwnMessagesOnce)
+{
+    const std::string path = testing::TempDir () + "stream_logger_fork_test.log";
+    std::ofstream file (path, std::ios::trunc);
+
+    auto readFile = [&path]
+    {
+        std::ifstream input (path);
+        return std::string (std::istreambuf_iterator<char> (input), std::istreambuf_iterator<char> ());
+    };
+
+    auto logger = std::make_unique<StreamLogger> (file);
+    logger->setPattern ("");
+
+    /*!
+        an error is flushed right away, so the child doesn't inherit it in the
+        buffer of the stream
+    */
+    log (*logger, ERROR, "parent before fork");
+    ASSERT_TRUE(waitFor ([&readFile] { return !readFile ().empty (); }, std::chrono::milliseconds (2000)));
+
+    const pid_t pid = fork ();
+    ASSERT_NE(-1, pid);
+
+    if (pid == 0) {
+        log (*logger, INFO, "child");
+        logger.reset ();
+        file.close ();
+        _exit (0);
+    }
+
+    int status = 0;
+    ASSERT_EQ(pid, waitpid (pid, &status, 0));
+    EXPECT_TRUE(WIFEXITED (status));
+    EXPECT_EQ(0, WEXITSTATUS (status));
+
+    log (*logger, INFO, "parent after fork");
+    logger.reset ();
+    file.close ();
+
+    auto written = lines (readFile ());
+    std::sort (written.begin (), written.end ());
+
+    EXPECT_EQ((std::vector<std::string> {"child", "parent after fork", "parent before fork"}), written);
+
+    std::remove (path.c_str ());
+}
+
+#endif
@@ -0,0 +1,110 @@
+// Copyright (c) 2018-2020, The Qwertycoin Project
+//
+// This file is part of Qwertycoin.
+//
+// Qwertycoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Qwertycoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Qwertycoin.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <cstdint>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <Crypto/Hash.h>
+
+#include <P2p/RollingInventoryFilter.h>
+
+using namespace CryptoNote;
+
+namespace {
+
+    const size_t GENERATION_SIZE = 64;
+
+    std::vector<Crypto::Hash> makeHashes(uint64_t firstSeed, size_t count)
+    {
+        std::vector<Crypto::Hash> hashes;
+        for (uint64_t seed = firstSeed; seed < firstSeed + count; ++seed) {
+            hashes.push_back (Crypto::CnFastHash (&seed, sizeof (seed)));
+        }
+
+        return hashes;
+    }
+
+} // namespace
+
+TEST(RollingInventoryFilter, insertedHashesAreContained)
+{
+    RollingInventoryFilter filter (GENERATION_SIZE);
+    const auto hashes = makeHashes (0, GENERATION_SIZE);
+    for (const auto &hash : hashes) {
+        EXPECT_FALSE(filter.contains (hash));
+        filter.insert (hash);
+        EXPECT_TRUE(filter.contains (hash));
+    }
+
+    for (const auto &hash : makeHashes (GENERATION_SIZE, GENERATION_SIZE)) {
+        EXPECT_FALSE(filter.contains (hash));
+    }
+}
+
+TEST(RollingInventoryFilter, lastGenerationSizeHashesAreAlwaysRemembered)
+{
+    RollingInventoryFilter filter (GENERATION_SIZE);
+    const auto hashes = makeHashes (0, 5 * GENERATION_SIZE);
+    for (size_t i = 0; i < hashes.size (); ++i) {
+        filter.insert (hashes[i]);
+        for (size_t j = i + 1 > GENERATION_SIZE ? i + 1 - GENERATION_SIZE : 0; j <= i; ++j) {
+            ASSERT_TRUE(filter.contains (hashes[j])) << "inserted " << i << ", lost " << j;
+        }
+    }
+}
+
+TEST(RollingInventoryFilter, hashesAreForgottenAfterTwoGenerations)
+{
+    RollingInventoryFilter filter (GENERATION_SIZE);
+    const auto old = makeHashes (0, GENERATION_SIZE);
+    for (const auto &hash : old) {
+        filter.insert (hash);
+    }
+
+    for (const auto &hash : makeHashes (GENERATION_SIZE, 2 * GENERATION_SIZE)) {
+        filter.insert (hash);
+    }
+
+    for (const auto &hash : old) {
+        EXPECT_FALSE(filter.contains (hash));
+    }
+}
+
+TEST(RollingInventoryFilter, reinsertingAContainedHashDoesNotAgeTheFilter)
+{
+    RollingInventoryFilter filter (GENERATION_SIZE);
+    const auto hashes = makeHashes (0, GENERATION_SIZE);
+    for (const auto &hash : hashes) {
+        filter.insert (hash);
+    }
+
+    for (size_t i = 0; i < 10 * GENERATION_SIZE; ++i) {
+        filter.insert (hashes[i % hashes.size ()]);
+    }
+
+    const auto newer = makeHashes (GENERATION_SIZE, GENERATION_SIZE);
+    for (const auto &hash : newer) {
+        filter.insert (hash);
+    }
+
+    for (const auto &hash : hashes) {
+        EXPECT_TRUE(filter.contains (hash));
+    }
+}